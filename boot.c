@@ -0,0 +1,177 @@
+#include "boot.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+static const char* TAG = "boot";
+
+typedef struct {
+    const boot_stage_t* stage;
+    int index;
+    int64_t start_us;       // dependencies done, stage started
+    int64_t end_us;
+    esp_err_t result;
+    bool skipped;
+} stage_run_t;
+
+// Written by each stage task before it sets its done bit, read by the
+// others only after waiting for that bit
+static struct {
+    stage_run_t runs[BOOT_MAX_STAGES];
+    EventGroupHandle_t done;
+    int64_t start_us;
+} boot;
+
+static bool failed(const stage_run_t* run) {
+    return run->skipped || (run->result != ESP_OK && !run->stage->optional);
+}
+
+static void stage_task(void* arg) {
+    stage_run_t* run = arg;
+    const boot_stage_t* stage = run->stage;
+
+    if (stage->deps) {
+        xEventGroupWaitBits(boot.done, stage->deps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    run->start_us = esp_timer_get_time();
+
+    for (int dep = 0; dep < run->index; dep++) {
+        if ((stage->deps & BOOT_DEP(dep)) && failed(&boot.runs[dep])) {
+            run->skipped = true;
+            run->result = ESP_ERR_INVALID_STATE;
+        }
+    }
+    if (!run->skipped) {
+        run->result = stage->run();
+    }
+
+    run->end_us = esp_timer_get_time();
+    xEventGroupSetBits(boot.done, BOOT_DEP(run->index));
+    vTaskDelete(NULL);
+}
+
+static float ms_since_start(int64_t time_us) {
+    return (float)(time_us - boot.start_us) / 1000.0f;
+}
+
+// Walk back from `index` through whichever dependency finished last,
+// which is what each stage was waiting for
+static void log_critical_path(int index) {
+    char path[128] = "";
+    size_t len = 0;
+
+    while (index >= 0) {
+        const stage_run_t* run = &boot.runs[index];
+        int written = snprintf(path + len, sizeof(path) - len, "%s%s",
+                               len ? " < " : "", run->stage->name);
+        if (written < 0 || (size_t)written >= sizeof(path) - len) {
+            break;
+        }
+        len += written;
+
+        int next = -1;
+        for (int dep = 0; dep < index; dep++) {
+            if ((run->stage->deps & BOOT_DEP(dep)) &&
+                (next < 0 || boot.runs[dep].end_us > boot.runs[next].end_us)) {
+                next = dep;
+            }
+        }
+        index = next;
+    }
+    ESP_LOGI(TAG, "Critical path: %s", path);
+}
+
+static void log_report(size_t count, int64_t end_us) {
+    int64_t busy_us = 0;
+
+    ESP_LOGI(TAG, "%-10s %4s %9s %9s  %s", "stage", "core", "start ms", "run ms", "result");
+    for (size_t i = 0; i < count; i++) {
+        const stage_run_t* run = &boot.runs[i];
+        char core[8];
+        if (run->stage->core == tskNO_AFFINITY) {
+            strcpy(core, "any");
+        } else {
+            snprintf(core, sizeof(core), "%d", (int)run->stage->core);
+        }
+        const char* result = run->skipped ? "skipped" : esp_err_to_name(run->result);
+        ESP_LOGI(TAG, "%-10s %4s %9.1f %9.1f  %s", run->stage->name, core,
+                 ms_since_start(run->start_us), (float)(run->end_us - run->start_us) / 1000.0f, result);
+        busy_us += run->end_us - run->start_us;
+    }
+
+    // Headline: the stage marked ready, else whichever finished last
+    int ready = -1;
+    for (size_t i = 0; i < count && ready < 0; i++) {
+        if (boot.runs[i].stage->ready) {
+            ready = i;
+        }
+    }
+    if (ready < 0) {
+        ready = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (boot.runs[i].end_us > boot.runs[ready].end_us) {
+                ready = i;
+            }
+        }
+    }
+    int64_t ready_us = boot.runs[ready].end_us;
+
+    log_critical_path(ready);
+    ESP_LOGI(TAG, "Ready in %.1f ms (%s done), %.1f ms after reset",
+             ms_since_start(ready_us), boot.runs[ready].stage->name, (float)ready_us / 1000.0f);
+    ESP_LOGI(TAG, "All stages done in %.1f ms (%.1f ms of stage time)",
+             ms_since_start(end_us), (float)busy_us / 1000.0f);
+}
+
+esp_err_t boot_run(const boot_stage_t* stages, size_t count) {
+    if (!stages || count == 0 || count > BOOT_MAX_STAGES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!stages[i].run || (stages[i].deps >> i) != 0) {
+            ESP_LOGE(TAG, "Stage %s depends on itself or a later stage", stages[i].name);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    // Never deleted: the last stage task can still be inside
+    // xEventGroupSetBits() when the wait below returns
+    if (!boot.done) {
+        boot.done = xEventGroupCreate();
+    }
+    if (!boot.done) {
+        return ESP_ERR_NO_MEM;
+    }
+    xEventGroupClearBits(boot.done, (EventBits_t)(BOOT_DEP(BOOT_MAX_STAGES) - 1));
+    memset(boot.runs, 0, sizeof(boot.runs));
+    boot.start_us = esp_timer_get_time();
+
+    for (size_t i = 0; i < count; i++) {
+        stage_run_t* run = &boot.runs[i];
+        run->stage = &stages[i];
+        run->index = i;
+        if (xTaskCreatePinnedToCore(stage_task, stages[i].name, BOOT_STAGE_STACK, run,
+                                    BOOT_STAGE_PRIORITY, NULL, stages[i].core) != pdPASS) {
+            // Counts as finished and failed, so its dependents skip
+            run->start_us = run->end_us = esp_timer_get_time();
+            run->result = ESP_ERR_NO_MEM;
+            xEventGroupSetBits(boot.done, BOOT_DEP(i));
+        }
+    }
+
+    EventBits_t all = (EventBits_t)(BOOT_DEP(count) - 1);
+    xEventGroupWaitBits(boot.done, all, pdFALSE, pdTRUE, portMAX_DELAY);
+    int64_t end_us = esp_timer_get_time();
+
+    log_report(count, end_us);
+
+    for (size_t i = 0; i < count; i++) {
+        if (failed(&boot.runs[i]) && !boot.runs[i].skipped) {
+            ESP_LOGE(TAG, "Stage %s failed: %s", stages[i].name, esp_err_to_name(boot.runs[i].result));
+            return boot.runs[i].result;
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// Boot sequencer: runs each init stage in its own task, pinned to the
+// stage's core, as soon as every stage it depends on has finished, so
+// independent bring-up (panel, touch controller, servo link, screens)
+// overlaps on both cores instead of queueing behind one another. After
+// the last stage it logs when each one became ready and how long it ran.
+// The headline time is the end of the stage marked `ready` (the first
+// usable screen), reported with the chain of stages that set it; stages
+// still running after it only add to the total.
+//
+// Dependencies may only point at earlier entries of the table, which
+// keeps the graph acyclic; the table order is otherwise only the order
+// of the report. A stage whose required dependency failed is skipped.
+
+#define BOOT_MAX_STAGES      16
+#define BOOT_STAGE_STACK     6144    // bytes, enough to build the screens
+#define BOOT_STAGE_PRIORITY  4
+
+#define BOOT_DEP(index) (1u << (index))
+
+typedef struct {
+    const char* name;
+    esp_err_t (*run)(void);
+    uint32_t deps;          // BOOT_DEP() of the stages that must finish first
+    BaseType_t core;        // 0, 1 or tskNO_AFFINITY
+    bool optional;          // a failure is reported, dependents still run
+    bool ready;             // the machine is usable once this one ends
+} boot_stage_t;
+
+// Run the stages and block until all have finished or been skipped.
+// Returns the error of the first required stage (in table order) that
+// failed, ESP_OK if none did.
+esp_err_t boot_run(const boot_stage_t* stages, size_t count);
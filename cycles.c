@@ -0,0 +1,236 @@
+#include "cycles.h"
+#include <math.h>
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "safety.h"
+#include "settings.h"
+
+static const char* TAG = "cycles";
+
+#define RUNNER_PRIORITY   4
+#define RUNNER_IDLE_BIT   (1 << 0)
+#define HANDBACK_WAIT_MS  (4 * PLANNER_PERIOD_MS)  // a stopped runner is idle within a period
+
+typedef enum {
+    RUNNER_IDLE,        // waiting for cycle_start()
+    RUNNER_RUNNING,     // feeding runner.cycle to the planner
+    RUNNER_STOPPING,    // cycle_stop() called, runner not back yet
+} runner_state_t;
+
+// The runner owns runner.cycle from cycle_start() until it goes back to
+// RUNNER_IDLE and sets RUNNER_IDLE_BIT. State changes happen under the
+// mutex, which also orders queueing against cycle_stop().
+static struct {
+    SemaphoreHandle_t mutex;
+    EventGroupHandle_t events;
+    TaskHandle_t task;
+    cycle_t cycle;
+    volatile runner_state_t state;
+} runner = {0};
+
+esp_err_t cycle_validate(const cycle_params_t* params) {
+    if (!params || params->feed <= 0.0f || params->dwell < 0.0f ||
+        params->depth <= params->r_plane) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (params->type != CYCLE_DRILL && params->peck <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!safety_is_position_valid(params->r_plane) || !safety_is_position_valid(params->depth)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+void cycle_begin(cycle_t* cycle, const cycle_params_t* params) {
+    memset(cycle, 0, sizeof(*cycle));
+    cycle->params = *params;
+    cycle->stage = CYCLE_STAGE_APPROACH;
+    cycle->depth = params->r_plane;
+
+    float travel = params->depth - params->r_plane;
+    if (params->type == CYCLE_DRILL || params->peck >= travel) {
+        cycle->pecks = 1;
+    } else {
+        cycle->pecks = (uint16_t)ceilf(travel / params->peck);
+    }
+}
+
+static planner_move_t rapid(float target) {
+    return (planner_move_t){ .target_mm = target, .speed_mm_s = settings_get()->max_speed };
+}
+
+size_t cycle_next(cycle_t* cycle, planner_move_t* moves) {
+    const cycle_params_t* p = &cycle->params;
+
+    if (cycle->stage == CYCLE_STAGE_APPROACH) {
+        moves[0] = rapid(p->r_plane);
+        cycle->stage = CYCLE_STAGE_CUT;
+        return 1;
+    }
+    if (cycle->stage != CYCLE_STAGE_CUT) {
+        return 0;
+    }
+
+    float next = p->type == CYCLE_DRILL ? p->depth : fminf(cycle->depth + p->peck, p->depth);
+    bool last = next >= p->depth;
+    size_t count = 0;
+
+    // Full retract: come back down at rapid to just above the last depth
+    if (p->type == CYCLE_PECK && cycle->peck > 0) {
+        moves[count++] = rapid(fmaxf(p->r_plane, cycle->depth - CYCLE_PECK_CLEARANCE));
+    }
+
+    moves[count++] = (planner_move_t){
+        .target_mm = next,
+        .speed_mm_s = p->feed,
+        .dwell_s = last ? p->dwell : 0.0f,
+        .adaptive = true,
+    };
+
+    if (last || p->type == CYCLE_PECK) {
+        moves[count++] = rapid(p->r_plane);
+    } else {
+        moves[count++] = rapid(fmaxf(p->r_plane, next - CYCLE_BACKOFF));
+    }
+
+    cycle->depth = next;
+    cycle->peck++;
+    if (last) {
+        cycle->stage = CYCLE_STAGE_DONE;
+    }
+    return count;
+}
+
+// Waits for planner room, then queues the group unless the cycle was
+// stopped meanwhile
+static bool queue_group(const planner_move_t* moves, size_t count) {
+    while (planner_queue_free() < count) {
+        if (runner.state != RUNNER_RUNNING || safety_get_status() != SAFETY_OK) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(PLANNER_PERIOD_MS));
+    }
+
+    xSemaphoreTake(runner.mutex, portMAX_DELAY);
+    esp_err_t err = runner.state == RUNNER_RUNNING ? planner_queue_moves(moves, count)
+                                                   : ESP_ERR_INVALID_STATE;
+    xSemaphoreGive(runner.mutex);
+
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Planner rejected cycle moves: %s", esp_err_to_name(err));
+    }
+    return err == ESP_OK;
+}
+
+static void runner_task(void* arg) {
+    planner_move_t moves[CYCLE_MAX_GROUP];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        size_t count;
+        while (runner.state == RUNNER_RUNNING && (count = cycle_next(&runner.cycle, moves)) > 0) {
+            if (!queue_group(moves, count)) {
+                break;
+            }
+        }
+
+        // The cycle is over once the last queued move has run
+        while (runner.state == RUNNER_RUNNING && !planner_is_idle() &&
+               safety_get_status() == SAFETY_OK) {
+            vTaskDelay(pdMS_TO_TICKS(PLANNER_PERIOD_MS));
+        }
+
+        xSemaphoreTake(runner.mutex, portMAX_DELAY);
+        runner.state = RUNNER_IDLE;
+        planner_release(PLANNER_OWNER_CYCLE);
+        xEventGroupSetBits(runner.events, RUNNER_IDLE_BIT);
+        xSemaphoreGive(runner.mutex);
+    }
+}
+
+esp_err_t cycles_init(void) {
+    runner.mutex = xSemaphoreCreateMutex();
+    runner.events = xEventGroupCreate();
+    if (!runner.mutex || !runner.events) {
+        ESP_LOGE(TAG, "Failed to create cycle mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    runner.state = RUNNER_IDLE;
+    xEventGroupSetBits(runner.events, RUNNER_IDLE_BIT);
+
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        runner_task,
+        "cycles",
+        3072,
+        NULL,
+        RUNNER_PRIORITY,
+        &runner.task,
+        1
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create cycle task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t cycle_start(const cycle_params_t* params) {
+    esp_err_t err = cycle_validate(params);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    xSemaphoreTake(runner.mutex, portMAX_DELAY);
+    bool busy = runner.state == RUNNER_RUNNING;
+    xSemaphoreGive(runner.mutex);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Right after cycle_stop() the runner may still be inside the old
+    // cycle; wait for it to hand the cycle back
+    xEventGroupWaitBits(runner.events, RUNNER_IDLE_BIT, pdFALSE, pdTRUE,
+                        pdMS_TO_TICKS(HANDBACK_WAIT_MS));
+
+    // Also fails while a G-code program holds the planner
+    xSemaphoreTake(runner.mutex, portMAX_DELAY);
+    if (runner.state != RUNNER_IDLE || !planner_acquire(PLANNER_OWNER_CYCLE)) {
+        xSemaphoreGive(runner.mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    cycle_begin(&runner.cycle, params);
+    runner.state = RUNNER_RUNNING;
+    xEventGroupClearBits(runner.events, RUNNER_IDLE_BIT);
+    uint16_t pecks = runner.cycle.pecks;
+    xSemaphoreGive(runner.mutex);
+
+    xTaskNotifyGive(runner.task);
+
+    ESP_LOGI(TAG, "Cycle %d: R %.2f to %.2f mm, %u pecks", params->type,
+             params->r_plane, params->depth, pecks);
+    return ESP_OK;
+}
+
+void cycle_stop(void) {
+    xSemaphoreTake(runner.mutex, portMAX_DELAY);
+    if (runner.state == RUNNER_RUNNING) {
+        runner.state = RUNNER_STOPPING;
+        planner_cancel();
+    }
+    xSemaphoreGive(runner.mutex);
+}
+
+bool cycle_is_running(void) {
+    return runner.state == RUNNER_RUNNING;
+}
+
+void cycle_get_progress(uint16_t* peck, uint16_t* pecks) {
+    *peck = runner.cycle.peck;
+    *pecks = runner.cycle.pecks;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "planner.h"
+
+// Canned drilling cycles. A cycle is generated as groups of planner moves
+// (one group per peck) that are queued ahead as planner room frees up:
+//
+//   DRILL (G81)       rapid to R, feed to depth, dwell, rapid to R
+//   PECK (G83)        per peck: feed one increment, rapid out to R, rapid
+//                     back to just above the last depth
+//   CHIP_BREAK (G73)  per peck: feed one increment, back off a little to
+//                     snap the chip, keep feeding
+//
+// Positions are axis mm (0 at home, positive is deeper), so r_plane must
+// be above (less than) depth.
+
+#define CYCLE_MAX_GROUP        3
+#define CYCLE_PECK_CLEARANCE   0.5f    // mm, G83 stops this short of the last depth
+#define CYCLE_BACKOFF          0.2f    // mm, G73 back-off
+
+typedef enum {
+    CYCLE_DRILL,
+    CYCLE_PECK,
+    CYCLE_CHIP_BREAK,
+} cycle_type_t;
+
+typedef struct {
+    cycle_type_t type;
+    float r_plane;      // mm, clearance plane for rapids
+    float depth;        // mm, hole bottom
+    float peck;         // mm per peck, ignored by DRILL
+    float feed;         // mm/s while cutting
+    float dwell;        // s at the bottom
+} cycle_params_t;
+
+typedef enum {
+    CYCLE_STAGE_APPROACH,
+    CYCLE_STAGE_CUT,
+    CYCLE_STAGE_DONE,
+} cycle_stage_t;
+
+// Generator state
+typedef struct {
+    cycle_params_t params;
+    cycle_stage_t stage;
+    float depth;        // mm, bottom of the last peck
+    uint16_t peck;      // pecks generated so far
+    uint16_t pecks;     // total
+} cycle_t;
+
+esp_err_t cycle_validate(const cycle_params_t* params);
+void cycle_begin(cycle_t* cycle, const cycle_params_t* params);
+
+// Next group of moves to queue together (at most CYCLE_MAX_GROUP);
+// returns 0 once the cycle is complete
+size_t cycle_next(cycle_t* cycle, planner_move_t* moves);
+
+// Cycle runner: feeds one cycle to the planner from its own task
+esp_err_t cycles_init(void);
+esp_err_t cycle_start(const cycle_params_t* params);
+void cycle_stop(void);
+bool cycle_is_running(void);
+
+// Pecks handed to the planner so far out of the total, for the UI
+void cycle_get_progress(uint16_t* peck, uint16_t* pecks);
@@ -0,0 +1,115 @@
+#include "feed.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "planner.h"
+#include "settings.h"
+
+static const char* TAG = "feed";
+
+#define MAX_STEP_US 50000   // longest gap between replies integrated in one step
+
+static const feed_tool_t tools[FEED_TOOL_COUNT] = {
+    { "Fixed feed", 0 },
+    { "HSS 3 mm", 700 },
+    { "HSS 6 mm", 1100 },
+    { "HSS 10 mm", 1500 },
+};
+
+// Written by the bus task on every status reply; the rest of the system
+// only reads single words
+static struct {
+    volatile float override;
+    volatile uint16_t target_ma;
+    float filtered_ma;
+    float load;
+    bool cutting;
+    int64_t last_us;
+} feed = {
+    .override = 1.0f,
+};
+
+const feed_tool_t* feed_get_tool(size_t index) {
+    return index < FEED_TOOL_COUNT ? &tools[index] : NULL;
+}
+
+static float clampf(float value, float lo, float hi) {
+    return value < lo ? lo : value > hi ? hi : value;
+}
+
+// Integral control on the load: the override moves at a rate
+// proportional to the distance from the setpoint, so it climbs quickly on
+// soft stock, eases in as the current nears the target and backs off
+// harder than it rose when the drill meets a hard spot
+static void on_status(servo42c_handle_t axis, const servo42c_status_reply_t* status, void* ctx) {
+    int64_t now_us = esp_timer_get_time();
+    int64_t step_us = now_us - feed.last_us;
+    feed.last_us = now_us;
+    if (step_us > MAX_STEP_US) {
+        step_us = MAX_STEP_US;
+    }
+    float dt = (float)step_us / 1e6f;
+
+    float alpha = dt / (FEED_FILTER_MS / 1000.0f + dt);
+    feed.filtered_ma += alpha * ((float)status->current - feed.filtered_ma);
+
+    uint16_t target = feed.target_ma;
+    feed.cutting = planner_is_cutting();
+    if (target == 0) {
+        feed.load = 0.0f;
+        return;
+    }
+    feed.load = feed.filtered_ma / target;
+
+    // Current outside a cut (rapids, dwells, parked) says nothing about
+    // the material; hold the override for the next cut
+    if (!feed.cutting) {
+        return;
+    }
+
+    float error = FEED_LOAD_SETPOINT - feed.load;
+    float rate = error * (error > 0.0f ? FEED_GAIN_UP : FEED_GAIN_DOWN);
+    feed.override = clampf(feed.override + rate * dt, FEED_OVERRIDE_MIN, FEED_OVERRIDE_MAX);
+}
+
+esp_err_t feed_init(servo42c_handle_t axis) {
+    feed.last_us = esp_timer_get_time();
+
+    // The last tool used; fixed feed if the trip has since been lowered
+    // below what it needs
+    if (feed_set_tool(feed_get_tool(settings_get()->tool)) != ESP_OK) {
+        feed_set_tool(feed_get_tool(0));
+    }
+    return servo42c_set_status_callback(axis, on_status, NULL);
+}
+
+esp_err_t feed_set_tool(const feed_tool_t* tool) {
+    if (!tool) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t trip_ma = settings_get()->max_current_ma;
+    if (tool->target_ma > trip_ma * FEED_TARGET_MAX_PERCENT / 100) {
+        ESP_LOGE(TAG, "%s: target %u mA is too close to the %u mA trip", tool->name,
+                 tool->target_ma, (unsigned int)trip_ma);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (planner_is_cutting()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    feed.target_ma = tool->target_ma;
+    feed.override = 1.0f;
+    ESP_LOGI(TAG, "Tool %s, %s", tool->name, tool->target_ma ? "adaptive feed" : "fixed feed");
+    return ESP_OK;
+}
+
+float feed_get_override(void) {
+    return feed.target_ma ? feed.override : 1.0f;
+}
+
+void feed_get_status(feed_status_t* status) {
+    status->override = feed_get_override();
+    status->load = feed.load;
+    status->current_ma = (uint16_t)feed.filtered_ma;
+    status->target_ma = feed.target_ma;
+    status->cutting = feed.cutting;
+}
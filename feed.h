@@ -0,0 +1,57 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "servo42c.h"
+
+// Adaptive feed: a load controller running on every status reply of the
+// drilling axis that scales the programmed feed of cutting moves so the
+// motor current tracks a per-tool target. Well below the target the
+// override climbs; approaching it the climb slows to nothing, and above
+// it the override backs off faster than it rose. Rapids, dwells and
+// moves not marked adaptive always run as programmed.
+//
+// The planner applies the override by time-scaling cutting segments
+// planned at FEED_OVERRIDE_MAX, so the streamed setpoints (and the speed
+// the drive is sent with each) follow it without replanning, and
+// acceleration and jerk stay within the planner limits.
+
+#define FEED_OVERRIDE_MIN      0.25f   // x programmed feed
+#define FEED_OVERRIDE_MAX      1.5f
+#define FEED_LOAD_SETPOINT     0.9f    // of the tool target, the headroom kept
+#define FEED_GAIN_UP           1.0f    // override/s per unit of load below the setpoint
+#define FEED_GAIN_DOWN         4.0f    // ... and above it
+#define FEED_FILTER_MS         20      // current low-pass time constant
+#define FEED_TARGET_MAX_PERCENT 80     // of the overcurrent trip setting, keeps clear of it
+
+typedef struct {
+    const char* name;
+    uint16_t target_ma;     // motor current to cut at, 0 for fixed feed
+} feed_tool_t;
+
+// Built-in tool table, index 0 is fixed feed
+#define FEED_TOOL_COUNT 4
+const feed_tool_t* feed_get_tool(size_t index);
+
+typedef struct {
+    float override;         // x programmed feed, applied to cutting moves
+    float load;             // filtered current / tool target
+    uint16_t current_ma;    // filtered
+    uint16_t target_ma;     // 0 while adaptation is off
+    bool cutting;
+} feed_status_t;
+
+// Follows the status replies of `axis`, starting with the tool saved in
+// the settings
+esp_err_t feed_init(servo42c_handle_t axis);
+
+// Tool change; the override restarts at 1.0. ESP_ERR_INVALID_ARG for a
+// target too close to the overcurrent trip.
+esp_err_t feed_set_tool(const feed_tool_t* tool);
+
+// Multiplier for cutting moves right now; 1.0 with fixed feed. Safe from
+// any task.
+float feed_get_override(void);
+
+void feed_get_status(feed_status_t* status);
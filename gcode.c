@@ -0,0 +1,796 @@
+#include "gcode.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "planner.h"
+#include "cycles.h"
+#include "safety.h"
+#include "settings.h"
+
+static const char* TAG = "gcode";
+
+#define SOURCE_WAIT_MS        100     // re-check for an abort this often while blocked
+#define MAX_CODE              999.0f  // largest G or M number
+#define MAX_DWELL_S           3600.0f
+#define MAX_SPINDLE_RPM       100000.0f
+#define EXECUTOR_PRIORITY     4
+#define READER_PRIORITY       3
+#define SERIAL_RX_BUFFER      512
+#define SERIAL_LINE_QUEUE     2       // a host waits for each answer, so one is enough
+
+static struct {
+    QueueHandle_t blocks;         // parsed blocks, source -> executor
+    SemaphoreHandle_t mutex;      // guards status and state changes
+    TaskHandle_t executor_handle;
+    gcode_status_t status;
+    uint32_t program;             // generation, bumped by each new program
+    gcode_modal_t modal;          // owned by the active source
+    char line[GCODE_LINE_MAX];    // stream line assembly
+    size_t line_len;
+    bool line_overflow;
+    bool reader_active;
+    FILE* file;
+    gcode_spindle_handler_t spindle_handler;
+    QueueHandle_t serial_lines;   // receive task -> serial task
+    atomic_bool serial_aborted;   // a '!' line closed the host's program
+} gcode = {0};
+
+// One line from the host, newline included
+typedef struct {
+    char text[GCODE_LINE_MAX + 1];
+    size_t len;
+    bool overflow;
+} serial_line_t;
+
+static bool is_running(void) {
+    return gcode.status.state == GCODE_RUNNING;
+}
+
+// The executor can still hold a block of a program that stopped after
+// another one has started; such a block must not touch the new program
+static bool is_current(const gcode_block_t* block) {
+    return is_running() && block->program == gcode.program;
+}
+
+// Ends the given program with an error unless it already stopped.
+// Planned motion is cancelled under the mutex so the executor cannot
+// queue a move after it.
+static void fail_program(uint32_t program, uint32_t line, const char* message) {
+    xSemaphoreTake(gcode.mutex, portMAX_DELAY);
+    if (is_running() && program == gcode.program) {
+        gcode.status.state = GCODE_ERROR;
+        snprintf(gcode.status.error, sizeof(gcode.status.error), "line %lu: %s",
+                 (unsigned long)line, message);
+        ESP_LOGE(TAG, "Line %lu: %s", (unsigned long)line, message);
+        xQueueReset(gcode.blocks);
+        planner_cancel();
+        planner_release(PLANNER_OWNER_GCODE);
+    }
+    xSemaphoreGive(gcode.mutex);
+}
+
+// Source side: the source only ever feeds the current program
+static void fail(uint32_t line, const char* message) {
+    fail_program(gcode.program, line, message);
+}
+
+static void fail_block(const gcode_block_t* block, const char* message) {
+    fail_program(block->program, block->line, message);
+}
+
+void gcode_modal_init(gcode_modal_t* modal) {
+    memset(modal, 0, sizeof(*modal));
+    modal->motion = -1;
+}
+
+// Parses the number after a word letter; rejects nan/inf/hex forms
+static bool parse_number(const char** p, float* value) {
+    const char* s = *p;
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    if (!(isdigit((unsigned char)*s) || *s == '-' || *s == '+' || *s == '.')) {
+        return false;
+    }
+
+    char* end;
+    float v = strtof(s, &end);
+    if (end == s || !isfinite(v)) {
+        return false;
+    }
+    *value = v;
+    *p = end;
+    return true;
+}
+
+esp_err_t gcode_parse_line(gcode_modal_t* modal, const char* line,
+                           gcode_block_t* block, bool* has_block) {
+    *has_block = false;
+    modal->line++;
+
+    bool has_z = false;
+    bool dwell = false;
+    bool end = false;
+    int spindle = -1;  // -1 untouched, 0 off, 1 on
+    int motion = modal->motion;
+    int actions = 0;
+    float z = 0.0f;
+    float p = 0.0f;
+
+    const char* s = line;
+    while (*s) {
+        char c = (char)toupper((unsigned char)*s);
+
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '%') {
+            s++;
+            continue;
+        }
+        if (c == ';') {
+            break;
+        }
+        if (c == '(') {
+            const char* close = strchr(s, ')');
+            if (!close) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            s = close + 1;
+            continue;
+        }
+        if (!isalpha((unsigned char)c)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        s++;
+        float value;
+        if (!parse_number(&s, &value)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        switch (c) {
+        case 'G': {
+            if (value < 0.0f || value > MAX_CODE) {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            int code = (int)value;
+            if ((float)code != value) {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            switch (code) {
+            case 0:
+            case 1:
+            case 73:
+            case 81:
+            case 83:
+                motion = code;
+                break;
+            case 80:
+                motion = -1;
+                break;
+            case 4:
+                dwell = true;
+                actions++;
+                break;
+            case 21:    // millimetres
+            case 90:    // absolute positions
+                break;
+            default:
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            break;
+        }
+        case 'M': {
+            if (value < 0.0f || value > MAX_CODE) {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            int code = (int)value;
+            if ((float)code != value) {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            switch (code) {
+            case 3:
+                spindle = 1;
+                break;
+            case 5:
+                spindle = 0;
+                break;
+            case 2:
+            case 30:
+                end = true;
+                break;
+            default:
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            actions++;
+            break;
+        }
+        case 'Z':
+            z = value;
+            has_z = true;
+            break;
+        case 'R':
+            modal->r = value;
+            break;
+        case 'Q':
+            if (value <= 0.0f) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            modal->q = value;
+            break;
+        case 'F':
+            if (value <= 0.0f) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            modal->feed = value / 60.0f;
+            break;
+        case 'P':
+            if (value < 0.0f || value > MAX_DWELL_S) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            p = value;
+            break;
+        case 'S':
+            if (value < 0.0f || value > MAX_SPINDLE_RPM) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            modal->rpm = value;
+            break;
+        case 'N':
+            break;
+        default:
+            // X/Y and anything else this single-axis machine cannot do
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    modal->motion = motion;
+    if (has_z) {
+        actions++;
+    }
+    if (actions == 0) {
+        return ESP_OK;
+    }
+    if (actions > 1) {
+        // One action per line keeps the execution order unambiguous
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(block, 0, sizeof(*block));
+    block->line = modal->line;
+
+    if (dwell) {
+        block->type = GCODE_BLOCK_DWELL;
+        block->dwell = p;
+    } else if (end) {
+        block->type = GCODE_BLOCK_END;
+    } else if (spindle >= 0) {
+        block->type = GCODE_BLOCK_SPINDLE;
+        block->rpm = spindle ? modal->rpm : 0.0f;
+    } else {
+        block->z = z;
+        block->feed = modal->feed;
+        block->r = modal->r;
+        block->q = modal->q;
+        switch (modal->motion) {
+        case 0:
+            block->type = GCODE_BLOCK_RAPID;
+            block->feed = settings_get()->max_speed;
+            break;
+        case 1:
+            block->type = GCODE_BLOCK_FEED;
+            break;
+        case 81:
+            block->type = GCODE_BLOCK_DRILL;
+            break;
+        case 73:
+        case 83:
+            if (modal->q <= 0.0f) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            block->type = modal->motion == 73 ? GCODE_BLOCK_CHIP_BREAK : GCODE_BLOCK_PECK;
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;  // Z with no motion mode
+        }
+        if (block->type != GCODE_BLOCK_RAPID && block->feed <= 0.0f) {
+            return ESP_ERR_INVALID_ARG;  // no F yet
+        }
+        if (block->type >= GCODE_BLOCK_DRILL && block->type <= GCODE_BLOCK_CHIP_BREAK) {
+            if (block->r >= block->z) {
+                return ESP_ERR_INVALID_ARG;  // R plane must be above the hole bottom
+            }
+            block->dwell = p;
+        }
+    }
+
+    *has_block = true;
+    return ESP_OK;
+}
+
+// Source side: parse a line and hand the block to the executor, waiting
+// while the buffer is full. False once the program has stopped.
+static bool submit_line(const char* line) {
+    gcode_block_t block;
+    bool has_block;
+
+    esp_err_t err = gcode_parse_line(&gcode.modal, line, &block, &has_block);
+    gcode.status.line_parsed = gcode.modal.line;
+    if (err != ESP_OK) {
+        fail(gcode.modal.line, err == ESP_ERR_NOT_SUPPORTED ? "unsupported code" : "syntax error");
+        return false;
+    }
+    if (!has_block) {
+        return is_running();
+    }
+
+    block.program = gcode.program;
+    while (is_running()) {
+        if (xQueueSend(gcode.blocks, &block, pdMS_TO_TICKS(SOURCE_WAIT_MS)) == pdTRUE) {
+            return block.type != GCODE_BLOCK_END;
+        }
+    }
+    return false;
+}
+
+// Executor side, between waits: false if the block's program stopped,
+// failing it if a fault tripped
+static bool still_running(const gcode_block_t* block) {
+    if (!is_current(block)) {
+        return false;
+    }
+    if (safety_get_status() != SAFETY_OK) {
+        fail_block(block, "safety fault");
+        return false;
+    }
+    return true;
+}
+
+// Wait for planner room (or for the axis to stop when count is 0).
+// False if the program stopped or a fault tripped meanwhile.
+static bool wait_planner(size_t count, const gcode_block_t* block) {
+    while (count == 0 ? !planner_is_idle() : planner_queue_free() < count) {
+        if (!still_running(block)) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(PLANNER_PERIOD_MS));
+    }
+    return is_current(block);
+}
+
+// G4, in planner periods so an abort or a fault ends it early
+static bool dwell(const gcode_block_t* block) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t ticks = pdMS_TO_TICKS((uint32_t)(block->dwell * 1000.0f));
+    while (xTaskGetTickCount() - start < ticks) {
+        if (!still_running(block)) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(PLANNER_PERIOD_MS));
+    }
+    return is_current(block);
+}
+
+static bool queue_moves(const planner_move_t* moves, size_t count, const gcode_block_t* block) {
+    if (!wait_planner(count, block)) {
+        return false;
+    }
+
+    xSemaphoreTake(gcode.mutex, portMAX_DELAY);
+    esp_err_t err = is_current(block) ? planner_queue_moves(moves, count) : ESP_ERR_INVALID_STATE;
+    xSemaphoreGive(gcode.mutex);
+
+    if (err == ESP_ERR_INVALID_STATE) {
+        return false;
+    }
+    if (err != ESP_OK) {
+        fail_block(block, "move rejected");
+        return false;
+    }
+    return true;
+}
+
+// Canned cycles run through the cycle generator, one peck at a time
+static bool execute_cycle(const gcode_block_t* block) {
+    cycle_params_t params = {
+        .type = block->type == GCODE_BLOCK_DRILL ? CYCLE_DRILL :
+                block->type == GCODE_BLOCK_PECK ? CYCLE_PECK : CYCLE_CHIP_BREAK,
+        .r_plane = block->r,
+        .depth = block->z,
+        .peck = block->q,
+        .feed = block->feed,
+        .dwell = block->dwell,
+    };
+    if (cycle_validate(&params) != ESP_OK) {
+        fail_block(block, "invalid cycle");
+        return false;
+    }
+
+    cycle_t cycle;
+    planner_move_t moves[CYCLE_MAX_GROUP];
+    size_t count;
+    cycle_begin(&cycle, &params);
+    while ((count = cycle_next(&cycle, moves)) > 0) {
+        if (!queue_moves(moves, count, block)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns false when the program stopped (or ended) on this block
+static bool execute_block(const gcode_block_t* block) {
+    switch (block->type) {
+    case GCODE_BLOCK_RAPID:
+    case GCODE_BLOCK_FEED: {
+        planner_move_t move = {
+            .target_mm = block->z,
+            .speed_mm_s = block->feed,
+            .adaptive = block->type == GCODE_BLOCK_FEED,
+        };
+        return queue_moves(&move, 1, block);
+    }
+    case GCODE_BLOCK_DRILL:
+    case GCODE_BLOCK_PECK:
+    case GCODE_BLOCK_CHIP_BREAK:
+        return execute_cycle(block);
+    case GCODE_BLOCK_DWELL:
+        if (!wait_planner(0, block)) {
+            return false;
+        }
+        return dwell(block);
+    case GCODE_BLOCK_SPINDLE:
+        if (!wait_planner(0, block)) {
+            return false;
+        }
+        if (gcode.spindle_handler) {
+            gcode.spindle_handler(block->rpm > 0.0f, block->rpm);
+        } else {
+            ESP_LOGW(TAG, "Line %lu: no spindle handler", (unsigned long)block->line);
+        }
+        return true;
+    case GCODE_BLOCK_END:
+        if (!wait_planner(0, block)) {
+            return false;
+        }
+        xSemaphoreTake(gcode.mutex, portMAX_DELAY);
+        if (is_current(block)) {
+            gcode.status.state = GCODE_DONE;
+            planner_release(PLANNER_OWNER_GCODE);
+            ESP_LOGI(TAG, "Program finished at line %lu", (unsigned long)block->line);
+        }
+        xSemaphoreGive(gcode.mutex);
+        return false;
+    }
+    return false;
+}
+
+static void executor_task(void* arg) {
+    gcode_block_t block;
+
+    while (1) {
+        xQueueReceive(gcode.blocks, &block, portMAX_DELAY);
+        if (!is_current(&block)) {
+            continue;  // left over from a stopped program
+        }
+        gcode.status.line_executing = block.line;
+        execute_block(&block);
+    }
+}
+
+static void reader_task(void* arg) {
+    char line[GCODE_LINE_MAX];
+
+    while (is_running() && fgets(line, sizeof(line), gcode.file)) {
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n' && !feof(gcode.file)) {
+            fail(gcode.modal.line + 1, "line too long");
+            break;
+        }
+        if (!submit_line(line)) {
+            break;
+        }
+    }
+
+    // A program without M30 still ends once its last move is done
+    if (is_running() && feof(gcode.file)) {
+        submit_line("M30");
+    }
+
+    fclose(gcode.file);
+    gcode.file = NULL;
+    gcode.reader_active = false;
+    vTaskDelete(NULL);
+}
+
+// One write per reply: log output shares the port and must not land
+// between the text and its newline
+static void serial_reply(const char* text) {
+    char reply[64];
+    int len = snprintf(reply, sizeof(reply), "%s\n", text);
+    if (len >= (int)sizeof(reply)) {
+        len = sizeof(reply) - 1;
+        reply[len - 1] = '\n';
+    }
+    uart_write_bytes(GCODE_UART_NUM, reply, len);
+}
+
+// Answers a line the program did not take
+static void serial_error(void) {
+    gcode_status_t status;
+    gcode_get_status(&status);
+
+    char reply[sizeof(status.error) + 8];
+    snprintf(reply, sizeof(reply), "error: %s",
+             status.state == GCODE_ERROR ? status.error : "program stopped");
+    serial_reply(reply);
+}
+
+// One complete line from the host, newline included
+static void serial_line(const char* line, size_t len, bool overflow, bool* in_program) {
+    if (strcmp(line, "%\n") == 0) {
+        if (!*in_program) {
+            if (gcode_stream_begin() != ESP_OK) {
+                serial_reply("error: busy");
+                return;
+            }
+            *in_program = true;
+        } else {
+            // A program without M30 still ends once its last move is done
+            if (is_running()) {
+                gcode_feed("M30\n", 4);
+            }
+            *in_program = false;
+        }
+        serial_reply("ok");
+        return;
+    }
+
+    if (!*in_program) {
+        serial_reply(len > 1 ? "error: no program open" : "ok");
+        return;
+    }
+    if (overflow) {
+        fail(gcode.modal.line + 1, "line too long");
+    } else if (gcode_feed(line, len) == ESP_OK) {
+        serial_reply("ok");
+        return;
+    }
+    serial_error();
+    *in_program = false;
+}
+
+// Answers host lines in order. gcode_feed() blocks here while the
+// block buffer is full, so the receive task stays free for '!'.
+static void serial_task(void* arg) {
+    serial_line_t line;
+    bool in_program = false;
+
+    while (1) {
+        xQueueReceive(gcode.serial_lines, &line, portMAX_DELAY);
+        if (atomic_exchange(&gcode.serial_aborted, false)) {
+            in_program = false;
+        }
+        serial_line(line.text, line.len, line.overflow, &in_program);
+    }
+}
+
+// Splits the byte stream into lines. A line holding only '!' aborts the
+// program right here instead of queueing behind a blocked line.
+static void serial_rx_task(void* arg) {
+    serial_line_t line = {0};
+    uint8_t rx[64];
+
+    while (1) {
+        // Wait for a byte, then take whatever else has arrived
+        int count = uart_read_bytes(GCODE_UART_NUM, rx, 1, portMAX_DELAY);
+        size_t buffered = 0;
+        uart_get_buffered_data_len(GCODE_UART_NUM, &buffered);
+        if (count > 0 && buffered > 0) {
+            size_t more = buffered < sizeof(rx) - 1 ? buffered : sizeof(rx) - 1;
+            int got = uart_read_bytes(GCODE_UART_NUM, &rx[1], more, 0);
+            count += got > 0 ? got : 0;
+        }
+
+        for (int i = 0; i < count; i++) {
+            char c = (char)rx[i];
+            if (c == '\r') {
+                continue;
+            }
+            if (c != '\n') {
+                if (line.len < GCODE_LINE_MAX - 1) {
+                    line.text[line.len++] = c;
+                } else {
+                    line.overflow = true;
+                }
+                continue;
+            }
+
+            line.text[line.len++] = '\n';
+            line.text[line.len] = '\0';
+            if (strcmp(line.text, "!\n") == 0) {
+                gcode_abort();
+                atomic_store(&gcode.serial_aborted, true);
+                serial_reply("ok");
+            } else {
+                xQueueSend(gcode.serial_lines, &line, portMAX_DELAY);
+            }
+            line.len = 0;
+            line.overflow = false;
+        }
+    }
+}
+
+// Resets the interpreter for a new program; fails if one is running or
+// the planner is busy with a canned cycle
+static esp_err_t start_program(void) {
+    xSemaphoreTake(gcode.mutex, portMAX_DELAY);
+    if (is_running() || gcode.reader_active || !planner_acquire(PLANNER_OWNER_GCODE)) {
+        xSemaphoreGive(gcode.mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    xQueueReset(gcode.blocks);
+    gcode_modal_init(&gcode.modal);
+    gcode.line_len = 0;
+    gcode.line_overflow = false;
+    memset(&gcode.status, 0, sizeof(gcode.status));
+    gcode.status.state = GCODE_RUNNING;
+    gcode.program++;
+    xSemaphoreGive(gcode.mutex);
+    return ESP_OK;
+}
+
+esp_err_t gcode_init(void) {
+    ESP_LOGI(TAG, "Initializing G-code interpreter");
+
+    gcode.blocks = xQueueCreate(GCODE_BLOCK_BUFFER, sizeof(gcode_block_t));
+    gcode.mutex = xSemaphoreCreateMutex();
+    if (!gcode.blocks || !gcode.mutex) {
+        ESP_LOGE(TAG, "Failed to create G-code queues");
+        return ESP_ERR_NO_MEM;
+    }
+    gcode_modal_init(&gcode.modal);
+
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        executor_task,
+        "gcode_exec",
+        4096,
+        NULL,
+        EXECUTOR_PRIORITY,
+        &gcode.executor_handle,
+        1
+    );
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create executor task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t gcode_run_file(const char* path) {
+    esp_err_t err = start_program();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    gcode.file = fopen(path, "r");
+    if (!gcode.file) {
+        ESP_LOGE(TAG, "Cannot open %s", path);
+        fail(0, "cannot open file");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    gcode.reader_active = true;
+    if (xTaskCreatePinnedToCore(reader_task, "gcode_rd", 4096, NULL,
+                                READER_PRIORITY, NULL, 0) != pdPASS) {
+        gcode.reader_active = false;
+        fclose(gcode.file);
+        gcode.file = NULL;
+        fail(0, "no memory for reader");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Running %s", path);
+    return ESP_OK;
+}
+
+esp_err_t gcode_serial_start(void) {
+    uart_config_t uart_config = {
+        .baud_rate = GCODE_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_APB,
+    };
+
+    // The console's pins stay as the bootloader set them up
+    esp_err_t err = uart_param_config(GCODE_UART_NUM, &uart_config);
+    if (err == ESP_OK) {
+        err = uart_driver_install(GCODE_UART_NUM, SERIAL_RX_BUFFER, 0, 0, NULL, 0);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up the console UART: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    gcode.serial_lines = xQueueCreate(SERIAL_LINE_QUEUE, sizeof(serial_line_t));
+    if (!gcode.serial_lines) {
+        ESP_LOGE(TAG, "Failed to create serial line queue");
+        return ESP_ERR_NO_MEM;
+    }
+    atomic_init(&gcode.serial_aborted, false);
+
+    if (xTaskCreatePinnedToCore(serial_task, "gcode_uart", 4096, NULL,
+                                READER_PRIORITY, NULL, 0) != pdPASS ||
+        xTaskCreatePinnedToCore(serial_rx_task, "gcode_rx", 4096, NULL,
+                                READER_PRIORITY, NULL, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create serial tasks");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Accepting programs on UART%d", GCODE_UART_NUM);
+    return ESP_OK;
+}
+
+esp_err_t gcode_stream_begin(void) {
+    return start_program();
+}
+
+esp_err_t gcode_feed(const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!is_running()) {
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        char c = data[i];
+        if (c != '\n') {
+            if (gcode.line_len < sizeof(gcode.line) - 1) {
+                gcode.line[gcode.line_len++] = c;
+            } else {
+                gcode.line_overflow = true;
+            }
+            continue;
+        }
+
+        gcode.line[gcode.line_len] = '\0';
+        gcode.line_len = 0;
+        if (gcode.line_overflow) {
+            fail(gcode.modal.line + 1, "line too long");
+            return ESP_ERR_INVALID_SIZE;
+        }
+        submit_line(gcode.line);
+    }
+    return is_running() || gcode.status.state == GCODE_DONE ? ESP_OK : ESP_FAIL;
+}
+
+void gcode_abort(void) {
+    xSemaphoreTake(gcode.mutex, portMAX_DELAY);
+    if (is_running()) {
+        gcode.status.state = GCODE_ABORTED;
+        ESP_LOGW(TAG, "Program aborted at line %lu", (unsigned long)gcode.status.line_executing);
+        xQueueReset(gcode.blocks);
+        planner_cancel();
+        planner_release(PLANNER_OWNER_GCODE);
+    }
+    xSemaphoreGive(gcode.mutex);
+}
+
+void gcode_get_status(gcode_status_t* status) {
+    xSemaphoreTake(gcode.mutex, portMAX_DELAY);
+    *status = gcode.status;
+    status->blocks_buffered = uxQueueMessagesWaiting(gcode.blocks);
+    xSemaphoreGive(gcode.mutex);
+}
+
+void gcode_set_spindle_handler(gcode_spindle_handler_t handler) {
+    gcode.spindle_handler = handler;
+}
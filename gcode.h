@@ -0,0 +1,114 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Streaming G-code interpreter for the Z axis.
+//
+// Supported subset: G0 rapid, G1 feed, G4 dwell (P seconds), G81 drill,
+// G83 peck drill, G73 chip-break drill, G80 cycle cancel, M3/M5 spindle,
+// M2/M30 end. Words: Z target/final depth, R retract plane, Q peck
+// increment, F feed (mm/min), P dwell (s, up to an hour, also at the
+// bottom of a cycle), S (rpm) and N (ignored). G21 and G90 are accepted
+// as the only modes there are. Comments are (...) or everything after ';'.
+//
+// Z and R are axis positions in mm as used everywhere else in the
+// firmware: 0 at home, positive is deeper.
+//
+// Lines are parsed into a bounded block buffer ahead of the executor,
+// which feeds the motion planner. A full buffer blocks the source, so a
+// program can be longer than RAM.
+
+#define GCODE_BLOCK_BUFFER   32
+#define GCODE_LINE_MAX       96
+
+// Serial source on the console UART (the USB bridge). Log output shares
+// the port, so hosts only look at lines starting with "ok" or "error".
+#define GCODE_UART_NUM       0
+#define GCODE_UART_BAUD      115200
+
+typedef enum {
+    GCODE_IDLE,
+    GCODE_RUNNING,
+    GCODE_DONE,
+    GCODE_ERROR,
+    GCODE_ABORTED,
+} gcode_state_t;
+
+typedef enum {
+    GCODE_BLOCK_RAPID,
+    GCODE_BLOCK_FEED,
+    GCODE_BLOCK_DWELL,
+    GCODE_BLOCK_DRILL,      // G81
+    GCODE_BLOCK_PECK,       // G83
+    GCODE_BLOCK_CHIP_BREAK, // G73
+    GCODE_BLOCK_SPINDLE,
+    GCODE_BLOCK_END,
+} gcode_block_type_t;
+
+typedef struct {
+    gcode_block_type_t type;
+    uint32_t line;
+    float z;            // mm, target or final depth
+    float r;            // mm, retract plane (cycles)
+    float q;            // mm, peck increment (G83, G73)
+    float feed;         // mm/s
+    float dwell;        // s
+    float rpm;          // spindle speed, 0 for M5
+    uint32_t program;   // set when queued: generation of its program
+} gcode_block_t;
+
+// Modal state carried from line to line
+typedef struct {
+    int motion;         // 0, 1, 73, 81, 83 or -1 when none is active
+    float feed;         // mm/s
+    float r;
+    float q;
+    float rpm;
+    uint32_t line;
+} gcode_modal_t;
+
+typedef struct {
+    gcode_state_t state;
+    uint32_t line_parsed;
+    uint32_t line_executing;
+    size_t blocks_buffered;
+    char error[48];
+} gcode_status_t;
+
+// Called between moves with the axis at rest
+typedef void (*gcode_spindle_handler_t)(bool on, float rpm);
+
+esp_err_t gcode_init(void);
+
+void gcode_modal_init(gcode_modal_t* modal);
+
+// Parse one line. *has_block is false for lines that only change modal
+// state (or are blank). Fails with ESP_ERR_INVALID_ARG on a syntax error
+// or an unsupported word, ESP_ERR_NOT_SUPPORTED on an unsupported code.
+esp_err_t gcode_parse_line(gcode_modal_t* modal, const char* line,
+                           gcode_block_t* block, bool* has_block);
+
+// Run a program from a file on a mounted VFS path
+esp_err_t gcode_run_file(const char* path);
+
+// Run a program streamed in arbitrary chunks, e.g. from a serial port.
+// gcode_feed() blocks while the block buffer is full.
+esp_err_t gcode_stream_begin(void);
+esp_err_t gcode_feed(const char* data, size_t len);
+
+// Serve programs streamed over GCODE_UART_NUM. A line holding only '%'
+// opens a program and the next one closes it, ending it like M30 if it
+// is still running. Every line is answered with "ok" once its block is
+// buffered, or with "error: <reason>", so a host that waits for the
+// answer before sending the next line is held back by the block buffer.
+// A line holding only '!' aborts the program at once, even while an
+// earlier line is still waiting for room; the program is then closed.
+esp_err_t gcode_serial_start(void);
+
+// Stop the program: drops buffered blocks and cancels planned motion
+void gcode_abort(void);
+
+void gcode_get_status(gcode_status_t* status);
+void gcode_set_spindle_handler(gcode_spindle_handler_t handler);
@@ -1,47 +1,302 @@
-// Update GT911 initialization and read functions
-static esp_err_t gt911_write_reg(uint16_t reg, uint8_t* data, size_t len) {
+#include <string.h>
+#include "gt911.h"
+#include "driver/i2c.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "latency.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+static const char* TAG = "gt911";
+
+#define GT911_ADDR GT911_I2C_ADDR
+#define I2C_MASTER_NUM I2C_NUM_0
+#define I2C_MASTER_FREQ_HZ 400000
+#define GT911_REG_TOUCH_STATUS GT911_REG_STATUS
+#define GT911_REG_PRODUCT_ID 0x8140
+
+#define STATUS_BUFFER_READY  0x80
+#define STATUS_POINT_COUNT   0x0F
+#define REPORT_SIZE          (1 + GT911_MAX_TOUCH * GT911_POINT_SIZE)
+
+// Operations queued in each prebuilt transaction
+#define READ_LINK_OPS        8
+#define CLEAR_LINK_OPS       6
+
+// The controller reports every scan while a finger is down; this long
+// without a report means the release edge was missed
+#define RELEASE_TIMEOUT_MS   50
+
+#define SAMPLE_QUEUE_SIZE    8
+#define TOUCH_TASK_PRIORITY  4
+
+typedef struct {
+    lv_point_t point;
+    bool pressed;
+} touch_sample_t;
+
+static SemaphoreHandle_t i2c_mutex = NULL;
+static bool touch_initialized = false;
+
+static struct {
+    TaskHandle_t task;
+    QueueHandle_t samples;        // touch task -> gt911_read()
+    SemaphoreHandle_t input_ready;
+
+    // Prebuilt transactions, reused for every report
+    i2c_cmd_handle_t read_link;
+    i2c_cmd_handle_t clear_link;
+    uint8_t read_link_buf[I2C_LINK_RECOMMENDED_SIZE(READ_LINK_OPS)];
+    uint8_t clear_link_buf[I2C_LINK_RECOMMENDED_SIZE(CLEAR_LINK_OPS)];
+    uint8_t report[REPORT_SIZE];
+    uint8_t clear_cmd[3];
+
+    portMUX_TYPE lock;            // guards latest
+    gt911_touch_t latest;
+    touch_sample_t last_sample;   // owned by the LVGL task
+    bool pressed;                 // owned by the touch task
+} touch = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static esp_err_t gt911_read_reg(uint16_t reg, uint8_t* data, size_t len) {
     if (xSemaphoreTake(i2c_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
         return ESP_ERR_TIMEOUT;
     }
-    
+
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
     i2c_master_start(cmd);
     i2c_master_write_byte(cmd, (GT911_ADDR << 1) | I2C_MASTER_WRITE, true);
     i2c_master_write_byte(cmd, reg >> 8, true);
     i2c_master_write_byte(cmd, reg & 0xFF, true);
-    i2c_master_write(cmd, data, len, true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (GT911_ADDR << 1) | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, data, len, I2C_MASTER_LAST_NACK);
     i2c_master_stop(cmd);
     esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(100));
     i2c_cmd_link_delete(cmd);
-    
+
     xSemaphoreGive(i2c_mutex);
     return ret;
 }
 
+// Status byte plus all five point records in one transaction, followed
+// by the status clear that re-arms the controller
+static void build_report_links(void) {
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(touch.read_link_buf,
+                                                      sizeof(touch.read_link_buf));
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (GT911_ADDR << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write_byte(cmd, GT911_REG_TOUCH_STATUS >> 8, true);
+    i2c_master_write_byte(cmd, GT911_REG_TOUCH_STATUS & 0xFF, true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (GT911_ADDR << 1) | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, touch.report, sizeof(touch.report), I2C_MASTER_LAST_NACK);
+    i2c_master_stop(cmd);
+    touch.read_link = cmd;
+
+    touch.clear_cmd[0] = GT911_REG_TOUCH_STATUS >> 8;
+    touch.clear_cmd[1] = GT911_REG_TOUCH_STATUS & 0xFF;
+    touch.clear_cmd[2] = 0;
+    cmd = i2c_cmd_link_create_static(touch.clear_link_buf, sizeof(touch.clear_link_buf));
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (GT911_ADDR << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write(cmd, touch.clear_cmd, sizeof(touch.clear_cmd), true);
+    i2c_master_stop(cmd);
+    touch.clear_link = cmd;
+}
+
+// Reads one report into touch.report; false if no new report was ready
+static bool read_report(void) {
+    if (xSemaphoreTake(i2c_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+
+    uint32_t start = latency_now();
+    bool ready = false;
+    if (i2c_master_cmd_begin(I2C_MASTER_NUM, touch.read_link, pdMS_TO_TICKS(100)) == ESP_OK &&
+        (touch.report[0] & STATUS_BUFFER_READY)) {
+        i2c_master_cmd_begin(I2C_MASTER_NUM, touch.clear_link, pdMS_TO_TICKS(100));
+        ready = true;
+    }
+    latency_end(LATENCY_TOUCH_I2C, start);
+
+    xSemaphoreGive(i2c_mutex);
+    return ready;
+}
+
+static void decode_report(gt911_touch_t* out) {
+    uint8_t count = touch.report[0] & STATUS_POINT_COUNT;
+    if (count > GT911_MAX_TOUCH) {
+        count = 0;
+    }
+
+    out->count = count;
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t* p = &touch.report[1 + i * GT911_POINT_SIZE];
+        out->points[i].id = p[0];
+        out->points[i].x = (p[2] << 8) | p[1];
+        out->points[i].y = (p[4] << 8) | p[3];
+        out->points[i].size = (p[6] << 8) | p[5];
+    }
+}
+
+static void publish(const gt911_touch_t* report) {
+    portENTER_CRITICAL(&touch.lock);
+    touch.latest = *report;
+    portEXIT_CRITICAL(&touch.lock);
+
+    touch_sample_t sample = { .pressed = report->count > 0 };
+    if (sample.pressed) {
+        sample.point.x = report->points[0].x;
+        sample.point.y = report->points[0].y;
+    }
+
+    // Keep the newest samples; a press or release is never the one dropped
+    // because the oldest entry goes first
+    if (xQueueSend(touch.samples, &sample, 0) != pdTRUE) {
+        touch_sample_t oldest;
+        xQueueReceive(touch.samples, &oldest, 0);
+        xQueueSend(touch.samples, &sample, 0);
+    }
+    touch.pressed = sample.pressed;
+    xSemaphoreGive(touch.input_ready);
+}
+
+static void touch_task(void* arg) {
+    (void)arg;
+
+    while (1) {
+        // Idle until INT fires; while pressed, wake up anyway to catch a
+        // lost release
+        TickType_t wait = touch.pressed ? pdMS_TO_TICKS(RELEASE_TIMEOUT_MS) : portMAX_DELAY;
+        bool notified = ulTaskNotifyTake(pdTRUE, wait) > 0;
+
+        gt911_touch_t report;
+        if (read_report()) {
+            decode_report(&report);
+            publish(&report);
+        } else if (!notified && touch.pressed) {
+            report.count = 0;
+            publish(&report);
+        }
+    }
+}
+
+static void IRAM_ATTR touch_isr(void* arg) {
+    (void)arg;
+    BaseType_t high_task_wakeup = pdFALSE;
+    vTaskNotifyGiveFromISR(touch.task, &high_task_wakeup);
+    portYIELD_FROM_ISR(high_task_wakeup);
+}
+
+esp_err_t gt911_init(void) {
+    ESP_LOGI(TAG, "Initializing GT911 touch controller");
+
+    i2c_mutex = xSemaphoreCreateMutex();
+    touch.samples = xQueueCreate(SAMPLE_QUEUE_SIZE, sizeof(touch_sample_t));
+    touch.input_ready = xSemaphoreCreateBinary();
+    if (!i2c_mutex || !touch.samples || !touch.input_ready) {
+        ESP_LOGE(TAG, "Failed to create touch sync objects");
+        return ESP_ERR_NO_MEM;
+    }
+
+    i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = GT911_I2C_SDA,
+        .scl_io_num = GT911_I2C_SCL,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = I2C_MASTER_FREQ_HZ,
+    };
+    ESP_ERROR_CHECK(i2c_param_config(I2C_MASTER_NUM, &conf));
+    ESP_ERROR_CHECK(i2c_driver_install(I2C_MASTER_NUM, conf.mode, 0, 0, 0));
+
+    // Reset with INT held low selects I2C address 0x5D
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << GT911_RST_PIN) | (1ULL << GT911_INT_PIN),
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+    gpio_set_level(GT911_INT_PIN, 0);
+    gpio_set_level(GT911_RST_PIN, 0);
+    vTaskDelay(pdMS_TO_TICKS(10));
+    gpio_set_level(GT911_RST_PIN, 1);
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    // INT now belongs to the controller, which pulses it low per report
+    gpio_config_t int_conf = {
+        .pin_bit_mask = 1ULL << GT911_INT_PIN,
+        .mode = GPIO_MODE_INPUT,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&int_conf));
+
+    uint8_t product_id[4] = {0};
+    esp_err_t ret = gt911_read_reg(GT911_REG_PRODUCT_ID, product_id, 3);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "GT911 not responding");
+        return ret;
+    }
+
+    build_report_links();
+
+    if (xTaskCreatePinnedToCore(touch_task, "gt911_touch", 3072, NULL,
+                                TOUCH_TASK_PRIORITY, &touch.task, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create touch task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // The safety module normally installed the ISR service already
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        return ret;
+    }
+    ESP_ERROR_CHECK(gpio_isr_handler_add(GT911_INT_PIN, touch_isr, NULL));
+
+    touch_initialized = true;
+    ESP_LOGI(TAG, "GT911 initialized (product ID %s)", (char*)product_id);
+    return ESP_OK;
+}
+
 void gt911_read(lv_indev_drv_t* drv, lv_indev_data_t* data) {
-    static uint8_t touch_data[7];
-    
+    (void)drv;
+
     if (!touch_initialized) {
         data->state = LV_INDEV_STATE_REL;
         return;
     }
-    
-    esp_err_t ret = gt911_read_reg(GT911_REG_TOUCH_STATUS, touch_data, sizeof(touch_data));
-    
-    if (ret == ESP_OK) {
-        uint8_t touch_num = touch_data[0] & 0x0F;
-        if (touch_num > 0 && touch_num <= GT911_MAX_TOUCH) {
-            data->point.x = ((touch_data[2] << 8) | touch_data[1]);
-            data->point.y = ((touch_data[4] << 8) | touch_data[3]);
-            data->state = LV_INDEV_STATE_PR;
-            
-            // Clear status register
-            uint8_t clear = 0;
-            gt911_write_reg(GT911_REG_TOUCH_STATUS, &clear, 1);
-        } else {
-            data->state = LV_INDEV_STATE_REL;
+
+    // One buffered sample per call; LVGL calls again while more are
+    // waiting, so a quick tap between two reads is not lost
+    uint32_t start = latency_now();
+    touch_sample_t sample;
+    if (xQueueReceive(touch.samples, &sample, 0) == pdTRUE) {
+        if (sample.pressed) {
+            touch.last_sample.point = sample.point;
         }
-    } else {
-        data->state = LV_INDEV_STATE_REL;
+        touch.last_sample.pressed = sample.pressed;
+    }
+
+    // A release keeps the last pressed coordinates, as LVGL expects
+    data->point = touch.last_sample.point;
+    data->state = touch.last_sample.pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    data->continue_reading = uxQueueMessagesWaiting(touch.samples) > 0;
+    latency_end(LATENCY_TOUCH_READ, start);
+}
+
+void gt911_get_touch(gt911_touch_t* out) {
+    portENTER_CRITICAL(&touch.lock);
+    *out = touch.latest;
+    portEXIT_CRITICAL(&touch.lock);
+}
+
+bool gt911_wait_input(TickType_t timeout) {
+    if (!touch.input_ready) {
+        vTaskDelay(timeout);
+        return false;
     }
+    return xSemaphoreTake(touch.input_ready, timeout) == pdTRUE;
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 #include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
 #include "lvgl.h"
+#include "freertos/FreeRTOS.h"
 
 // GT911 I2C configuration for JC8048W550C
 #define GT911_I2C_ADDR 0x5D
@@ -18,5 +21,30 @@
 #define GT911_REG_POINT1_Y  0x8152
 #define GT911_REG_RESOLUTION 0x8048
 
+#define GT911_MAX_TOUCH     5
+#define GT911_POINT_SIZE    8   // bytes per point record after the status byte
+
+typedef struct {
+    uint8_t id;      // track ID, stable while the finger stays down
+    uint16_t x;
+    uint16_t y;
+    uint16_t size;   // contact area
+} gt911_point_t;
+
+typedef struct {
+    uint8_t count;
+    gt911_point_t points[GT911_MAX_TOUCH];
+} gt911_touch_t;
+
+// Touch reports are read by a task woken from the INT line, so the bus is
+// idle while nobody touches the panel
 esp_err_t gt911_init(void);
-void gt911_read(lv_indev_drv_t* drv, lv_indev_data_t* data);
\ No newline at end of file
+
+// LVGL read_cb; serves buffered samples and never touches the bus
+void gt911_read(lv_indev_drv_t* drv, lv_indev_data_t* data);
+
+// Latest multi-point report, for two-finger gestures
+void gt911_get_touch(gt911_touch_t* touch);
+
+// Blocks until a new report arrives or the timeout expires
+bool gt911_wait_input(TickType_t timeout);
\ No newline at end of file
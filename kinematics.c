@@ -0,0 +1,193 @@
+#include "kinematics.h"
+#include <stdbool.h>
+#include "esp_log.h"
+
+_Static_assert(KIN_ENCODER_COUNTS == 1 << 16, "kin_encoder_to_nm() shifts by 16");
+
+static const char* TAG = "kinematics";
+
+static const kin_profile_t profile = {
+    .name = KIN_PROFILE_NAME,
+    .steps_per_rev = KIN_STEPS_PER_REV,
+    .microsteps = KIN_MICROSTEPS,
+    .motor_revs = KIN_MOTOR_REVS,
+    .screw_revs = KIN_SCREW_REVS,
+    .lead_nm = KIN_LEAD_NM,
+};
+
+// Division by a divisor fixed at init, as a multiply and shifts
+// (Granlund-Montgomery, exact for every 32-bit dividend)
+typedef struct {
+    uint32_t magic;
+    uint8_t shift1;
+    uint8_t shift2;
+} divider_t;
+
+// Steps per nm as a reduced fraction, plus the limits the integer
+// arithmetic was validated for
+static struct {
+    bool ready;
+    int32_t num;
+    int32_t den;
+    divider_t by_num;
+    divider_t by_den;
+    int32_t nm_per_motor_rev;
+    int32_t max_nm;
+    int32_t max_steps;
+    float steps_per_mm;
+    float mm_per_step;
+} kin;
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static void divider_init(divider_t* div, uint32_t d) {
+    uint8_t log2_ceil = 0;
+    while (((uint64_t)1 << log2_ceil) < d) {
+        log2_ceil++;
+    }
+    div->magic = (uint32_t)((((uint64_t)1 << 32) * (((uint64_t)1 << log2_ceil) - d)) / d + 1);
+    div->shift1 = log2_ceil < 1 ? log2_ceil : 1;
+    div->shift2 = log2_ceil > 1 ? log2_ceil - 1 : 0;
+}
+
+static inline uint32_t divide(uint32_t n, const divider_t* div) {
+    uint32_t t = (uint32_t)(((uint64_t)n * div->magic) >> 32);
+    return (t + ((n - t) >> div->shift1)) >> div->shift2;
+}
+
+// n / d to nearest, halves away from zero, so the result is symmetric
+// around 0
+static inline int32_t div_round(int32_t n, uint32_t d, const divider_t* div) {
+    return n >= 0 ? (int32_t)divide((uint32_t)n + d / 2, div)
+                  : -(int32_t)divide((uint32_t)-n + d / 2, div);
+}
+
+static inline int32_t round_to_int(float x) {
+    return (int32_t)(x >= 0.0f ? x + 0.5f : x - 0.5f);
+}
+
+esp_err_t kinematics_init(void) {
+    if (kin.ready) {
+        return ESP_OK;
+    }
+
+    uint64_t steps_per_screw_revs = (uint64_t)profile.steps_per_rev * profile.microsteps * profile.motor_revs;
+    uint64_t nm_per_screw_revs = (uint64_t)profile.lead_nm * profile.screw_revs;
+    uint64_t divisor = gcd(steps_per_screw_revs, nm_per_screw_revs);
+    uint64_t num = steps_per_screw_revs / divisor;
+    uint64_t den = nm_per_screw_revs / divisor;
+    uint64_t max_nm = (uint64_t)KIN_RANGE_MM * KIN_NM_PER_MM;
+
+    // Steps no finer than 1 nm keep steps -> nm -> steps exact
+    if (num > den) {
+        ESP_LOGE(TAG, "%s: steps finer than 1 nm", profile.name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Both directions multiply before dividing; over the whole range
+    // that must stay within 32 bits
+    if (max_nm * num + den > INT32_MAX) {
+        ESP_LOGE(TAG, "%s: ratio %llu/%llu overflows over +-%d mm", profile.name,
+                 (unsigned long long)num, (unsigned long long)den, KIN_RANGE_MM);
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Encoder readings convert per motor revolution
+    if ((uint64_t)profile.lead_nm * profile.screw_revs % profile.motor_revs != 0) {
+        ESP_LOGE(TAG, "%s: travel per motor revolution is not a whole nm", profile.name);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    kin.num = (int32_t)num;
+    kin.den = (int32_t)den;
+    divider_init(&kin.by_num, (uint32_t)num);
+    divider_init(&kin.by_den, (uint32_t)den);
+    kin.nm_per_motor_rev = (int32_t)((uint64_t)profile.lead_nm * profile.screw_revs / profile.motor_revs);
+    kin.max_nm = (int32_t)max_nm;
+    kin.max_steps = (int32_t)(max_nm * num / den);
+    kin.steps_per_mm = (float)num * KIN_NM_PER_MM / (float)den;
+    kin.mm_per_step = (float)den / ((float)num * KIN_NM_PER_MM);
+    kin.ready = true;
+
+    ESP_LOGI(TAG, "%s: %.2f steps/mm, %ld/%ld steps/nm, max %.1f mm/s", profile.name,
+             kin.steps_per_mm, (long)kin.num, (long)kin.den, kin_max_speed());
+    return ESP_OK;
+}
+
+const kin_profile_t* kin_get_profile(void) {
+    return &profile;
+}
+
+kin_steps_t kin_nm_to_steps(kin_nm_t position) {
+    if (position > kin.max_nm) {
+        position = kin.max_nm;
+    } else if (position < -kin.max_nm) {
+        position = -kin.max_nm;
+    }
+    return div_round(position * kin.num, kin.den, &kin.by_den);
+}
+
+kin_nm_t kin_steps_to_nm(kin_steps_t steps) {
+    if (steps > kin.max_steps) {
+        steps = kin.max_steps;
+    } else if (steps < -kin.max_steps) {
+        steps = -kin.max_steps;
+    }
+    return div_round(steps * kin.den, kin.num, &kin.by_num);
+}
+
+kin_nm_t kin_encoder_to_nm(int32_t turns, uint16_t fraction) {
+    int64_t counts = (int64_t)turns * KIN_ENCODER_COUNTS + fraction;
+    // Arithmetic shift: floor, so + half rounds to nearest for either sign
+    return (kin_nm_t)((counts * kin.nm_per_motor_rev + KIN_ENCODER_COUNTS / 2) >> 16);
+}
+
+// Whole and fractional mm are scaled separately, so the result is as
+// exact as the float it came from
+kin_nm_t kin_mm_to_nm(float mm) {
+    if (!(mm < KIN_RANGE_MM)) {
+        return mm > 0.0f ? kin.max_nm : 0;   // NaN reads as 0
+    }
+    if (mm <= -KIN_RANGE_MM) {
+        return -kin.max_nm;
+    }
+    int32_t whole = (int32_t)mm;
+    return whole * KIN_NM_PER_MM + round_to_int((mm - (float)whole) * KIN_NM_PER_MM);
+}
+
+float kin_nm_to_mm(kin_nm_t position) {
+    return (float)position * 1e-6f;
+}
+
+// One multiply and a round, clamped to the validated range
+kin_steps_t kin_mm_to_steps(float mm) {
+    float steps = mm * kin.steps_per_mm;
+    if (!(steps < kin.max_steps)) {
+        return steps > 0.0f ? kin.max_steps : 0;   // NaN reads as 0
+    }
+    if (steps <= -kin.max_steps) {
+        return -kin.max_steps;
+    }
+    return round_to_int(steps);
+}
+
+float kin_steps_to_mm(kin_steps_t steps) {
+    return (float)steps * kin.mm_per_step;
+}
+
+uint16_t kin_speed_to_steps(float speed_mm_s) {
+    float steps = speed_mm_s * kin.steps_per_mm;
+    if (!(steps > 0.0f)) {
+        return 0;
+    }
+    return steps >= UINT16_MAX ? UINT16_MAX : (uint16_t)round_to_int(steps);
+}
+
+float kin_max_speed(void) {
+    return UINT16_MAX / kin.steps_per_mm;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+// Axis kinematics in the step domain. Positions the drive sees are
+// integer microsteps; lengths are fixed-point mm with 1 unit = 1 nm
+// (1e-6 mm), enough for +-2147 mm. Conversions between the two are exact
+// rationals rounded to nearest (half away from zero), done with integer
+// multiplies only, so they are symmetric around 0 and a step converted
+// to nm and back is the same step. Targets are converted from absolute
+// positions, never accumulated, so nothing drifts over many holes.
+//
+// Float mm (planner, UI) converts with one multiply and a round. Single
+// precision keeps the product within 0.2 step over KIN_RANGE_MM (0.03
+// step over 200 mm), so only a value that close to a half step may round
+// to the neighbour, and the same value always gives the same step.
+//
+// The mechanics are a compile-time profile (build with -DKIN_PROFILE=...);
+// kinematics_init() derives the conversion ratios and checks that they
+// are exact and cannot overflow over KIN_RANGE_MM.
+
+typedef int32_t kin_steps_t;    // microsteps from home
+typedef int32_t kin_nm_t;       // fixed-point mm, 1e-6 mm per unit
+
+#define KIN_NM_PER_MM           1000000
+#define KIN_RANGE_MM            1000        // |position| the conversions must cover
+#define KIN_ENCODER_COUNTS      65536       // drive encoder counts per motor revolution
+
+// Mechanical profiles
+#define KIN_PROFILE_T8_2MM      1   // T8 screw, 2 mm lead, direct drive
+#define KIN_PROFILE_T8_8MM      2   // T8 screw, 8 mm lead (4 starts), direct drive
+#define KIN_PROFILE_SFU1204_2X  3   // SFU1204 ball screw, 2:1 belt reduction
+
+#ifndef KIN_PROFILE
+#define KIN_PROFILE KIN_PROFILE_T8_2MM
+#endif
+
+#if KIN_PROFILE == KIN_PROFILE_T8_2MM
+#define KIN_PROFILE_NAME        "T8 2 mm lead, 16x"
+#define KIN_STEPS_PER_REV       200     // 1.8° step angle
+#define KIN_MICROSTEPS          16
+#define KIN_MOTOR_REVS          1       // motor revolutions ...
+#define KIN_SCREW_REVS          1       // ... per this many screw revolutions
+#define KIN_LEAD_NM             2000000
+#elif KIN_PROFILE == KIN_PROFILE_T8_8MM
+#define KIN_PROFILE_NAME        "T8 8 mm lead, 16x"
+#define KIN_STEPS_PER_REV       200
+#define KIN_MICROSTEPS          16
+#define KIN_MOTOR_REVS          1
+#define KIN_SCREW_REVS          1
+#define KIN_LEAD_NM             8000000
+#elif KIN_PROFILE == KIN_PROFILE_SFU1204_2X
+#define KIN_PROFILE_NAME        "SFU1204 4 mm lead, 2:1 belt, 16x"
+#define KIN_STEPS_PER_REV       200
+#define KIN_MICROSTEPS          16
+#define KIN_MOTOR_REVS          2
+#define KIN_SCREW_REVS          1
+#define KIN_LEAD_NM             4000000
+#else
+#error "Unknown KIN_PROFILE"
+#endif
+
+_Static_assert(KIN_STEPS_PER_REV > 0 && KIN_MOTOR_REVS > 0 && KIN_SCREW_REVS > 0 && KIN_LEAD_NM > 0,
+               "kinematics profile values must be positive");
+_Static_assert(KIN_MICROSTEPS > 0 && KIN_MICROSTEPS <= 256 && (KIN_MICROSTEPS & (KIN_MICROSTEPS - 1)) == 0,
+               "microstepping must be a power of two up to 256");
+
+// For configuration and display only; conversions never use it
+#define KIN_STEPS_PER_MM ((float)KIN_STEPS_PER_REV * KIN_MICROSTEPS * KIN_MOTOR_REVS * KIN_NM_PER_MM / \
+                          ((float)KIN_LEAD_NM * KIN_SCREW_REVS))
+
+typedef struct {
+    const char* name;
+    uint32_t steps_per_rev;     // full steps per motor revolution
+    uint32_t microsteps;
+    uint32_t motor_revs;        // gearing: motor revolutions ...
+    uint32_t screw_revs;        // ... per this many screw revolutions
+    uint32_t lead_nm;           // travel per screw revolution
+} kin_profile_t;
+
+// Derive and validate the conversion ratios; fails with
+// ESP_ERR_INVALID_ARG if the profile cannot be converted exactly
+esp_err_t kinematics_init(void);
+const kin_profile_t* kin_get_profile(void);
+
+// Integer core
+kin_steps_t kin_nm_to_steps(kin_nm_t position);
+kin_nm_t kin_steps_to_nm(kin_steps_t steps);
+
+// Motor encoder reading (turns + fraction of KIN_ENCODER_COUNTS) as axis
+// position, at the encoder's resolution rather than a step's
+kin_nm_t kin_encoder_to_nm(int32_t turns, uint16_t fraction);
+
+// Boundary with the float mm used by the planner and the UI
+kin_nm_t kin_mm_to_nm(float mm);
+float kin_nm_to_mm(kin_nm_t position);
+kin_steps_t kin_mm_to_steps(float mm);
+float kin_steps_to_mm(kin_steps_t steps);
+
+// Speed in steps/s as the drive takes it, saturated to its 16-bit field
+uint16_t kin_speed_to_steps(float speed_mm_s);
+float kin_max_speed(void);     // mm/s
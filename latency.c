@@ -0,0 +1,127 @@
+#include "latency.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+
+static const char* TAG = "latency";
+
+typedef struct {
+    atomic_uint max_cycles;
+    atomic_uint buckets[LATENCY_BUCKETS];
+} histogram_t;
+
+static histogram_t histograms[LATENCY_PROBE_COUNT];
+
+static const char* const probe_names[LATENCY_PROBE_COUNT] = {
+    [LATENCY_SERVO_POLL]       = "servo poll",
+    [LATENCY_SERVO_ROUND_TRIP] = "servo round trip",
+    [LATENCY_UART_LOCK]        = "uart lock wait",
+    [LATENCY_DISPLAY_FLUSH]    = "display flush",
+    [LATENCY_TOUCH_I2C]        = "touch i2c",
+    [LATENCY_TOUCH_READ]       = "touch read",
+    [LATENCY_LVGL_HANDLER]     = "lvgl handler",
+};
+
+#if LATENCY_PROBES
+
+void latency_record(latency_probe_t probe, uint32_t cycles) {
+    if ((unsigned int)probe >= LATENCY_PROBE_COUNT) {
+        return;
+    }
+    histogram_t* h = &histograms[probe];
+
+    int bucket = cycles ? 31 - __builtin_clz(cycles) : 0;
+    atomic_fetch_add_explicit(&h->buckets[bucket], 1, memory_order_relaxed);
+
+    unsigned int max = atomic_load_explicit(&h->max_cycles, memory_order_relaxed);
+    while (cycles > max &&
+           !atomic_compare_exchange_weak_explicit(&h->max_cycles, &max, cycles,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+#endif
+
+const char* latency_probe_name(latency_probe_t probe) {
+    if ((unsigned int)probe >= LATENCY_PROBE_COUNT) {
+        return "?";
+    }
+    return probe_names[probe];
+}
+
+static float cycles_to_us(uint64_t cycles) {
+    return (float)cycles / (float)esp_rom_get_cpu_ticks_per_us();
+}
+
+// Upper bound of the bucket holding the given fraction of the samples
+static float percentile_us(const latency_stats_t* stats, uint32_t max_cycles, float fraction) {
+    uint32_t rank = (uint32_t)(stats->count * fraction);
+    uint32_t seen = 0;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += stats->buckets[i];
+        if (seen > rank) {
+            uint64_t upper = (1ULL << (i + 1)) - 1;
+            return cycles_to_us(upper < max_cycles ? upper : max_cycles);
+        }
+    }
+    return cycles_to_us(max_cycles);
+}
+
+void latency_get_stats(latency_probe_t probe, latency_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if ((unsigned int)probe >= LATENCY_PROBE_COUNT) {
+        return;
+    }
+    histogram_t* h = &histograms[probe];
+
+    // The count is the bucket sum, so the percentiles agree with it even
+    // while recording goes on
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        stats->buckets[i] = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        stats->count += stats->buckets[i];
+    }
+    if (stats->count == 0) {
+        return;
+    }
+
+    uint32_t max_cycles = atomic_load_explicit(&h->max_cycles, memory_order_relaxed);
+    stats->p50_us = percentile_us(stats, max_cycles, 0.50f);
+    stats->p90_us = percentile_us(stats, max_cycles, 0.90f);
+    stats->p99_us = percentile_us(stats, max_cycles, 0.99f);
+    stats->max_us = cycles_to_us(max_cycles);
+}
+
+void latency_reset(void) {
+    for (int p = 0; p < LATENCY_PROBE_COUNT; p++) {
+        histogram_t* h = &histograms[p];
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            atomic_store_explicit(&h->buckets[i], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&h->max_cycles, 0, memory_order_relaxed);
+    }
+    ESP_LOGI(TAG, "Latency histograms reset");
+}
+
+void latency_dump_console(void) {
+    latency_stats_t stats;
+
+    printf("%-18s %10s %10s %10s %10s %10s\n", "probe", "count", "p50 us", "p90 us", "p99 us", "max us");
+    for (int p = 0; p < LATENCY_PROBE_COUNT; p++) {
+        latency_get_stats(p, &stats);
+        printf("%-18s %10u %10.1f %10.1f %10.1f %10.1f\n", probe_names[p], (unsigned int)stats.count,
+               stats.p50_us, stats.p90_us, stats.p99_us, stats.max_us);
+
+        // Buckets as "<upper bound us>:<count>", empty ones left out
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            if (stats.buckets[i]) {
+                printf("  <%.2f:%u", cycles_to_us(2ULL << i), (unsigned int)stats.buckets[i]);
+            }
+        }
+        if (stats.count) {
+            printf("\n");
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_cpu.h"
+
+// Latency probes: a fixed set of named code paths, each with a log2
+// histogram of durations measured with the CPU cycle counter. Bucket i
+// counts durations of [2^i, 2^(i+1)) cycles, so 32 buckets cover
+// everything from one cycle to ~18 s at 240 MHz.
+//
+//   uint32_t start = latency_now();
+//   ... measured path ...
+//   latency_end(LATENCY_DISPLAY_FLUSH, start);
+//
+// Recording is an atomic add (plus a compare-and-swap on a new maximum)
+// and never blocks, so it is safe from any task on either core. The
+// cycle counter is per core: start and end of one measurement must run
+// on the same core (all tasks are pinned).
+//
+// Build with LATENCY_PROBES=0 to compile every probe out.
+
+#ifndef LATENCY_PROBES
+#define LATENCY_PROBES  1
+#endif
+
+#define LATENCY_BUCKETS 32
+
+typedef enum {
+    LATENCY_SERVO_POLL,         // interval between status polls while moving
+    LATENCY_SERVO_ROUND_TRIP,   // request sent to reply processed
+    LATENCY_UART_LOCK,          // wait for the servo UART mutex
+    LATENCY_DISPLAY_FLUSH,      // st7262_flush()
+    LATENCY_TOUCH_I2C,          // GT911 report read and clear
+    LATENCY_TOUCH_READ,         // gt911_read() (LVGL input callback)
+    LATENCY_LVGL_HANDLER,       // lv_task_handler()
+    LATENCY_PROBE_COUNT,
+} latency_probe_t;
+
+typedef struct {
+    uint32_t count;
+    // Percentiles are bucket upper bounds, so at most 2x pessimistic
+    float p50_us;
+    float p90_us;
+    float p99_us;
+    float max_us;
+    uint32_t buckets[LATENCY_BUCKETS];
+} latency_stats_t;
+
+#if LATENCY_PROBES
+
+static inline uint32_t latency_now(void) {
+    return esp_cpu_get_cycle_count();
+}
+
+void latency_record(latency_probe_t probe, uint32_t cycles);
+
+static inline void latency_end(latency_probe_t probe, uint32_t start) {
+    latency_record(probe, latency_now() - start);
+}
+
+#else
+
+static inline uint32_t latency_now(void) {
+    return 0;
+}
+
+static inline void latency_record(latency_probe_t probe, uint32_t cycles) {
+    (void)probe;
+    (void)cycles;
+}
+
+static inline void latency_end(latency_probe_t probe, uint32_t start) {
+    (void)probe;
+    (void)start;
+}
+
+#endif
+
+const char* latency_probe_name(latency_probe_t probe);
+
+// Snapshot of one probe; counts recorded meanwhile may or may not be in it
+void latency_get_stats(latency_probe_t probe, latency_stats_t* stats);
+
+void latency_reset(void);
+
+// Every probe's summary and non-empty buckets, printed on the console
+void latency_dump_console(void);
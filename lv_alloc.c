@@ -0,0 +1,375 @@
+#include "lv_alloc.h"
+#include <stdbool.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char* TAG = "lv_alloc";
+
+#define ALIGN8(n)       (((n) + 7U) & ~(size_t)7U)
+#define BLOCK_MAGIC     0x4c56
+#define CLASS_COUNT     5
+#define CLASS_SIZE(cls) (16U << (cls))     // 16 .. 256 bytes
+
+#if LV_ALLOC_PSRAM
+#define HEAP_CAPS (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define HEAP_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+_Static_assert(CLASS_SIZE(CLASS_COUNT - 1) == LV_ALLOC_POOL_MAX, "last class is the pool limit");
+_Static_assert(LV_ALLOC_MAX_ARENAS <= 256, "arena index is 8 bits");
+
+typedef enum {
+    KIND_POOL,
+    KIND_ARENA,
+    KIND_HEAP,
+} block_kind_t;
+
+// In front of every block handed to LVGL
+typedef struct {
+    uint32_t size;      // bytes requested
+    uint8_t kind;       // block_kind_t
+    uint8_t index;      // size class or arena
+    uint16_t magic;     // cleared on free
+} block_hdr_t;
+
+_Static_assert(sizeof(block_hdr_t) == 8, "keeps blocks 8-byte aligned");
+
+typedef struct free_slot {
+    struct free_slot* next;
+} free_slot_t;
+
+typedef struct {
+    free_slot_t* free;
+    uint32_t pages;
+    uint32_t live;      // slots handed out
+} pool_t;
+
+typedef struct arena_chunk {
+    struct arena_chunk* next;
+    size_t size;        // bytes after the chunk header
+    size_t top;         // bytes handed out
+} arena_chunk_t;
+
+#define CHUNK_HDR     ALIGN8(sizeof(arena_chunk_t))
+#define CHUNK_PAYLOAD (LV_ALLOC_ARENA_CHUNK - CHUNK_HDR)
+
+struct lv_alloc_arena {
+    const char* name;
+    arena_chunk_t* chunks;  // the one being filled first
+    uint32_t live;          // blocks not yet freed
+    size_t live_bytes;      // their slots, headers included
+    size_t bumped;          // chunk bytes handed out or left behind
+};
+
+static struct {
+    pool_t pools[CLASS_COUNT];
+    struct lv_alloc_arena arenas[LV_ALLOC_MAX_ARENAS];
+    size_t arena_count;
+    lv_alloc_arena_t* current;  // between begin and end
+    lv_alloc_stats_t stats;     // running totals; the rest is computed on read
+} mem;
+
+static void* reserve(size_t bytes) {
+    if (mem.stats.reserved + bytes > LV_ALLOC_LIMIT) {
+        return NULL;
+    }
+
+    void* block = heap_caps_malloc(bytes, HEAP_CAPS);
+#if LV_ALLOC_PSRAM
+    if (!block) {
+        block = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+#endif
+    if (block) {
+        mem.stats.reserved += bytes;
+        if (mem.stats.reserved > mem.stats.peak_reserved) {
+            mem.stats.peak_reserved = mem.stats.reserved;
+        }
+    }
+    return block;
+}
+
+static void release(void* block, size_t bytes) {
+    heap_caps_free(block);
+    mem.stats.reserved -= bytes;
+}
+
+// Smallest class that holds size, -1 if none does
+static int class_of(size_t size) {
+    for (int cls = 0; cls < CLASS_COUNT; cls++) {
+        if (size <= CLASS_SIZE(cls)) {
+            return cls;
+        }
+    }
+    return -1;
+}
+
+static size_t slot_size(int cls) {
+    return sizeof(block_hdr_t) + CLASS_SIZE(cls);
+}
+
+// Arena slot for a block of size bytes
+static size_t arena_need(size_t size) {
+    return ALIGN8(sizeof(block_hdr_t) + size);
+}
+
+static block_hdr_t* pool_alloc(int cls) {
+    pool_t* pool = &mem.pools[cls];
+
+    if (!pool->free) {
+        char* page = reserve(LV_ALLOC_PAGE_SIZE);
+        if (!page) {
+            return NULL;
+        }
+        size_t slot = slot_size(cls);
+        for (size_t off = 0; off + slot <= LV_ALLOC_PAGE_SIZE; off += slot) {
+            free_slot_t* free_slot = (free_slot_t*)(page + off);
+            free_slot->next = pool->free;
+            pool->free = free_slot;
+        }
+        pool->pages++;
+    }
+
+    free_slot_t* free_slot = pool->free;
+    pool->free = free_slot->next;
+    pool->live++;
+    return (block_hdr_t*)free_slot;
+}
+
+static void pool_free(block_hdr_t* hdr) {
+    pool_t* pool = &mem.pools[hdr->index];
+    free_slot_t* free_slot = (free_slot_t*)hdr;
+    free_slot->next = pool->free;
+    pool->free = free_slot;
+    pool->live--;
+}
+
+static block_hdr_t* arena_alloc(lv_alloc_arena_t* arena, size_t need) {
+    arena_chunk_t* chunk = arena->chunks;
+
+    if (need > CHUNK_PAYLOAD) {
+        // A chunk of its own, behind the one being filled
+        arena_chunk_t* big = reserve(CHUNK_HDR + need);
+        if (!big) {
+            return NULL;
+        }
+        big->size = big->top = need;
+        if (chunk) {
+            big->next = chunk->next;
+            chunk->next = big;
+        } else {
+            big->next = NULL;
+            arena->chunks = big;
+        }
+        chunk = big;
+    } else {
+        if (!chunk || chunk->top + need > chunk->size) {
+            arena_chunk_t* fresh = reserve(LV_ALLOC_ARENA_CHUNK);
+            if (!fresh) {
+                return NULL;
+            }
+            if (chunk) {
+                arena->bumped += chunk->size - chunk->top;
+            }
+            fresh->next = chunk;
+            fresh->size = CHUNK_PAYLOAD;
+            fresh->top = 0;
+            arena->chunks = chunk = fresh;
+        }
+        chunk->top += need;
+    }
+
+    arena->bumped += need;
+    arena->live++;
+    arena->live_bytes += need;
+    return (block_hdr_t*)((char*)chunk + CHUNK_HDR + chunk->top - need);
+}
+
+static void arena_reset(lv_alloc_arena_t* arena) {
+    while (arena->chunks) {
+        arena_chunk_t* chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        release(chunk, CHUNK_HDR + chunk->size);
+    }
+    arena->bumped = 0;
+}
+
+static void arena_free(lv_alloc_arena_t* arena, size_t need) {
+    arena->live--;
+    arena->live_bytes -= need;
+    // Wait for end() while the screen is still being built
+    if (!arena->live && arena != mem.current) {
+        arena_reset(arena);
+    }
+}
+
+static void* alloc_block(size_t size, lv_alloc_arena_t* arena) {
+    block_hdr_t* hdr = NULL;
+    uint8_t kind = KIND_HEAP;
+    uint8_t index = 0;
+
+    if (size > UINT32_MAX - LV_ALLOC_ARENA_CHUNK) {
+        // Too big for the header; fails below
+    } else if (arena) {
+        hdr = arena_alloc(arena, arena_need(size));
+        kind = KIND_ARENA;
+        index = arena - mem.arenas;
+    } else if (size <= LV_ALLOC_POOL_MAX) {
+        index = class_of(size);
+        hdr = pool_alloc(index);
+        kind = KIND_POOL;
+    } else {
+        hdr = reserve(sizeof(block_hdr_t) + size);
+    }
+
+    if (!hdr) {
+        mem.stats.failed++;
+        ESP_LOGE(TAG, "Out of memory for %u bytes (%u of %u reserved)", (unsigned int)size,
+                 (unsigned int)mem.stats.reserved, (unsigned int)LV_ALLOC_LIMIT);
+        return NULL;
+    }
+
+    hdr->size = size;
+    hdr->kind = kind;
+    hdr->index = index;
+    hdr->magic = BLOCK_MAGIC;
+
+    mem.stats.allocs++;
+    mem.stats.used += size;
+    if (mem.stats.used > mem.stats.peak_used) {
+        mem.stats.peak_used = mem.stats.used;
+    }
+    return hdr + 1;
+}
+
+static block_hdr_t* header_of(void* ptr) {
+    block_hdr_t* hdr = (block_hdr_t*)ptr - 1;
+    if (hdr->magic != BLOCK_MAGIC) {
+        ESP_LOGE(TAG, "%p is not a live block", ptr);
+        return NULL;
+    }
+    return hdr;
+}
+
+void* lv_alloc_malloc(size_t size) {
+    return alloc_block(size, mem.current);
+}
+
+void lv_alloc_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    block_hdr_t* hdr = header_of(ptr);
+    if (!hdr) {
+        return;
+    }
+
+    mem.stats.used -= hdr->size;
+    hdr->magic = 0;
+    switch (hdr->kind) {
+        case KIND_POOL:
+            pool_free(hdr);
+            break;
+        case KIND_ARENA:
+            arena_free(&mem.arenas[hdr->index], arena_need(hdr->size));
+            break;
+        default:
+            release(hdr, sizeof(block_hdr_t) + hdr->size);
+            break;
+    }
+}
+
+void* lv_alloc_realloc(void* ptr, size_t size) {
+    if (!ptr) {
+        return lv_alloc_malloc(size);
+    }
+    block_hdr_t* hdr = header_of(ptr);
+    if (!hdr) {
+        return NULL;
+    }
+
+    bool fits;
+    switch (hdr->kind) {
+        case KIND_POOL:
+            fits = class_of(size) == hdr->index;
+            break;
+        case KIND_ARENA:
+            fits = arena_need(size) == arena_need(hdr->size);
+            break;
+        default:
+            fits = size == hdr->size;
+            break;
+    }
+    if (fits) {
+        mem.stats.used = mem.stats.used - hdr->size + size;
+        if (mem.stats.used > mem.stats.peak_used) {
+            mem.stats.peak_used = mem.stats.used;
+        }
+        hdr->size = size;
+        return ptr;
+    }
+
+    // Only blocks of the arena being filled move within it
+    lv_alloc_arena_t* arena = NULL;
+    if (hdr->kind == KIND_ARENA && &mem.arenas[hdr->index] == mem.current) {
+        arena = mem.current;
+    }
+    void* moved = alloc_block(size, arena);
+    if (!moved) {
+        return NULL;
+    }
+    memcpy(moved, ptr, hdr->size < size ? hdr->size : size);
+    lv_alloc_free(ptr);
+    return moved;
+}
+
+lv_alloc_arena_t* lv_alloc_arena_create(const char* name) {
+    if (mem.arena_count >= LV_ALLOC_MAX_ARENAS) {
+        ESP_LOGW(TAG, "No arena left for %s", name);
+        return NULL;
+    }
+    lv_alloc_arena_t* arena = &mem.arenas[mem.arena_count++];
+    arena->name = name;
+    return arena;
+}
+
+void lv_alloc_arena_begin(lv_alloc_arena_t* arena) {
+    if (mem.current) {
+        ESP_LOGW(TAG, "Arena %s is still open", mem.current->name);
+    }
+    mem.current = arena;
+}
+
+void lv_alloc_arena_end(void) {
+    lv_alloc_arena_t* arena = mem.current;
+    mem.current = NULL;
+    if (arena && !arena->live) {
+        arena_reset(arena);
+    }
+}
+
+size_t lv_alloc_arena_used(const lv_alloc_arena_t* arena) {
+    return arena->live_bytes;
+}
+
+void lv_alloc_get_stats(lv_alloc_stats_t* stats) {
+    *stats = mem.stats;
+
+    for (int cls = 0; cls < CLASS_COUNT; cls++) {
+        const pool_t* pool = &mem.pools[cls];
+        stats->pool_idle += pool->pages * LV_ALLOC_PAGE_SIZE - pool->live * slot_size(cls);
+    }
+    for (size_t i = 0; i < mem.arena_count; i++) {
+        stats->arena_dead += mem.arenas[i].bumped - mem.arenas[i].live_bytes;
+    }
+    if (stats->reserved) {
+        stats->frag_pct = (stats->pool_idle + stats->arena_dead) * 100 / stats->reserved;
+    }
+
+    size_t free_bytes = heap_caps_get_free_size(HEAP_CAPS);
+    if (free_bytes) {
+        stats->heap_frag_pct = 100 - heap_caps_get_largest_free_block(HEAP_CAPS) * 100 / free_bytes;
+    }
+}
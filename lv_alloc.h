@@ -0,0 +1,74 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// LVGL heap backend (LV_MEM_CUSTOM_* in lv_conf.h). Replaces LVGL's
+// single 48 KB TLSF pool, which widget, timer and label-text churn
+// fragments over a long shift, with:
+//
+//  - size-class pools for blocks up to LV_ALLOC_POOL_MAX bytes (objects,
+//    styles, event lists, label text). A freed slot goes back on its
+//    class's free list and is reused by the next block of that class, so
+//    small blocks never split or scatter the heap. Pool pages stay with
+//    their class.
+//  - arenas for everything a screen allocates while it is being built.
+//    Blocks are bump-allocated from the arena's chunks and a free only
+//    drops the arena's live count; once the screen's last block is freed
+//    the chunks go back to the system heap in one piece.
+//  - plain system heap blocks for anything larger.
+//
+// Memory comes from the system heap in pages and chunks, at most
+// LV_ALLOC_LIMIT bytes in all, from PSRAM when LV_ALLOC_PSRAM is set
+// (falling back to internal RAM once PSRAM is full).
+//
+// LVGL task only, like the rest of LVGL. Included by LVGL itself, so
+// this header must not include lvgl.h.
+
+#ifndef LV_ALLOC_LIMIT
+#define LV_ALLOC_LIMIT (96U * 1024U)    // bytes taken from the system heap at most
+#endif
+
+#ifndef LV_ALLOC_PSRAM
+#define LV_ALLOC_PSRAM 0                // 1: pages, chunks and large blocks in PSRAM
+#endif
+
+#define LV_ALLOC_POOL_MAX     256       // bytes, largest pooled block
+#define LV_ALLOC_PAGE_SIZE    2048      // bytes per pool page
+#define LV_ALLOC_ARENA_CHUNK  4096      // bytes per arena chunk
+#define LV_ALLOC_MAX_ARENAS   8
+
+typedef struct {
+    size_t used;            // bytes LVGL holds, as requested
+    size_t peak_used;
+    size_t reserved;        // bytes taken from the system heap
+    size_t peak_reserved;
+    size_t pool_idle;       // free slots in pool pages
+    size_t arena_dead;      // freed blocks in arenas that still hold live ones
+    uint32_t allocs;
+    uint32_t failed;        // requests answered with NULL
+    uint8_t frag_pct;       // reserved memory held idle or dead
+    uint8_t heap_frag_pct;  // system heap: free memory outside its largest free block
+} lv_alloc_stats_t;
+
+typedef struct lv_alloc_arena lv_alloc_arena_t;
+
+// LV_MEM_CUSTOM_ALLOC / _FREE / _REALLOC
+void* lv_alloc_malloc(size_t size);
+void lv_alloc_free(void* ptr);
+void* lv_alloc_realloc(void* ptr, size_t size);
+
+// An arena from a fixed table of LV_ALLOC_MAX_ARENAS, NULL when all are
+// taken. Arenas are never destroyed, only emptied.
+lv_alloc_arena_t* lv_alloc_arena_create(const char* name);
+
+// Between begin and end, new blocks (and growing blocks that already
+// live in the arena) come from the arena. Blocks allocated before begin
+// keep their place when reallocated, so LVGL's own long-lived arrays
+// never land in a screen's arena. No nesting.
+void lv_alloc_arena_begin(lv_alloc_arena_t* arena);
+void lv_alloc_arena_end(void);
+
+// Bytes of the arena's blocks still allocated
+size_t lv_alloc_arena_used(const lv_alloc_arena_t* arena);
+
+void lv_alloc_get_stats(lv_alloc_stats_t* stats);
@@ -8,6 +8,7 @@
 #define LV_CONF_H
 
 #include <stdint.h>
+#include "esp_attr.h"  /* IRAM_ATTR used by LV_ATTRIBUTE_* below */
 
 /*====================
    COLOR SETTINGS
@@ -16,8 +17,17 @@
 /* Color depth: 1 (1 byte per pixel), 8 (RGB332), 16 (RGB565), 32 (ARGB8888) */
 #define LV_COLOR_DEPTH 16
 
-/* Swap the 2 bytes of RGB565 color. Useful if the display has an 8-bit interface */
-#define LV_COLOR_16_SWAP 1
+/* Display interface: 1 = parallel RGB scan-out from PSRAM framebuffers,
+ * 0 = SPI command mode (see st7262.h). RGB data G0-G2 and G5 are on
+ * GPIO5-7 and 4, the GT911 pins of gt911.h, so RGB stays off until the
+ * touch controller moves; the boot check refuses the overlap. */
+#ifndef ST7262_RGB_MODE
+#define ST7262_RGB_MODE 0
+#endif
+
+/* Swap the 2 bytes of RGB565 color. Useful if the display has an 8-bit interface.
+ * The RGB interface takes pixels in native order, the SPI path byte-swapped. */
+#define LV_COLOR_16_SWAP (!ST7262_RGB_MODE)
 
 /* Enable more complex drawing routines to manage them manually.
  * Required for widgets like arc, chart, line, roller. */
@@ -27,13 +37,18 @@
    MEMORY SETTINGS
  *====================*/
 
-/* Size of the memory used by `lv_mem_alloc` in bytes (>= 2kB)
- * Only used if LV_MEM_CUSTOM == 0 */
-#define LV_MEM_SIZE (48U * 1024U)
-
-/* Set an address for the memory pool instead of allocating it as a normal array.
- * Can be in external SRAM too. */
-#define LV_MEM_CUSTOM 0
+/* 1: use custom malloc/free, 0: use the built-in `lv_mem_alloc()` and `lv_mem_free()`
+ * Pools for small blocks, arenas for screens, stats: see lv_alloc.h */
+#define LV_MEM_CUSTOM 1
+#if LV_MEM_CUSTOM == 0
+    /* Size of the memory used by `lv_mem_alloc` in bytes (>= 2kB) */
+    #define LV_MEM_SIZE (48U * 1024U)
+#else
+    #define LV_MEM_CUSTOM_INCLUDE "lv_alloc.h"
+    #define LV_MEM_CUSTOM_ALLOC   lv_alloc_malloc
+    #define LV_MEM_CUSTOM_FREE    lv_alloc_free
+    #define LV_MEM_CUSTOM_REALLOC lv_alloc_realloc
+#endif
 
 /* Use the standard `memcpy` and `memset` instead of LVGL's own functions.
  * The standard functions might be faster depending on their implementation. */
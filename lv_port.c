@@ -1,4 +1,7 @@
+#include "lv_port.h"
 #include "lvgl.h"
+#include "st7262.h"
+#include "gt911.h"
 #include "esp_timer.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
@@ -8,32 +11,42 @@ static const char* TAG = "lv_port";
 
 #define LVGL_TICK_PERIOD_MS 1
 
+static lv_indev_drv_t indev_drv;
+
 static void lv_tick_task(void *arg) {
     (void) arg;
     lv_tick_inc(LVGL_TICK_PERIOD_MS);
 }
 
-void lv_port_init(void) {
+esp_err_t lv_port_init_display(void) {
     static lv_disp_draw_buf_t draw_buf;
-    static lv_color_t buf1[LVGL_LCD_BUF_SIZE];
-    static lv_color_t buf2[LVGL_LCD_BUF_SIZE];
     
     lv_init();
-    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, LVGL_LCD_BUF_SIZE);
     
     static lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
+
+#if ST7262_RGB_MODE
+    // Draw directly into the panel's two full-size PSRAM framebuffers
+    void* fb1;
+    void* fb2;
+    st7262_get_framebuffers(&fb1, &fb2);
+    lv_disp_draw_buf_init(&draw_buf, fb1, fb2, ST7262_WIDTH * ST7262_HEIGHT);
+    disp_drv.direct_mode = 1;
+#else
+    static lv_color_t buf1[LVGL_LCD_BUF_SIZE];
+    static lv_color_t buf2[LVGL_LCD_BUF_SIZE];
+    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, LVGL_LCD_BUF_SIZE);
+#endif
+
     disp_drv.flush_cb = st7262_flush;
+    disp_drv.wait_cb = st7262_wait;
     disp_drv.draw_buf = &draw_buf;
-    disp_drv.hor_res = 800;
-    disp_drv.ver_res = 480;
-    lv_disp_drv_register(&disp_drv);
-    
-    static lv_indev_drv_t indev_drv;
-    lv_indev_drv_init(&indev_drv);
-    indev_drv.type = LV_INDEV_TYPE_POINTER;
-    indev_drv.read_cb = gt911_read;
-    lv_indev_drv_register(&indev_drv);
+    disp_drv.hor_res = ST7262_WIDTH;
+    disp_drv.ver_res = ST7262_HEIGHT;
+    if (!lv_disp_drv_register(&disp_drv)) {
+        return ESP_ERR_NO_MEM;
+    }
     
     // Create tick task
     const esp_timer_create_args_t periodic_timer_args = {
@@ -41,8 +54,31 @@ void lv_port_init(void) {
         .name = "lvgl_tick"
     };
     esp_timer_handle_t periodic_timer;
-    ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_timer, LVGL_TICK_PERIOD_MS * 1000));
+    esp_err_t err = esp_timer_create(&periodic_timer_args, &periodic_timer);
+    if (err == ESP_OK) {
+        err = esp_timer_start_periodic(periodic_timer, LVGL_TICK_PERIOD_MS * 1000);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start LVGL tick: %s", esp_err_to_name(err));
+        return err;
+    }
     
     ESP_LOGI(TAG, "LVGL initialized");
+    return ESP_OK;
+}
+
+esp_err_t lv_port_init_input(void) {
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = gt911_read;
+    if (!lv_indev_drv_register(&indev_drv)) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void lv_port_wait(uint32_t max_ms) {
+    if (gt911_wait_input(pdMS_TO_TICKS(max_ms)) && indev_drv.read_timer) {
+        lv_timer_ready(indev_drv.read_timer);
+    }
 }
\ No newline at end of file
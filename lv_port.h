@@ -1,10 +1,20 @@
 #pragma once
+#include "esp_err.h"
 #include "lvgl.h"
 
 // Buffer size for 800x480 display with 16-bit color depth
-// Using double buffering with 40 lines (800 * 40 * 2 bytes per pixel)
+// Using double buffering with 40 lines (800 * 40 * 2 bytes per pixel).
+// SPI mode only; in RGB mode LVGL draws into the panel framebuffers.
 #define LVGL_LCD_BUF_SIZE (800 * 40)
 
-// Function declarations
-void lv_port_init(void);
-void lv_port_indev_read(void);
\ No newline at end of file
+// Display half: LVGL itself, the draw buffers, the panel as LVGL
+// display and the tick. The panel must be up (st7262_init()).
+esp_err_t lv_port_init_display(void);
+
+// Input half: the touch controller as LVGL pointer. After
+// lv_port_init_display() and gt911_init().
+esp_err_t lv_port_init_input(void);
+
+// Sleeps up to max_ms between LVGL passes; returns early on new touch
+// input and schedules an immediate input read
+void lv_port_wait(uint32_t max_ms);
\ No newline at end of file
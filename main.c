@@ -4,39 +4,72 @@
 #include "esp_system.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
+#include "driver/uart.h"
+#include "nvs_flash.h"
 #include "lvgl.h"
+#include "settings.h"
 #include "servo42c.h"
 #include "safety.h"
+#include "planner.h"
+#include "feed.h"
+#include "gcode.h"
+#include "cycles.h"
+#include "telemetry.h"
+#include "latency.h"
 #include "ui_common.h"
+#include "lv_port.h"
+#include "st7262.h"
+#include "gt911.h"
+#include "boot.h"
 
 static const char* TAG = "main";
 
 // Hardware configuration
-static const servo42c_config_t servo_config = {
-    .uart_num = UART_NUM_1,
-    .tx_pin = GPIO_NUM_4,
-    .rx_pin = GPIO_NUM_5,
-    .steps_per_mm = 200.0f  // T8 screw: 200 steps/rev, 1mm/rev
+static const servo42c_bus_config_t servo_bus_config = {
+    .uart_num = SERVO42C_UART_NUM,
+    .tx_pin = SERVO42C_TX_PIN,
+    .rx_pin = SERVO42C_RX_PIN,
+    .rts_pin = -1,                    // point-to-point UART, no RS485 driver
+    .baud_rate = SERVO42C_BAUD_RATE,
 };
 
+// Drill axis. X/Y positioning or further heads go on the same bus, each
+// drive set to its own address.
+static const servo42c_config_t z_axis_config = {
+    .name = "Z",
+    .address = SERVO42C_ADDRESS_DEFAULT,
+    .steps_per_mm = KIN_STEPS_PER_MM,  // checked against the compiled-in profile
+    .telemetry = true,
+};
+
+static servo42c_bus_handle_t servo_bus;
+static servo42c_handle_t z_axis;
+
 // Task handles
 static TaskHandle_t motion_task_handle;
 static TaskHandle_t ui_task_handle;
 static TaskHandle_t safety_task_handle;
+static TaskHandle_t telemetry_task_handle;
 
 // Motion control task
 static void motion_control_task(void* arg) {
     servo42c_state_t state;
+    servo42c_position_t position;
+    uint32_t shown_generation = UINT32_MAX;
     
     while (1) {
-        servo42c_get_state(&state);
-        
         if (safety_get_status() != SAFETY_OK) {
-            servo42c_emergency_stop();
+            servo42c_emergency_stop_all();
         }
         
-        // Update UI with current position
-        ui_update_position(state.current_position);
+        // Update UI with the live position estimate, only when the state
+        // changed (each encoder reading bumps the generation)
+        if (servo42c_get_generation(z_axis) != shown_generation) {
+            servo42c_get_state(z_axis, &state);
+            shown_generation = state.generation;
+            servo42c_get_position(z_axis, &position);
+            ui_update_position(position.estimated);
+        }
         
         vTaskDelay(pdMS_TO_TICKS(10)); // 100Hz update rate
     }
@@ -45,40 +78,254 @@ static void motion_control_task(void* arg) {
 // UI update task
 static void ui_update_task(void* arg) {
     while (1) {
+        ui_process_updates();
+        uint32_t start = latency_now();
         lv_task_handler();
-        vTaskDelay(pdMS_TO_TICKS(10));
+        latency_end(LATENCY_LVGL_HANDLER, start);
+        lv_port_wait(10);
     }
 }
 
 // Safety monitoring task
 static void safety_monitor_task(void* arg) {
+    safety_status_t reported = SAFETY_OK;
+
     while (1) {
-        safety_status_t status = safety_get_status();
+        // Sleeps until a safety ISR trips (or a reset clears) a fault;
+        // the first pass reports faults already latched at boot
+        safety_status_t status = safety_wait_event(portMAX_DELAY);
         
-        if (status != SAFETY_OK) {
+        // Telemetry freezes around the trip, not around faults added
+        // while one is already active
+        if (status != SAFETY_OK && reported == SAFETY_OK) {
+            telemetry_trigger();
+        }
+        if (status != SAFETY_OK && status != reported) {
             ESP_LOGE(TAG, "Safety error detected: %d", status);
+            servo42c_emergency_stop_all();
             ui_show_error("Safety error detected!");
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(1)); // 1kHz safety check
+        reported = status;
+    }
+}
+
+// Post-mortem export: once a trip has frozen the telemetry recorder,
+// print it on the console. Recording starts again only after the fault
+// is cleared.
+static void telemetry_task(void* arg) {
+    bool dumped = false;
+
+    while (1) {
+        if (telemetry_is_frozen()) {
+            if (!dumped) {
+                ESP_LOGW(TAG, "Dumping %u telemetry samples", (unsigned int)telemetry_count());
+                telemetry_dump_console();
+                dumped = true;
+            }
+            if (safety_get_status() == SAFETY_OK) {
+                telemetry_rearm();
+                dumped = false;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+}
+
+// Boot stages. Safety is armed before anything else runs; the rest
+// starts as soon as what it needs is up, on the core it will live on.
+// Touch and servo share core 1 and may run at once: check_pin_map()
+// runs first in both and stops both before either touches a pin unless
+// the panel, touch, servo UART and safety pins are all distinct.
+enum {
+    STAGE_SAFETY,
+    STAGE_SETTINGS,
+    STAGE_PANEL,
+    STAGE_TOUCH,
+    STAGE_SERVO,
+    STAGE_LINK,
+    STAGE_MOTION,
+    STAGE_DISPLAY,
+    STAGE_INPUT,
+    STAGE_SCREENS,
+    STAGE_COUNT,
+};
+
+#define LINK_TIMEOUT_MS 500     // first status reply of the drill drive
+
+// Limit inputs plus the task that stops the machine when one trips
+static esp_err_t stage_safety(void) {
+    esp_err_t err = safety_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (xTaskCreatePinnedToCore(safety_monitor_task, "safety", 2048,
+                                NULL, 6, &safety_task_handle, 1) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// The other components read their limits from the settings. A full or
+// older-format NVS partition is erased and starts over on the defaults.
+static esp_err_t stage_settings(void) {
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "Erasing NVS");
+        err = nvs_flash_erase();
+        if (err == ESP_OK) {
+            err = nvs_flash_init();
+        }
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    return settings_init();
+}
+
+static esp_err_t stage_panel(void) {
+    st7262_init();
+    return ESP_OK;
+}
+
+// Pins claimed by each part of the board. The touch controller's reset
+// sequence drives INT and RST as outputs and then listens on INT, so a
+// UART, panel or safety pin among them would be taken over and every
+// byte, pixel clock or switch edge would look like a touch; any other
+// overlap is just as broken. The touch and servo stages refuse to start
+// on a pin map where two groups share a GPIO.
+typedef struct {
+    const char* name;
+    const int* pins;
+    size_t count;
+} pin_group_t;
+
+#define PIN_GROUP(name, pins) { name, pins, sizeof(pins) / sizeof(pins[0]) }
+
+static esp_err_t check_pin_map(void) {
+    static const int panel_pins[] = ST7262_PINS;
+    static const int touch_pins[] = { GT911_I2C_SDA, GT911_I2C_SCL, GT911_RST_PIN, GT911_INT_PIN };
+    static const int safety_pins[] = { LIMIT_SWITCH_PIN_X, E_STOP_PIN, LOAD_SENSOR_PIN };
+    const int servo_pins[] = { servo_bus_config.tx_pin, servo_bus_config.rx_pin, servo_bus_config.rts_pin };
+    const pin_group_t groups[] = {
+        PIN_GROUP("panel", panel_pins),
+        PIN_GROUP("touch controller", touch_pins),
+        PIN_GROUP("servo UART", servo_pins),
+        PIN_GROUP("safety inputs", safety_pins),
+    };
+    const size_t group_count = sizeof(groups) / sizeof(groups[0]);
+
+    for (size_t a = 0; a < group_count; a++) {
+        for (size_t b = a + 1; b < group_count; b++) {
+            for (size_t i = 0; i < groups[a].count; i++) {
+                for (size_t j = 0; j < groups[b].count; j++) {
+                    int pin = groups[a].pins[i];
+                    if (pin >= 0 && pin == groups[b].pins[j]) {
+                        ESP_LOGE(TAG, "GPIO%d is used by both the %s and the %s",
+                                 pin, groups[a].name, groups[b].name);
+                        return ESP_ERR_INVALID_ARG;
+                    }
+                }
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t stage_touch(void) {
+    esp_err_t err = check_pin_map();
+    if (err != ESP_OK) {
+        return err;
     }
+    return gt911_init();
 }
 
+static esp_err_t stage_servo(void) {
+    esp_err_t err = check_pin_map();
+    if (err == ESP_OK) {
+        err = servo42c_bus_init(&servo_bus_config, &servo_bus);
+    }
+    if (err == ESP_OK) {
+        err = servo42c_add_axis(servo_bus, &z_axis_config, &z_axis);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (xTaskCreatePinnedToCore(telemetry_task, "telemetry", 3072,
+                                NULL, 1, &telemetry_task_handle, 0) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// A silent drive is reported, not fatal: the screens come up either way
+// and show the axis as not homed
+static esp_err_t stage_link(void) {
+    return servo42c_wait_link(z_axis, pdMS_TO_TICKS(LINK_TIMEOUT_MS));
+}
+
+static esp_err_t stage_motion(void) {
+    esp_err_t err = planner_init(z_axis);
+    if (err == ESP_OK) {
+        err = feed_init(z_axis);
+    }
+    if (err == ESP_OK) {
+        err = cycles_init();
+    }
+    if (err == ESP_OK) {
+        err = gcode_init();
+    }
+    if (err == ESP_OK) {
+        err = gcode_serial_start();
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (xTaskCreatePinnedToCore(motion_control_task, "motion_ctrl", 4096,
+                                NULL, 5, &motion_task_handle, 1) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t stage_display(void) {
+    return lv_port_init_display();
+}
+
+static esp_err_t stage_input(void) {
+    return lv_port_init_input();
+}
+
+// The last LVGL stage: once the UI task runs, LVGL belongs to it
+static esp_err_t stage_screens(void) {
+    ui_init(z_axis);
+    if (xTaskCreatePinnedToCore(ui_update_task, "ui_update", 4096,
+                                NULL, 3, &ui_task_handle, 0) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+#define AFTER_SAFETY BOOT_DEP(STAGE_SAFETY)
+
+static const boot_stage_t boot_stages[STAGE_COUNT] = {
+    [STAGE_SAFETY]   = { "safety", stage_safety, 0, 1 },
+    [STAGE_SETTINGS] = { "settings", stage_settings, AFTER_SAFETY, 1 },
+    [STAGE_PANEL]    = { "panel", stage_panel, AFTER_SAFETY, 0 },
+    [STAGE_TOUCH]    = { "touch", stage_touch, AFTER_SAFETY, 1 },
+    [STAGE_SERVO]    = { "servo", stage_servo, AFTER_SAFETY | BOOT_DEP(STAGE_SETTINGS), 1 },
+    [STAGE_LINK]     = { "link", stage_link, BOOT_DEP(STAGE_SERVO), 1, .optional = true },
+    [STAGE_MOTION]   = { "motion", stage_motion, BOOT_DEP(STAGE_SERVO), 1 },
+    [STAGE_DISPLAY]  = { "display", stage_display, BOOT_DEP(STAGE_PANEL), 0 },
+    [STAGE_INPUT]    = { "input", stage_input, BOOT_DEP(STAGE_DISPLAY) | BOOT_DEP(STAGE_TOUCH), 0 },
+    [STAGE_SCREENS]  = { "screens", stage_screens,
+                         BOOT_DEP(STAGE_INPUT) | BOOT_DEP(STAGE_SETTINGS) | BOOT_DEP(STAGE_MOTION), 0,
+                         .ready = true },
+};
+
 void app_main(void) {
     ESP_LOGI(TAG, "Initializing CNC Control System");
     
-    // Initialize components
-    ESP_ERROR_CHECK(servo42c_init(&servo_config));
-    ESP_ERROR_CHECK(safety_init());
-    ui_init();
-    
-    // Create tasks
-    xTaskCreatePinnedToCore(motion_control_task, "motion_ctrl", 4096,
-                           NULL, 5, &motion_task_handle, 1);
-    xTaskCreatePinnedToCore(ui_update_task, "ui_update", 4096,
-                           NULL, 3, &ui_task_handle, 0);
-    xTaskCreatePinnedToCore(safety_monitor_task, "safety", 2048,
-                           NULL, 6, &safety_task_handle, 1);
+    ESP_ERROR_CHECK(boot_run(boot_stages, STAGE_COUNT));
     
     ESP_LOGI(TAG, "System initialized");
-}
\ No newline at end of file
+}
@@ -0,0 +1,521 @@
+#include "planner.h"
+#include <math.h>
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "feed.h"
+#include "safety.h"
+#include "settings.h"
+
+static const char* TAG = "planner";
+
+#define PLANNER_MIN_SPEED    0.01f   // mm/s, floor for streamed setpoints
+#define PLANNER_MIN_LENGTH   0.0005f // mm, shorter moves are dropped
+#define BISECT_ITERATIONS    24
+
+typedef struct {
+    float start;        // mm
+    float end;          // mm
+    float length;       // mm, always positive
+    float dir;          // +1 or -1
+    float v_max;        // requested speed, mm/s
+    float v_entry;      // planned junction speeds, mm/s
+    float v_exit;
+    // Profile, filled in by plan_profile()
+    float v_peak;
+    float t_acc;
+    float t_cruise;
+    float t_dec;
+    float d_acc;
+    float d_cruise;
+    float dwell;        // s at the end, at rest
+    bool adaptive;
+    float feed_scale;   // planned v_max over the programmed feed
+} segment_t;
+
+static struct {
+    segment_t queue[PLANNER_QUEUE_SIZE];
+    size_t head;
+    size_t count;
+    segment_t active;
+    bool has_active;
+    float active_time;      // s into the active segment
+    float plan_end;         // mm, end of the last queued segment
+    bool setpoint_pending;  // final setpoint could not be queued, retry
+    float pending_position;
+    float last_setpoint;    // mm, last setpoint accepted by the servo
+    volatile bool cutting;  // read by the feed controller
+    // Limits in force, fixed while anything is planned
+    float max_speed;        // mm/s
+    float max_accel;        // mm/s²
+    float max_jerk;         // mm/s³
+    planner_owner_t owner;  // program currently feeding the queue
+    servo42c_handle_t axis;
+    SemaphoreHandle_t mutex;
+    TaskHandle_t task_handle;
+} planner = {0};
+
+// Time and distance of a symmetric jerk-limited speed change v0 -> v1
+static float transition_time(float v0, float v1) {
+    float dv = fabsf(v1 - v0);
+    if (dv <= 0.0f) {
+        return 0.0f;
+    }
+    float a_peak = fminf(planner.max_accel, sqrtf(dv * planner.max_jerk));
+    return dv / a_peak + a_peak / planner.max_jerk;
+}
+
+static float transition_distance(float v0, float v1) {
+    return 0.5f * (v0 + v1) * transition_time(v0, v1);
+}
+
+// Highest speed reachable from v0 (accelerating or, mirrored, braking)
+// within the given distance, capped at v_cap
+static float reachable_speed(float v0, float distance, float v_cap) {
+    if (v_cap <= v0 || transition_distance(v0, v_cap) <= distance) {
+        return v_cap;
+    }
+    float lo = v0;
+    float hi = v_cap;
+    for (int i = 0; i < BISECT_ITERATIONS; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (transition_distance(v0, mid) <= distance) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Position and speed t seconds into the speed change v0 -> v1
+static void transition_eval(float v0, float v1, float t, float* x, float* v) {
+    float dv = fabsf(v1 - v0);
+    float s = (v1 >= v0) ? 1.0f : -1.0f;
+    if (dv <= 0.0f) {
+        *x = v0 * t;
+        *v = v0;
+        return;
+    }
+
+    float a_peak = fminf(planner.max_accel, sqrtf(dv * planner.max_jerk));
+    float tj = a_peak / planner.max_jerk;
+    float ta = dv / a_peak - tj;
+    float j = s * planner.max_jerk;
+    float a = s * a_peak;
+
+    // Jerk phase
+    float t1 = fminf(t, tj);
+    float x1 = v0 * t1 + j * t1 * t1 * t1 / 6.0f;
+    float v1p = v0 + j * t1 * t1 / 2.0f;
+    if (t <= tj) {
+        *x = x1;
+        *v = v1p;
+        return;
+    }
+
+    // Constant acceleration phase
+    float t2 = fminf(t - tj, ta);
+    float x2 = x1 + v1p * t2 + a * t2 * t2 / 2.0f;
+    float v2 = v1p + a * t2;
+    if (t <= tj + ta) {
+        *x = x2;
+        *v = v2;
+        return;
+    }
+
+    // Jerk-out phase
+    float t3 = fminf(t - tj - ta, tj);
+    *x = x2 + v2 * t3 + a * t3 * t3 / 2.0f - j * t3 * t3 * t3 / 6.0f;
+    *v = v2 + a * t3 - j * t3 * t3 / 2.0f;
+}
+
+static void plan_profile(segment_t* seg) {
+    if (seg->length <= 0.0f) {
+        // Dwell in place
+        seg->v_peak = seg->t_acc = seg->t_cruise = seg->t_dec = 0.0f;
+        seg->d_acc = seg->d_cruise = 0.0f;
+        return;
+    }
+
+    float v_floor = fmaxf(seg->v_entry, seg->v_exit);
+    float v_peak = seg->v_max;
+
+    if (transition_distance(seg->v_entry, v_peak) + transition_distance(v_peak, seg->v_exit) > seg->length) {
+        // No room to reach the requested speed: find the highest peak that fits
+        float lo = v_floor;
+        float hi = seg->v_max;
+        for (int i = 0; i < BISECT_ITERATIONS; i++) {
+            float mid = 0.5f * (lo + hi);
+            if (transition_distance(seg->v_entry, mid) + transition_distance(mid, seg->v_exit) <= seg->length) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        v_peak = lo;
+    }
+
+    seg->v_peak = v_peak;
+    seg->t_acc = transition_time(seg->v_entry, v_peak);
+    seg->t_dec = transition_time(v_peak, seg->v_exit);
+    seg->d_acc = transition_distance(seg->v_entry, v_peak);
+    seg->d_cruise = fmaxf(0.0f, seg->length - seg->d_acc - transition_distance(v_peak, seg->v_exit));
+    seg->t_cruise = v_peak > 0.0f ? seg->d_cruise / v_peak : 0.0f;
+}
+
+static float motion_duration(const segment_t* seg) {
+    return seg->t_acc + seg->t_cruise + seg->t_dec;
+}
+
+static float segment_duration(const segment_t* seg) {
+    return motion_duration(seg) + seg->dwell;
+}
+
+// Absolute position and speed t seconds into a segment
+static void segment_eval(const segment_t* seg, float t, float* pos, float* speed) {
+    float x;
+    float v;
+
+    if (t <= seg->t_acc) {
+        transition_eval(seg->v_entry, seg->v_peak, t, &x, &v);
+    } else if (t <= seg->t_acc + seg->t_cruise) {
+        x = seg->d_acc + seg->v_peak * (t - seg->t_acc);
+        v = seg->v_peak;
+    } else if (t < motion_duration(seg)) {
+        transition_eval(seg->v_peak, seg->v_exit, t - seg->t_acc - seg->t_cruise, &x, &v);
+        x += seg->d_acc + seg->d_cruise;
+    } else {
+        x = seg->length;
+        v = seg->v_exit;
+    }
+
+    *pos = seg->start + seg->dir * fminf(x, seg->length);
+    *speed = v;
+}
+
+static segment_t* queued(size_t i) {
+    return &planner.queue[(planner.head + i) % PLANNER_QUEUE_SIZE];
+}
+
+// Slowest playback of a segment, as a fraction of its planned speeds
+static float min_time_scale(const segment_t* seg) {
+    return seg->adaptive ? FEED_OVERRIDE_MIN / seg->feed_scale : 1.0f;
+}
+
+// Speed allowed through the corner between two consecutive segments
+static float junction_speed(const segment_t* a, const segment_t* b) {
+    if (a->dir != b->dir || a->dwell > 0.0f || b->length <= 0.0f) {
+        return 0.0f;  // reversal or dwell: must stop
+    }
+    if (a->adaptive != b->adaptive || a->feed_scale != b->feed_scale) {
+        // Scaled differently, so the override moves the two sides apart.
+        // Blend at a speed both run at even at the lowest override: for
+        // a rapid into a cut, the programmed feed times FEED_OVERRIDE_MIN.
+        return fminf(a->v_max * min_time_scale(a), b->v_max * min_time_scale(b));
+    }
+    return fminf(a->v_max, b->v_max);
+}
+
+// Lookahead over everything not yet executing. Must hold planner.mutex.
+static void replan(void) {
+    if (planner.count == 0) {
+        return;
+    }
+
+    // The executing segment's exit speed is already committed
+    float v_start = 0.0f;
+    if (planner.has_active) {
+        v_start = fminf(planner.active.v_exit, junction_speed(&planner.active, queued(0)));
+    }
+
+    // Backward pass: every segment must be able to brake to its exit speed
+    float v_next_entry = 0.0f;
+    for (size_t i = planner.count; i-- > 0;) {
+        segment_t* seg = queued(i);
+        seg->v_exit = v_next_entry;
+        float limit = (i == 0) ? v_start : junction_speed(queued(i - 1), seg);
+        seg->v_entry = fminf(limit, reachable_speed(seg->v_exit, seg->length, seg->v_max));
+        v_next_entry = seg->v_entry;
+    }
+
+    // Forward pass: and be able to accelerate to it
+    queued(0)->v_entry = fminf(queued(0)->v_entry, v_start);
+    for (size_t i = 0; i < planner.count; i++) {
+        segment_t* seg = queued(i);
+        seg->v_exit = fminf(seg->v_exit, reachable_speed(seg->v_entry, seg->length, seg->v_max));
+        if (i + 1 < planner.count) {
+            queued(i + 1)->v_entry = seg->v_exit;
+        }
+        plan_profile(seg);
+    }
+}
+
+// Helpers below run on the planner task with planner.mutex held
+
+static bool pop_segment(void) {
+    if (planner.count == 0) {
+        planner.has_active = false;
+        return false;
+    }
+    planner.active = *queued(0);
+    planner.head = (planner.head + 1) % PLANNER_QUEUE_SIZE;
+    planner.count--;
+    planner.has_active = true;
+    return true;
+}
+
+static void cancel_locked(void) {
+    planner.count = 0;
+    planner.has_active = false;
+    planner.setpoint_pending = false;
+    planner.cutting = false;
+}
+
+// Adaptive segments are planned at FEED_OVERRIDE_MAX times the feed (or
+// the speed limit) and played back slower by the override. Scaling time
+// by s <= 1 scales speed by s, acceleration by s² and jerk by s³, so the
+// planned limits hold at any override.
+static float time_scale(const segment_t* seg, float t) {
+    if (!seg->adaptive || t >= motion_duration(seg)) {
+        return 1.0f;
+    }
+    return fminf(feed_get_override(), seg->feed_scale) / seg->feed_scale;
+}
+
+static void send_setpoint(float position, float dt) {
+    float speed = fmaxf(fabsf(position - planner.last_setpoint) / dt, PLANNER_MIN_SPEED);
+    esp_err_t err = servo42c_stream_to(planner.axis, position, speed);
+    if (err == ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Servo refused setpoint, aborting motion");
+        cancel_locked();
+        return;
+    }
+    // A full command queue drops this sample; the next one supersedes it,
+    // but the final setpoint of a move is retried until it goes through
+    planner.setpoint_pending = (err != ESP_OK);
+    if (err == ESP_OK) {
+        planner.last_setpoint = position;
+    } else {
+        planner.pending_position = position;
+    }
+}
+
+static void planner_step(float dt) {
+    if (!planner.has_active) {
+        if (pop_segment()) {
+            planner.active_time = 0.0f;
+            planner.last_setpoint = planner.active.start;
+            if (servo42c_stream_begin(planner.axis) != ESP_OK) {
+                cancel_locked();
+                return;
+            }
+        } else {
+            planner.cutting = false;
+            if (planner.setpoint_pending) {
+                send_setpoint(planner.pending_position, dt);
+            }
+            return;
+        }
+    }
+
+    // Look one period ahead: the drive reaches each setpoint just as the
+    // next one arrives. Leftover time carries into the next segment so
+    // blended junctions are seamless.
+    float t = planner.active_time + dt * time_scale(&planner.active, planner.active_time);
+    float duration = segment_duration(&planner.active);
+    while (t >= duration) {
+        float end = planner.active.end;
+        t -= duration;
+        if (!pop_segment()) {
+            planner.cutting = false;
+            send_setpoint(end, dt);
+            return;
+        }
+        duration = segment_duration(&planner.active);
+    }
+
+    float pos;
+    float speed;
+    segment_eval(&planner.active, t, &pos, &speed);
+    planner.active_time = t;
+    planner.cutting = planner.active.adaptive && t < motion_duration(&planner.active);
+    send_setpoint(pos, dt);
+}
+
+static void planner_task(void* arg) {
+    TickType_t last_wake_time = xTaskGetTickCount();
+    const float dt = PLANNER_PERIOD_MS / 1000.0f;
+
+    while (1) {
+        bool fault = safety_get_status() != SAFETY_OK;
+
+        xSemaphoreTake(planner.mutex, portMAX_DELAY);
+        if (fault) {
+            if (planner.has_active || planner.count > 0) {
+                ESP_LOGW(TAG, "Safety fault, aborting motion");
+            }
+            cancel_locked();
+        } else {
+            planner_step(dt);
+        }
+        xSemaphoreGive(planner.mutex);
+
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(PLANNER_PERIOD_MS));
+    }
+}
+
+esp_err_t planner_init(servo42c_handle_t axis) {
+    ESP_LOGI(TAG, "Initializing motion planner");
+
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    planner.axis = axis;
+
+    // Rapids must be expressible in the drive's steps/s field; a stored
+    // limit from a faster mechanical profile is capped
+    if (settings_get()->max_speed > kin_max_speed()) {
+        ESP_LOGW(TAG, "Max speed %.1f mm/s exceeds the drive limit, using %.1f mm/s",
+                 settings_get()->max_speed, kin_max_speed());
+    }
+
+    planner.mutex = xSemaphoreCreateMutex();
+    if (!planner.mutex) {
+        ESP_LOGE(TAG, "Failed to create planner mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        planner_task,
+        "planner",
+        4096,
+        NULL,
+        5,
+        &planner.task_handle,
+        1
+    );
+
+    if (ret != pdPASS) {
+        vSemaphoreDelete(planner.mutex);
+        ESP_LOGE(TAG, "Failed to create planner task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t planner_queue_moves(const planner_move_t* moves, size_t count) {
+    if (!moves || count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (moves[i].speed_mm_s <= 0.0f || moves[i].dwell_s < 0.0f ||
+            !safety_is_position_valid(moves[i].target_mm)) {
+            ESP_LOGE(TAG, "Invalid move: %.2f mm at %.2f mm/s", moves[i].target_mm, moves[i].speed_mm_s);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    xSemaphoreTake(planner.mutex, portMAX_DELAY);
+
+    if (planner.count + count > PLANNER_QUEUE_SIZE) {
+        xSemaphoreGive(planner.mutex);
+        ESP_LOGE(TAG, "Planner queue full");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (!planner.has_active && planner.count == 0) {
+        // Starting from rest: plan from where the axis actually is, with
+        // the current limits
+        servo42c_state_t state;
+        servo42c_get_state(planner.axis, &state);
+        planner.plan_end = state.current_position;
+        const settings_t* settings = settings_get();
+        planner.max_speed = fminf(settings->max_speed, kin_max_speed());
+        planner.max_accel = settings->max_accel;
+        planner.max_jerk = settings->max_jerk;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        float delta = moves[i].target_mm - planner.plan_end;
+        bool still = fabsf(delta) < PLANNER_MIN_LENGTH;
+        if (still && moves[i].dwell_s <= 0.0f) {
+            continue;
+        }
+
+        // A dwell with no travel becomes a zero-length segment
+        segment_t* seg = queued(planner.count);
+        memset(seg, 0, sizeof(*seg));
+        seg->start = planner.plan_end;
+        seg->end = still ? planner.plan_end : moves[i].target_mm;
+        seg->length = still ? 0.0f : fabsf(delta);
+        seg->dir = delta > 0.0f ? 1.0f : -1.0f;
+        seg->dwell = moves[i].dwell_s;
+        seg->adaptive = moves[i].adaptive;
+        if (seg->adaptive) {
+            seg->v_max = fminf(moves[i].speed_mm_s * FEED_OVERRIDE_MAX, planner.max_speed);
+            seg->feed_scale = seg->v_max / moves[i].speed_mm_s;
+        } else {
+            seg->v_max = fminf(moves[i].speed_mm_s, planner.max_speed);
+        }
+        planner.plan_end = seg->end;
+        planner.count++;
+    }
+
+    replan();
+    xSemaphoreGive(planner.mutex);
+
+    return ESP_OK;
+}
+
+esp_err_t planner_queue_move(float target_mm, float speed_mm_s) {
+    planner_move_t move = {
+        .target_mm = target_mm,
+        .speed_mm_s = speed_mm_s,
+    };
+    return planner_queue_moves(&move, 1);
+}
+
+void planner_cancel(void) {
+    xSemaphoreTake(planner.mutex, portMAX_DELAY);
+    cancel_locked();
+    xSemaphoreGive(planner.mutex);
+}
+
+bool planner_is_cutting(void) {
+    return planner.cutting;
+}
+
+bool planner_is_idle(void) {
+    return !planner.has_active && planner.count == 0 && !planner.setpoint_pending;
+}
+
+size_t planner_queue_free(void) {
+    return PLANNER_QUEUE_SIZE - planner.count;
+}
+
+bool planner_acquire(planner_owner_t owner) {
+    xSemaphoreTake(planner.mutex, portMAX_DELAY);
+    bool acquired = planner.owner == PLANNER_OWNER_NONE && planner_is_idle();
+    if (acquired) {
+        planner.owner = owner;
+    }
+    xSemaphoreGive(planner.mutex);
+    return acquired;
+}
+
+void planner_release(planner_owner_t owner) {
+    xSemaphoreTake(planner.mutex, portMAX_DELAY);
+    if (planner.owner == owner) {
+        planner.owner = PLANNER_OWNER_NONE;
+    }
+    xSemaphoreGive(planner.mutex);
+}
+
+planner_owner_t planner_get_owner(void) {
+    return planner.owner;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "servo42c.h"
+
+// Motion planner: turns a sequence of Z targets into jerk-limited
+// (S-curve) velocity profiles and streams them to the servo as position
+// setpoints. Consecutive segments in the same direction are blended at
+// the lower of their two speeds instead of stopping in between.
+//
+// Adaptive moves (cutting feeds) run at the programmed feed times the
+// adaptive feed override (feed.h); where a cutting move meets one that
+// is not, the axis passes through at the feed times FEED_OVERRIDE_MIN.
+
+#define PLANNER_QUEUE_SIZE   16
+#define PLANNER_PERIOD_MS    10      // setpoint update rate
+
+// Speed, acceleration and jerk limits are settings (settings.h), taken
+// up each time the axis starts from rest
+
+// Producers that run a whole program through the planner. One holds it
+// at a time, so a canned cycle and a G-code program never interleave.
+typedef enum {
+    PLANNER_OWNER_NONE,
+    PLANNER_OWNER_CYCLE,
+    PLANNER_OWNER_GCODE,
+} planner_owner_t;
+
+typedef struct {
+    float target_mm;
+    float speed_mm_s;
+    float dwell_s;      // hold at the target this long before the next move
+    bool adaptive;      // cutting move: speed follows the feed override
+} planner_move_t;
+
+// Streams to `axis`
+esp_err_t planner_init(servo42c_handle_t axis);
+
+// Queue one move from the end of the previous one
+esp_err_t planner_queue_move(float target_mm, float speed_mm_s);
+
+// Queue several moves atomically, so the executor cannot start the
+// first one before the rest are known and can blend them all
+esp_err_t planner_queue_moves(const planner_move_t* moves, size_t count);
+
+// Drop all queued and executing segments; the axis halts at the last setpoint
+void planner_cancel(void);
+
+bool planner_is_idle(void);
+
+// True while the motion part of an adaptive move executes
+bool planner_is_cutting(void);
+size_t planner_queue_free(void);
+
+// Claim the planner for a program; false while another owner holds it
+// or the axis is still moving. Released by the same owner once its
+// program has stopped.
+bool planner_acquire(planner_owner_t owner);
+void planner_release(planner_owner_t owner);
+planner_owner_t planner_get_owner(void);
@@ -1,47 +1,101 @@
 #include "safety.h"
+#include <stdatomic.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
+#include "settings.h"
 
 static const char* TAG = "safety";
 
-// GPIO pin definitions
-#define LIMIT_SWITCH_PIN_X GPIO_NUM_18
-#define E_STOP_PIN GPIO_NUM_19
-#define LOAD_SENSOR_PIN GPIO_NUM_20
-
 // Safety parameters
-#define SOFT_LIMIT_MIN 0.0f
-#define SOFT_LIMIT_MAX 200.0f  // 200mm travel range
 #define OVERLOAD_THRESHOLD 80  // 80% of max load
 
-static safety_status_t current_status = SAFETY_OK;
-static SemaphoreHandle_t safety_mutex = NULL;
+// Active faults, set by the ISRs and cleared only by safety_reset_error()
+static atomic_uint fault_flags;
+
+// Task woken on every change of fault_flags
+static TaskHandle_t volatile event_waiter;
+
+// Inputs that latch a fault, most severe first
+static const struct {
+    gpio_num_t pin;
+    safety_status_t status;
+    const char* name;
+} fault_inputs[] = {
+    { E_STOP_PIN, SAFETY_EMERGENCY_STOP, "E-Stop" },
+    { LIMIT_SWITCH_PIN_X, SAFETY_HARD_LIMIT, "Limit switch" },
+    { LOAD_SENSOR_PIN, SAFETY_OVERLOAD, "Overload" },
+};
+
+// Trip log: writers claim a slot with one atomic increment, and each slot
+// carries its own sequence so readers can tell a finished entry from one
+// being overwritten.
+typedef struct {
+    atomic_uint seq;    // index + 1 once written, 0 while being written
+    safety_event_t event;
+} event_slot_t;
+
+static event_slot_t event_log[SAFETY_EVENT_LOG_SIZE];
+static atomic_uint event_head;
+
+static void IRAM_ATTR log_event(safety_status_t status) {
+    unsigned int index = atomic_fetch_add_explicit(&event_head, 1, memory_order_relaxed);
+    event_slot_t* slot = &event_log[index % SAFETY_EVENT_LOG_SIZE];
+
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->event.time_us = esp_timer_get_time();
+    slot->event.status = status;
+    atomic_store_explicit(&slot->seq, index + 1, memory_order_release);
+}
+
+// Raise a fault from ISR or task context. Returns true if it was not
+// already active, so each trip is logged and signalled once.
+static bool IRAM_ATTR raise_fault(safety_status_t status, BaseType_t* high_task_wakeup) {
+    unsigned int flag = SAFETY_FLAG(status);
+    // Sequentially consistent against the waiter registering: either it
+    // sees the flag or this sees the waiter
+    if (atomic_fetch_or_explicit(&fault_flags, flag, memory_order_seq_cst) & flag) {
+        return false;
+    }
+
+    log_event(status);
+    TaskHandle_t waiter = event_waiter;
+    if (waiter) {
+        if (high_task_wakeup) {
+            vTaskNotifyGiveFromISR(waiter, high_task_wakeup);
+        } else {
+            xTaskNotifyGive(waiter);
+        }
+    }
+    return true;
+}
 
 // ISR handlers must be in IRAM
 static void IRAM_ATTR limit_switch_isr(void* arg) {
     BaseType_t high_task_wakeup = pdFALSE;
-    safety_status_t* status = (safety_status_t*)arg;
-    *status = SAFETY_HARD_LIMIT;
+    raise_fault(SAFETY_HARD_LIMIT, &high_task_wakeup);
     portYIELD_FROM_ISR(high_task_wakeup);
 }
 
 static void IRAM_ATTR estop_isr(void* arg) {
     BaseType_t high_task_wakeup = pdFALSE;
-    safety_status_t* status = (safety_status_t*)arg;
-    *status = SAFETY_EMERGENCY_STOP;
+    raise_fault(SAFETY_EMERGENCY_STOP, &high_task_wakeup);
+    portYIELD_FROM_ISR(high_task_wakeup);
+}
+
+static void IRAM_ATTR load_sensor_isr(void* arg) {
+    BaseType_t high_task_wakeup = pdFALSE;
+    raise_fault(SAFETY_OVERLOAD, &high_task_wakeup);
     portYIELD_FROM_ISR(high_task_wakeup);
 }
 
 esp_err_t safety_init(void) {
     ESP_LOGI(TAG, "Initializing safety system");
     
-    // Create mutex for thread-safe access
-    safety_mutex = xSemaphoreCreateMutex();
-    if (!safety_mutex) {
-        ESP_LOGE(TAG, "Failed to create safety mutex");
-        return ESP_ERR_NO_MEM;
-    }
-    
+    atomic_store(&fault_flags, 0);
+    atomic_store(&event_head, 0);
+
     // Configure GPIO pins
     gpio_config_t io_conf = {
         .intr_type = GPIO_INTR_NEGEDGE,
@@ -58,71 +112,136 @@ esp_err_t safety_init(void) {
     ESP_ERROR_CHECK(gpio_install_isr_service(0));
     
     // Add ISR handlers
-    ESP_ERROR_CHECK(gpio_isr_handler_add(LIMIT_SWITCH_PIN_X, limit_switch_isr, &current_status));
-    ESP_ERROR_CHECK(gpio_isr_handler_add(E_STOP_PIN, estop_isr, &current_status));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(LIMIT_SWITCH_PIN_X, limit_switch_isr, NULL));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(E_STOP_PIN, estop_isr, NULL));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(LOAD_SENSOR_PIN, load_sensor_isr, NULL));
     
     // Initial state check
     if (gpio_get_level(E_STOP_PIN) == 0) {
-        current_status = SAFETY_EMERGENCY_STOP;
+        raise_fault(SAFETY_EMERGENCY_STOP, NULL);
         ESP_LOGW(TAG, "E-Stop active at startup");
     }
     
     if (gpio_get_level(LIMIT_SWITCH_PIN_X) == 0) {
-        current_status = SAFETY_HARD_LIMIT;
+        raise_fault(SAFETY_HARD_LIMIT, NULL);
         ESP_LOGW(TAG, "Limit switch active at startup");
     }
+
+    if (gpio_get_level(LOAD_SENSOR_PIN) == 0) {
+        raise_fault(SAFETY_OVERLOAD, NULL);
+        ESP_LOGW(TAG, "Overload active at startup");
+    }
     
     ESP_LOGI(TAG, "Safety system initialized");
     return ESP_OK;
 }
 
+uint32_t safety_get_flags(void) {
+    return atomic_load_explicit(&fault_flags, memory_order_acquire);
+}
+
 safety_status_t safety_get_status(void) {
-    safety_status_t status;
-    
-    xSemaphoreTake(safety_mutex, portMAX_DELAY);
-    
-    // Check load sensor
-    if (gpio_get_level(LOAD_SENSOR_PIN) == 0) {
-        current_status = SAFETY_OVERLOAD;
-        ESP_LOGW(TAG, "Overload detected");
+    uint32_t flags = safety_get_flags();
+
+    // Most severe first
+    if (flags & SAFETY_FLAG(SAFETY_EMERGENCY_STOP)) {
+        return SAFETY_EMERGENCY_STOP;
     }
-    
-    status = current_status;
-    xSemaphoreGive(safety_mutex);
-    
-    return status;
+    if (flags & SAFETY_FLAG(SAFETY_HARD_LIMIT)) {
+        return SAFETY_HARD_LIMIT;
+    }
+    if (flags & SAFETY_FLAG(SAFETY_OVERLOAD)) {
+        return SAFETY_OVERLOAD;
+    }
+    if (flags & SAFETY_FLAG(SAFETY_SOFT_LIMIT)) {
+        return SAFETY_SOFT_LIMIT;
+    }
+    return SAFETY_OK;
+}
+
+safety_status_t safety_wait_event(TickType_t ticks_to_wait) {
+    // Faults raised before the first call had no task to notify, so the
+    // first call only registers and reports what is already active
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (event_waiter != self) {
+        event_waiter = self;
+        atomic_thread_fence(memory_order_seq_cst);
+        return safety_get_status();
+    }
+    ulTaskNotifyTake(pdTRUE, ticks_to_wait);
+    return safety_get_status();
+}
+
+size_t safety_get_events(safety_event_t* events, size_t max_events) {
+    unsigned int head = atomic_load_explicit(&event_head, memory_order_acquire);
+    unsigned int count = head < SAFETY_EVENT_LOG_SIZE ? head : SAFETY_EVENT_LOG_SIZE;
+    if (count > max_events) {
+        count = max_events;
+    }
+
+    size_t copied = 0;
+    for (unsigned int index = head - count; index != head; index++) {
+        event_slot_t* slot = &event_log[index % SAFETY_EVENT_LOG_SIZE];
+
+        unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        safety_event_t event = slot->event;
+        atomic_thread_fence(memory_order_acquire);
+
+        // Skip entries still being written or already overwritten
+        if (seq != index + 1 || atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) {
+            continue;
+        }
+        events[copied++] = event;
+    }
+    return copied;
 }
 
 void safety_emergency_stop(void) {
-    xSemaphoreTake(safety_mutex, portMAX_DELAY);
-    current_status = SAFETY_EMERGENCY_STOP;
-    ESP_LOGE(TAG, "Emergency stop activated");
-    xSemaphoreGive(safety_mutex);
+    if (raise_fault(SAFETY_EMERGENCY_STOP, NULL)) {
+        ESP_LOGE(TAG, "Emergency stop activated");
+    }
 }
 
+// Soft limits come from the settings' RAM copy
 bool safety_is_position_valid(float position_mm) {
-    if (position_mm < SOFT_LIMIT_MIN || position_mm > SOFT_LIMIT_MAX) {
+    const settings_t* settings = settings_get();
+    if (position_mm < settings->soft_limit_min || position_mm > settings->soft_limit_max) {
         ESP_LOGW(TAG, "Position %.2f mm outside soft limits [%.1f, %.1f]",
-                 position_mm, SOFT_LIMIT_MIN, SOFT_LIMIT_MAX);
+                 position_mm, settings->soft_limit_min, settings->soft_limit_max);
         return false;
     }
     return true;
 }
 
+// Clears every fault whose input reads inactive; faults of inputs still
+// active stay latched
 void safety_reset_error(void) {
-    xSemaphoreTake(safety_mutex, portMAX_DELAY);
-    
-    // Only reset if E-Stop is not active
-    if (gpio_get_level(E_STOP_PIN) == 0) {
-        ESP_LOGW(TAG, "Cannot reset: E-Stop is active");
-    } else if (gpio_get_level(LIMIT_SWITCH_PIN_X) == 0) {
-        ESP_LOGW(TAG, "Cannot reset: Limit switch is active");
-    } else if (gpio_get_level(LOAD_SENSOR_PIN) == 0) {
-        ESP_LOGW(TAG, "Cannot reset: Overload condition present");
-    } else {
-        current_status = SAFETY_OK;
+    uint32_t keep = 0;
+    for (size_t i = 0; i < sizeof(fault_inputs) / sizeof(fault_inputs[0]); i++) {
+        if (gpio_get_level(fault_inputs[i].pin) == 0) {
+            keep |= SAFETY_FLAG(fault_inputs[i].status);
+            ESP_LOGW(TAG, "Cannot reset: %s is active", fault_inputs[i].name);
+        }
+    }
+
+    uint32_t cleared = atomic_fetch_and_explicit(&fault_flags, keep, memory_order_acq_rel) & ~keep;
+
+    // An input that went active after it was read had its edge swallowed
+    // by the flag still being set; sample again and raise it anew
+    for (size_t i = 0; i < sizeof(fault_inputs) / sizeof(fault_inputs[0]); i++) {
+        safety_status_t status = fault_inputs[i].status;
+        if (!(keep & SAFETY_FLAG(status)) && gpio_get_level(fault_inputs[i].pin) == 0) {
+            raise_fault(status, NULL);
+        }
+    }
+
+    if (cleared) {
+        TaskHandle_t waiter = event_waiter;
+        if (waiter) {
+            xTaskNotifyGive(waiter);
+        }
+    }
+    if (!keep) {
         ESP_LOGI(TAG, "Safety system reset");
     }
-    
-    xSemaphoreGive(safety_mutex);
-}
\ No newline at end of file
+}
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
+#include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+// Safety inputs, active low
+#define LIMIT_SWITCH_PIN_X GPIO_NUM_18
+#define E_STOP_PIN GPIO_NUM_19
+#define LOAD_SENSOR_PIN GPIO_NUM_20
+
 typedef enum {
     SAFETY_OK = 0,
     SAFETY_SOFT_LIMIT,
@@ -12,8 +21,32 @@ typedef enum {
     SAFETY_EMERGENCY_STOP,
 } safety_status_t;
 
+// Active faults as a bitmask, one bit per safety_status_t
+#define SAFETY_FLAG(status) (1u << (status))
+
+#define SAFETY_EVENT_LOG_SIZE 32
+
+typedef struct {
+    int64_t time_us;          // esp_timer_get_time() at the trip
+    safety_status_t status;   // fault that tripped
+} safety_event_t;
+
 esp_err_t safety_init(void);
+
+// Most severe active fault; a single atomic load, safe from any context
 safety_status_t safety_get_status(void);
+uint32_t safety_get_flags(void);
+
+// Block until a fault trips or is cleared, then return the new status.
+// The first call returns at once with the current status, covering
+// faults raised before anyone waited. Only one task (the safety
+// monitor) may wait.
+safety_status_t safety_wait_event(TickType_t ticks_to_wait);
+
+// Copy up to max_events of the most recent trips, oldest first
+size_t safety_get_events(safety_event_t* events, size_t max_events);
+
 void safety_emergency_stop(void);
 bool safety_is_position_valid(float position_mm);
+// Clear latched faults whose inputs read inactive
 void safety_reset_error(void);
\ No newline at end of file
@@ -1,22 +1,29 @@
 #include "servo42c.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
 #include "driver/uart.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "latency.h"
 #include "safety.h"
+#include "settings.h"
+#include "telemetry.h"
 
 static const char* TAG = "servo42c";
 
-// Protocol constants
-#define CMD_HEADER_1 0xAA
-#define CMD_HEADER_2 0x55
+// Protocol constants (framing lives in servo42c_proto.h)
 #define CMD_GET_STATUS 0x90
 #define CMD_SET_POSITION 0x91
 #define CMD_STOP 0x92
 #define CMD_HOME 0x93
 #define CMD_SET_SPEED 0x94
 #define CMD_EMERGENCY_STOP 0x95
+#define CMD_READ_ENCODER 0x30   // int32 turns + uint16 fraction of a turn
+#define CMD_READ_PULSES 0x33    // int32 step pulses generated
 
 // Status register bits
 #define STATUS_MOVING    (1 << 0)
@@ -27,15 +34,65 @@ static const char* TAG = "servo42c";
 // Constants
 #define UART_BUFFER_SIZE 256
 #define HOMING_TIMEOUT_MS 30000  // 30 seconds timeout for homing
-#define MONITOR_TASK_PERIOD_MS 10
-#define MAX_TEMPERATURE 70  // °C
-#define MAX_CURRENT 2000    // mA
-#define RESPONSE_TIMEOUT_MS 100
-#define COMMAND_QUEUE_SIZE 10
-
-// Motor state
-static struct {
-    float current_position;  // mm
+#define POLL_PERIOD_MOVING_MS 1    // control period: status poll rate while an axis moves
+#define POLL_PERIOD_IDLE_MS 50     // ... and while it is parked
+#define REPLY_TIMEOUT_MS 20        // a status reply is ~1 ms of wire time at 115200
+#define MAX_IN_FLIGHT 8            // per bus
+#define UART_LOCK_TIMEOUT_MS 100
+#define STATUS_REPLY_LEN SERVO42C_STATUS_PAYLOAD_LEN
+#define STATUS_FRAME_LEN (SERVO42C_FRAME_OVERHEAD + STATUS_REPLY_LEN)
+#define ENCODER_REPLY_LEN 6
+#define PULSES_REPLY_LEN 4
+#define MAX_EXTRAPOLATION_US 20000  // hold the estimate if readings stop
+#define COMMAND_RING_SIZE 32    // power of two
+#define WIRE_BITS_PER_BYTE 10   // start + 8 data + stop
+
+// Receive path: the RX interrupt fires once a whole status frame is in
+// the FIFO, or after a short idle gap for anything shorter
+#define UART_EVENT_QUEUE_SIZE 16
+#define UART_RX_TIMEOUT_SYMBOLS 3   // character times of idle line
+#define REPLY_QUEUE_SIZE 8
+#define RX_TASK_PRIORITY 6
+#define SCHEDULER_TASK_PRIORITY 5
+
+// pdMS_TO_TICKS rounds down, so a coarser tick would quietly slow the
+// moving poll to one per tick (see sdkconfig.defaults)
+#if configTICK_RATE_HZ < 1000 / POLL_PERIOD_MOVING_MS
+#error "POLL_PERIOD_MOVING_MS is shorter than one FreeRTOS tick; raise CONFIG_FREERTOS_HZ"
+#endif
+
+// Command structure
+typedef struct {
+    uint8_t cmd;
+    uint8_t data[8];
+    size_t data_len;
+} motor_command_t;
+
+// Bounded lock-free multi-producer/single-consumer ring (Vyukov): any
+// task may push, only the bus scheduler pops. Each cell's sequence
+// number tells producers and the consumer whose turn it is.
+typedef struct {
+    atomic_uint sequence;
+    motor_command_t cmd;
+} command_cell_t;
+
+typedef struct {
+    command_cell_t cells[COMMAND_RING_SIZE];
+    atomic_uint enqueue_pos;
+    atomic_uint flush_until;    // entries before this position are dropped
+    unsigned int dequeue_pos;   // consumer only
+} command_ring_t;
+
+// One drive. Fields published through servo42c_get_state() are only
+// written between state_write_begin() and state_write_end(); the rest
+// belongs to the bus scheduler unless noted.
+struct servo42c_axis {
+    const char* name;
+    uint8_t address;
+    bool telemetry;
+    struct servo42c_bus* bus;
+
+    float current_position;  // mm, last encoder reading
     float target_position;   // mm
     float speed;            // mm/s
     uint16_t current;       // mA
@@ -43,140 +100,716 @@ static struct {
     uint8_t status;
     bool is_homed;
     bool is_moving;
-    float max_current;      // mA
+    atomic_bool estop_active;    // latched until the next explicit motion command
+    bool drive_fault;            // last status reply reported a fault
     uint32_t homing_start_time;
-    TaskHandle_t monitor_task_handle;
-    QueueHandle_t command_queue;
-    SemaphoreHandle_t uart_mutex;
-} motor = {0};
+    uint8_t last_status_seq;     // newest status reply applied
+    atomic_uint motion_frame;    // bus frame count after the last motion or stop command
+    bool have_status;
+    uint8_t poll_slot;           // position in poll_schedule
+    TickType_t last_poll;
+    uint32_t last_poll_cycles;
+    bool last_poll_moving;
+    // Position readback, published with the state
+    int64_t encoder_time_us;
+    float commanded_position;    // mm, from the pulse counter
+    bool have_encoder;
+    uint32_t commands_coalesced; // superseded commands never sent
+    servo42c_status_cb_t status_cb;
+    void* status_ctx;
+    atomic_bool linked;          // the drive has answered a status poll
+    TaskHandle_t volatile link_waiter;
+    atomic_uint state_seq;       // seqlock: odd while a write is in progress
+    portMUX_TYPE state_mux;      // serializes writers across cores
+    command_ring_t commands;
+};
 
-// Command structure
+// Requests waiting for a reply, owned by the bus scheduler
 typedef struct {
+    bool used;
+    struct servo42c_axis* axis;
+    uint8_t seq;
     uint8_t cmd;
-    uint8_t data[8];
-    size_t data_len;
-} motor_command_t;
+    uint32_t frame;     // bus frame count once it was sent
+    TickType_t sent_at;
+    int64_t sent_us;
+    uint32_t sent_cycles;
+} request_t;
+
+// One UART and the drives on it
+struct servo42c_bus {
+    uart_port_t uart_num;
+    uint32_t baud_rate;
+    bool half_duplex;            // RS485: requests and replies share the wire
+    TaskHandle_t scheduler_task_handle;
+    TaskHandle_t rx_task_handle;
+    QueueHandle_t uart_event_queue;
+    QueueHandle_t reply_queue;   // decoded frames, RX task -> scheduler
+    SemaphoreHandle_t uart_mutex; // serializes transmit only
+    uint8_t tx_seq;              // shared by all axes, so replies match by seq
+    uint32_t frames_sent;        // orders requests against commands; under uart_mutex
+    servo42c_parser_t parser;    // owned by the RX task
+    servo42c_link_stats_t link_stats;
+    request_t in_flight[MAX_IN_FLIGHT];
+    struct servo42c_axis* axes[SERVO42C_MAX_AXES];
+    atomic_uint axis_count;      // axes[] entries below this are set up
+    unsigned int next_axis;      // first axis the next poll round offers the wire to
+    int64_t wire_busy_until_us;  // when the replies already asked for are through
+};
+
+// Handles come from fixed pools; nothing is freed
+static struct servo42c_bus buses[SERVO42C_MAX_BUSES];
+static struct servo42c_axis axes[SERVO42C_MAX_AXES];
+static size_t buses_used;
+static atomic_uint axes_used;
+static bool telemetry_axis_added;
 
-static esp_err_t send_command(uint8_t cmd, const uint8_t* data, size_t len) {
-    if (xSemaphoreTake(motor.uart_mutex, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
+// What each poll asks for, round-robin per axis. Status and encoder
+// replies together would not fit the wire at the 1 kHz moving poll rate,
+// so they alternate; the pulse counter only feeds the following error.
+static const uint8_t poll_schedule[] = {
+    CMD_GET_STATUS, CMD_READ_ENCODER, CMD_GET_STATUS, CMD_READ_ENCODER,
+    CMD_GET_STATUS, CMD_READ_ENCODER, CMD_GET_STATUS, CMD_READ_PULSES,
+};
+
+// Seqlock around the published state. Writers may run on either core,
+// so they serialize on a spinlock (which also keeps a writer from being
+// preempted halfway); readers retry instead of locking.
+static void state_write_begin(struct servo42c_axis* axis) {
+    portENTER_CRITICAL(&axis->state_mux);
+    atomic_fetch_add_explicit(&axis->state_seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void state_write_end(struct servo42c_axis* axis) {
+    atomic_fetch_add_explicit(&axis->state_seq, 1, memory_order_release);
+    portEXIT_CRITICAL(&axis->state_mux);
+}
+
+// Time a frame with `payload` bytes occupies the wire
+static int64_t frame_wire_us(const struct servo42c_bus* bus, size_t payload) {
+    return (int64_t)(SERVO42C_FRAME_OVERHEAD + payload) * WIRE_BITS_PER_BYTE * 1000000 / bus->baud_rate;
+}
+
+static size_t reply_payload_len(uint8_t cmd) {
+    switch (cmd) {
+        case CMD_READ_ENCODER: return ENCODER_REPLY_LEN;
+        case CMD_READ_PULSES:  return PULSES_REPLY_LEN;
+        default:               return STATUS_REPLY_LEN;
+    }
+}
+
+// Book wire time for a transmission; the clock never runs behind now
+static void wire_reserve(struct servo42c_bus* bus, int64_t now_us, int64_t duration_us) {
+    if (bus->wire_busy_until_us < now_us) {
+        bus->wire_busy_until_us = now_us;
+    }
+    bus->wire_busy_until_us += duration_us;
+}
+
+// Caller holds uart_mutex
+static esp_err_t write_frame(struct servo42c_bus* bus, uint8_t addr, uint8_t seq, uint8_t cmd,
+                             const uint8_t* data, size_t len) {
+    uint8_t frame[SERVO42C_MAX_FRAME];
+    size_t frame_len = servo42c_frame_encode(frame, sizeof(frame), addr, seq, cmd, data, len);
+    if (frame_len == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // One write per frame, so a frame is never interleaved or half-sent
+    if (uart_write_bytes(bus->uart_num, (const char*)frame, frame_len) != (int)frame_len) {
+        return ESP_FAIL;
+    }
+    bus->frames_sent++;
+    return ESP_OK;
+}
+
+static esp_err_t send_command_seq(struct servo42c_bus* bus, uint8_t addr, uint8_t cmd,
+                                  const uint8_t* data, size_t len, uint8_t* seq, uint32_t* frame) {
+    uint32_t wait_start = latency_now();
+    if (xSemaphoreTake(bus->uart_mutex, pdMS_TO_TICKS(UART_LOCK_TIMEOUT_MS)) != pdTRUE) {
         ESP_LOGE(TAG, "Failed to take UART mutex");
         return ESP_ERR_TIMEOUT;
     }
+    latency_end(LATENCY_UART_LOCK, wait_start);
 
-    // Send command header
-    uint8_t header[3] = {CMD_HEADER_1, CMD_HEADER_2, cmd};
-    if (uart_write_bytes(SERVO42C_UART_NUM, (const char*)header, 3) != 3) {
-        xSemaphoreGive(motor.uart_mutex);
-        return ESP_FAIL;
+    uint8_t frame_seq = bus->tx_seq++;
+    esp_err_t err = write_frame(bus, addr, frame_seq, cmd, data, len);
+    uint32_t frame_count = bus->frames_sent;
+
+    xSemaphoreGive(bus->uart_mutex);
+    if (seq) {
+        *seq = frame_seq;
+    }
+    if (frame) {
+        *frame = frame_count;
     }
+    return err;
+}
+
+static void rx_overflow(struct servo42c_bus* bus) {
+    // Bytes were lost; whatever is buffered cannot be trusted to line up
+    bus->link_stats.overruns++;
+    uart_flush_input(bus->uart_num);
+    xQueueReset(bus->uart_event_queue);
+    servo42c_parser_reset(&bus->parser);
+}
 
-    // Send data if any
-    if (data && len > 0) {
-        if (uart_write_bytes(SERVO42C_UART_NUM, (const char*)data, len) != len) {
-            xSemaphoreGive(motor.uart_mutex);
-            return ESP_FAIL;
+// Sole reader of the UART: decodes frames as the driver reports data and
+// hands them to the bus scheduler, so no other task ever blocks on the
+// wire
+static void rx_task(void* arg) {
+    struct servo42c_bus* bus = arg;
+    uart_event_t event;
+    uint8_t buf[UART_BUFFER_SIZE];
+
+    while (1) {
+        if (xQueueReceive(bus->uart_event_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        switch (event.type) {
+            case UART_DATA: {
+                size_t pending = event.size;
+                while (pending > 0) {
+                    size_t chunk = pending < sizeof(buf) ? pending : sizeof(buf);
+                    int length = uart_read_bytes(bus->uart_num, buf, chunk, 0);
+                    if (length <= 0) {
+                        break;
+                    }
+                    pending -= length;
+
+                    for (int i = 0; i < length; i++) {
+                        if (!servo42c_parser_feed(&bus->parser, buf[i])) {
+                            continue;
+                        }
+                        do {
+                            if (xQueueSend(bus->reply_queue, &bus->parser.frame, 0) != pdTRUE) {
+                                ESP_LOGW(TAG, "Reply queue full, dropping seq %u",
+                                         bus->parser.frame.seq);
+                            }
+                        } while (servo42c_parser_poll(&bus->parser));
+                    }
+                }
+                // Let the scheduler match the replies right away
+                if (bus->scheduler_task_handle) {
+                    xTaskNotifyGive(bus->scheduler_task_handle);
+                }
+                break;
+            }
+
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                ESP_LOGW(TAG, "UART%d RX overflow", (int)bus->uart_num);
+                rx_overflow(bus);
+                break;
+
+            default:
+                // Framing/parity errors surface as CRC errors in the parser
+                break;
         }
     }
+}
 
-    xSemaphoreGive(motor.uart_mutex);
-    return ESP_OK;
+// A status reply describes the drive as it was when the request went
+// out. If a motion or stop command was sent after the request, or is
+// still queued, the reply's motion state predates it. Call with the
+// state lock held: a command submitted before the lock was taken is
+// then visible here.
+static bool status_predates_motion(struct servo42c_axis* axis, uint32_t request_frame) {
+    uint32_t motion_frame = atomic_load_explicit(&axis->motion_frame, memory_order_acquire);
+    unsigned int queued = atomic_load_explicit(&axis->commands.enqueue_pos, memory_order_acquire);
+    return (int32_t)(request_frame - motion_frame) < 0 || queued != axis->commands.dequeue_pos;
 }
 
-static esp_err_t read_response(uint8_t* data, size_t* len) {
-    if (!data || !len) {
-        return ESP_ERR_INVALID_ARG;
+static void process_status(struct servo42c_axis* axis, const servo42c_frame_t* reply,
+                           uint32_t request_frame) {
+    servo42c_status_reply_t response;
+    if (!servo42c_decode_status(reply, &response)) {
+        return;
     }
 
-    if (xSemaphoreTake(motor.uart_mutex, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS)) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
+    // Never let an older sample overwrite a newer one
+    if (axis->have_status && (int8_t)(reply->seq - axis->last_status_seq) <= 0) {
+        return;
     }
+    bool first = !axis->have_status;
+    axis->last_status_seq = reply->seq;
+    axis->have_status = true;
+
+    state_write_begin(axis);
+    axis->current = response.current;
+    axis->temperature = response.temperature;
+    axis->status = response.status;
 
-    size_t length = uart_read_bytes(SERVO42C_UART_NUM, data, UART_BUFFER_SIZE, 
-                                  pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS));
-    
-    xSemaphoreGive(motor.uart_mutex);
-    
-    if (length > 0) {
-        *len = length;
-        return ESP_OK;
+    // Update movement and homing status, unless the reply is older than
+    // the last command that changed them. Without encoder readback the
+    // best guess is that a finished move ended on target.
+    if (!status_predates_motion(axis, request_frame)) {
+        axis->is_moving = (response.status & STATUS_MOVING) != 0;
+        if (!axis->is_moving && !axis->have_encoder) {
+            axis->current_position = axis->target_position;
+        }
+        if (response.status & STATUS_HOMED) {
+            axis->is_homed = true;
+        }
+    }
+    state_write_end(axis);
+
+    if (axis->telemetry) {
+        telemetry_record(axis->current_position, axis->current, axis->temperature, axis->status);
+    }
+    if (axis->status_cb) {
+        axis->status_cb(axis, &response, axis->status_ctx);
+    }
+    if (first) {
+        atomic_store(&axis->linked, true);
+        TaskHandle_t waiter = axis->link_waiter;
+        if (waiter) {
+            xTaskNotifyGive(waiter);
+        }
+    }
+
+    // Check error conditions; a fault on any axis stops the machine
+    bool fault = false;
+    if (response.status & STATUS_ERROR) {
+        ESP_LOGE(TAG, "%s: Motor error detected", axis->name);
+        fault = true;
+    }
+
+    const settings_t* limits = settings_get();
+    if (axis->current > limits->max_current_ma) {
+        ESP_LOGE(TAG, "%s: Overcurrent detected: %umA (max: %umA)", axis->name,
+                axis->current, (unsigned int)limits->max_current_ma);
+        fault = true;
+    }
+
+    if (axis->temperature > limits->max_temperature) {
+        ESP_LOGE(TAG, "%s: Overtemperature detected: %u°C (max: %u°C)", axis->name,
+                axis->temperature, (unsigned int)limits->max_temperature);
+        fault = true;
+    }
+
+    if (fault) {
+        // The fault is reported on every poll until it clears; only its
+        // first report starts the telemetry window
+        if (!axis->drive_fault) {
+            telemetry_trigger();
+        }
+        servo42c_emergency_stop_all();
     }
-    
-    return ESP_ERR_TIMEOUT;
+    axis->drive_fault = fault;
 }
 
-static void monitor_task(void* arg) {
-    TickType_t last_wake_time = xTaskGetTickCount();
-    uint8_t response[4];
-    size_t length;
+static int32_t read_be32(const uint8_t* p) {
+    return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                     ((uint32_t)p[2] << 8) | p[3]);
+}
 
-    while (1) {
-        // Process command queue
-        motor_command_t cmd;
-        if (xQueueReceive(motor.command_queue, &cmd, 0) == pdTRUE) {
-            send_command(cmd.cmd, cmd.data, cmd.data_len);
-        }
-
-        // Update motor status
-        if (send_command(CMD_GET_STATUS, NULL, 0) == ESP_OK) {
-            if (read_response(response, &length) == ESP_OK && length == 4) {
-                motor.current = (response[0] << 8) | response[1];
-                motor.temperature = response[2];
-                motor.status = response[3];
-
-                // Update movement status
-                motor.is_moving = (response[3] & STATUS_MOVING) != 0;
-                if (!motor.is_moving) {
-                    motor.current_position = motor.target_position;
-                }
+// The reading is timestamped halfway through the round trip
+static void process_encoder(struct servo42c_axis* axis, const servo42c_frame_t* reply,
+                            int64_t sent_us, int64_t now_us) {
+    if (reply->len != ENCODER_REPLY_LEN) {
+        return;
+    }
 
-                // Update homing status
-                if (response[3] & STATUS_HOMED) {
-                    motor.is_homed = true;
-                }
+    int32_t turns = read_be32(reply->payload);
+    uint16_t fraction = (reply->payload[4] << 8) | reply->payload[5];
+    kin_nm_t position = kin_encoder_to_nm(turns, fraction);
+    int64_t sample_us = sent_us + (now_us - sent_us) / 2;
 
-                // Check error conditions
-                if (response[3] & STATUS_ERROR) {
-                    ESP_LOGE(TAG, "Motor error detected");
-                    servo42c_emergency_stop();
-                }
+    // Replies can be overtaken by a newer one; keep the newest sample
+    if (axis->have_encoder && sample_us <= axis->encoder_time_us) {
+        return;
+    }
 
-                if (motor.current > motor.max_current) {
-                    ESP_LOGE(TAG, "Overcurrent detected: %umA (max: %umA)", 
-                            motor.current, (unsigned int)motor.max_current);
-                    servo42c_emergency_stop();
-                }
+    state_write_begin(axis);
+    axis->current_position = kin_nm_to_mm(position);
+    axis->encoder_time_us = sample_us;
+    axis->have_encoder = true;
+    state_write_end(axis);
+}
 
-                if (motor.temperature > MAX_TEMPERATURE) {
-                    ESP_LOGE(TAG, "Overtemperature detected: %u°C (max: %d°C)", 
-                            motor.temperature, MAX_TEMPERATURE);
-                    servo42c_emergency_stop();
-                }
+static void process_pulses(struct servo42c_axis* axis, const servo42c_frame_t* reply) {
+    if (reply->len != PULSES_REPLY_LEN) {
+        return;
+    }
+
+    state_write_begin(axis);
+    axis->commanded_position = kin_steps_to_mm(read_be32(reply->payload));
+    state_write_end(axis);
+}
+
+static void command_ring_init(command_ring_t* ring) {
+    for (unsigned int i = 0; i < COMMAND_RING_SIZE; i++) {
+        atomic_init(&ring->cells[i].sequence, i);
+    }
+    atomic_init(&ring->enqueue_pos, 0);
+    atomic_init(&ring->flush_until, 0);
+    ring->dequeue_pos = 0;
+}
+
+static bool command_ring_push(command_ring_t* ring, const motor_command_t* cmd) {
+    unsigned int pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    command_cell_t* cell;
+
+    while (1) {
+        cell = &ring->cells[pos & (COMMAND_RING_SIZE - 1)];
+        unsigned int seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            // Cell is free for this position; claim it
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
             }
+        } else if (diff < 0) {
+            return false;   // full
+        } else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    cell->cmd = *cmd;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool command_ring_pop(command_ring_t* ring, motor_command_t* cmd, unsigned int* pos_out) {
+    unsigned int pos = ring->dequeue_pos;
+    command_cell_t* cell = &ring->cells[pos & (COMMAND_RING_SIZE - 1)];
+    unsigned int seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+
+    if ((int)(seq - (pos + 1)) < 0) {
+        return false;   // empty, or the producer is still writing this cell
+    }
+
+    *cmd = cell->cmd;
+    atomic_store_explicit(&cell->sequence, pos + COMMAND_RING_SIZE, memory_order_release);
+    ring->dequeue_pos = pos + 1;
+    *pos_out = pos;
+    return true;
+}
+
+// Drop every command queued so far (used by emergency stop). Safe from
+// any task: the consumer discards entries older than the mark.
+static void command_ring_flush(command_ring_t* ring) {
+    atomic_store_explicit(&ring->flush_until,
+                          atomic_load_explicit(&ring->enqueue_pos, memory_order_acquire),
+                          memory_order_release);
+}
+
+static bool command_ring_flushed(command_ring_t* ring, unsigned int pos) {
+    unsigned int flush_until = atomic_load_explicit(&ring->flush_until, memory_order_acquire);
+    return (int)(flush_until - pos) > 0;
+}
+
+// Remove commands a later one in the same batch makes pointless: only
+// the newest target and the newest speed survive, a SET_POSITION (which
+// carries its own speed) also supersedes earlier SET_SPEEDs, and STOP or
+// HOME act as barriers nothing is merged across. positions[] (each
+// entry's ring position) is compacted along with the batch.
+static size_t coalesce_commands(motor_command_t* batch, unsigned int* positions, size_t count) {
+    bool have_position = false;
+    bool have_speed = false;
+
+    // Walk backwards marking superseded entries, then compact in order
+    bool drop[COMMAND_RING_SIZE] = {0};
+    for (size_t i = count; i-- > 0;) {
+        switch (batch[i].cmd) {
+            case CMD_SET_POSITION:
+                drop[i] = have_position;
+                have_position = true;
+                have_speed = true;
+                break;
+            case CMD_SET_SPEED:
+                drop[i] = have_speed;
+                have_speed = true;
+                break;
+            default:
+                have_position = false;
+                have_speed = false;
+                break;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!drop[i]) {
+            positions[kept] = positions[i];
+            batch[kept++] = batch[i];
+        }
+    }
+    return kept;
+}
+
+// Send a popped command unless an emergency stop has flushed the ring
+// past it since. The stop flushes and sends its frame under the same
+// lock, so a batched command goes out either before the stop frame or
+// not at all.
+static esp_err_t send_queued(struct servo42c_axis* axis, const motor_command_t* cmd, unsigned int pos) {
+    struct servo42c_bus* bus = axis->bus;
+
+    uint32_t wait_start = latency_now();
+    if (xSemaphoreTake(bus->uart_mutex, pdMS_TO_TICKS(UART_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to take UART mutex");
+        return ESP_ERR_TIMEOUT;
+    }
+    latency_end(LATENCY_UART_LOCK, wait_start);
+
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    if (!command_ring_flushed(&axis->commands, pos)) {
+        err = write_frame(bus, axis->address, bus->tx_seq++, cmd->cmd, cmd->data, cmd->data_len);
+        if (err == ESP_OK && cmd->cmd != CMD_SET_SPEED) {
+            atomic_store_explicit(&axis->motion_frame, bus->frames_sent, memory_order_release);
+        }
+    }
+    xSemaphoreGive(bus->uart_mutex);
+    return err;
+}
+
+// Send everything queued for an axis since the last cycle as one batch
+static void drain_commands(struct servo42c_axis* axis) {
+    command_ring_t* ring = &axis->commands;
+    motor_command_t batch[COMMAND_RING_SIZE];
+    unsigned int positions[COMMAND_RING_SIZE];
+    size_t count = 0;
+    unsigned int pos;
+
+    while (count < COMMAND_RING_SIZE && command_ring_pop(ring, &batch[count], &pos)) {
+        if (command_ring_flushed(ring, pos)) {
+            continue;
+        }
+        positions[count++] = pos;
+    }
+
+    size_t kept = coalesce_commands(batch, positions, count);
+    axis->commands_coalesced += count - kept;
+
+    struct servo42c_bus* bus = axis->bus;
+    for (size_t i = 0; i < kept; i++) {
+        if (send_queued(axis, &batch[i], positions[i]) == ESP_ERR_INVALID_STATE) {
+            continue;   // flushed by an emergency stop meanwhile
         }
+        if (bus->half_duplex) {
+            wire_reserve(bus, esp_timer_get_time(), frame_wire_us(bus, batch[i].data_len));
+        }
+    }
+}
+
+static request_t* find_request(struct servo42c_bus* bus, const servo42c_frame_t* reply) {
+    for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+        request_t* request = &bus->in_flight[i];
+        if (request->used && request->seq == reply->seq && request->cmd == reply->cmd &&
+            request->axis->address == reply->addr) {
+            return request;
+        }
+    }
+    return NULL;
+}
+
+static bool send_request(struct servo42c_axis* axis, uint8_t cmd, TickType_t now) {
+    struct servo42c_bus* bus = axis->bus;
+    request_t* slot = NULL;
+    for (int i = 0; i < MAX_IN_FLIGHT && !slot; i++) {
+        if (!bus->in_flight[i].used) {
+            slot = &bus->in_flight[i];
+        }
+    }
+    if (!slot) {
+        return false;
+    }
+
+    uint8_t seq;
+    uint32_t frame;
+    if (send_command_seq(bus, axis->address, cmd, NULL, 0, &seq, &frame) != ESP_OK) {
+        return false;
+    }
+
+    slot->used = true;
+    slot->axis = axis;
+    slot->seq = seq;
+    slot->cmd = cmd;
+    slot->frame = frame;
+    slot->sent_at = now;
+    slot->sent_us = esp_timer_get_time();
+    slot->sent_cycles = latency_now();
+    return true;
+}
+
+static void complete_replies(struct servo42c_bus* bus) {
+    servo42c_frame_t reply;
+
+    while (xQueueReceive(bus->reply_queue, &reply, 0) == pdTRUE) {
+        request_t* request = find_request(bus, &reply);
+        if (!request) {
+            ESP_LOGD(TAG, "Dropping unsolicited reply from 0x%02X seq %u", reply.addr, reply.seq);
+            continue;
+        }
+        request->used = false;
+        latency_end(LATENCY_SERVO_ROUND_TRIP, request->sent_cycles);
+
+        switch (reply.cmd) {
+            case CMD_GET_STATUS:
+                process_status(request->axis, &reply, request->frame);
+                break;
+            case CMD_READ_ENCODER:
+                process_encoder(request->axis, &reply, request->sent_us, esp_timer_get_time());
+                break;
+            case CMD_READ_PULSES:
+                process_pulses(request->axis, &reply);
+                break;
+        }
+    }
+}
+
+static void expire_requests(struct servo42c_bus* bus, TickType_t now) {
+    for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+        request_t* request = &bus->in_flight[i];
+        if (request->used && now - request->sent_at > pdMS_TO_TICKS(REPLY_TIMEOUT_MS)) {
+            request->used = false;
+            bus->link_stats.timeouts++;
+        }
+    }
+}
+
+static TickType_t poll_period(const struct servo42c_axis* axis) {
+    TickType_t period = pdMS_TO_TICKS(axis->is_moving ? POLL_PERIOD_MOVING_MS : POLL_PERIOD_IDLE_MS);
+    return period > 0 ? period : 1;
+}
+
+// One poll round: every axis whose poll is due gets one request, in
+// round-robin order starting after the axis served first last time. The
+// wire is booked for each reply, and the round ends once a control
+// period's worth of replies is outstanding, so on a busy bus the axes
+// take turns instead of the first ones starving the rest. Returns the
+// ticks until the next poll falls due.
+static TickType_t poll_axes(struct servo42c_bus* bus, TickType_t now) {
+    unsigned int count = atomic_load_explicit(&bus->axis_count, memory_order_acquire);
+    int64_t now_us = esp_timer_get_time();
+    int64_t horizon_us = now_us + (int64_t)POLL_PERIOD_MOVING_MS * 1000;
+    TickType_t wait = pdMS_TO_TICKS(POLL_PERIOD_IDLE_MS);
+    bool served_first = false;
+
+    for (unsigned int n = 0; n < count; n++) {
+        unsigned int index = (bus->next_axis + n) % count;
+        struct servo42c_axis* axis = bus->axes[index];
+        TickType_t period = poll_period(axis);
+        TickType_t since_poll = now - axis->last_poll;
 
-        // Check homing timeout
-        if (motor.is_moving && !motor.is_homed) {
-            uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-            if (current_time - motor.homing_start_time > HOMING_TIMEOUT_MS) {
-                ESP_LOGE(TAG, "Homing timeout after %d ms", HOMING_TIMEOUT_MS);
-                servo42c_emergency_stop();
+        if (since_poll < period) {
+            if (period - since_poll < wait) {
+                wait = period - since_poll;
             }
+            continue;
         }
 
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(MONITOR_TASK_PERIOD_MS));
+        uint8_t cmd = poll_schedule[axis->poll_slot];
+        int64_t cost_us = frame_wire_us(bus, reply_payload_len(cmd));
+        if (bus->half_duplex) {
+            cost_us += frame_wire_us(bus, 0);
+        }
+        if (bus->wire_busy_until_us > horizon_us || !send_request(axis, cmd, now)) {
+            ESP_LOGD(TAG, "%s: poll deferred, bus busy", axis->name);
+            wait = 1;
+            continue;
+        }
+        wire_reserve(bus, now_us, cost_us);
+
+        // Poll jitter is what matters while moving; parked polls and the
+        // first one after a start only skew the histogram
+        uint32_t poll_cycles = latency_now();
+        if (axis->is_moving && axis->last_poll_moving) {
+            latency_record(LATENCY_SERVO_POLL, poll_cycles - axis->last_poll_cycles);
+        }
+        axis->last_poll_cycles = poll_cycles;
+        axis->last_poll_moving = axis->is_moving;
+        axis->poll_slot = (axis->poll_slot + 1) % sizeof(poll_schedule);
+        axis->last_poll = now;
+
+        if (!served_first) {
+            bus->next_axis = (index + 1) % count;
+            served_first = true;
+        }
+        if (poll_period(axis) < wait) {
+            wait = poll_period(axis);
+        }
+    }
+    return wait;
+}
+
+static void check_homing(struct servo42c_axis* axis, TickType_t now) {
+    if (axis->is_moving && !axis->is_homed) {
+        uint32_t current_time = now * portTICK_PERIOD_MS;
+        if (current_time - axis->homing_start_time > HOMING_TIMEOUT_MS) {
+            ESP_LOGE(TAG, "%s: Homing timeout after %d ms", axis->name, HOMING_TIMEOUT_MS);
+            telemetry_trigger();
+            servo42c_emergency_stop(axis);
+        }
     }
 }
 
-esp_err_t servo42c_init(const servo42c_config_t* config) {
-    if (!config) {
+// One task per bus runs every axis on it. Status requests are pipelined:
+// each carries a sequence number and several may be in flight, with
+// replies matched by address and sequence as the RX task hands them
+// over. Queued commands and arriving replies wake the task immediately,
+// so neither waits for the next poll.
+static void scheduler_task(void* arg) {
+    struct servo42c_bus* bus = arg;
+    TickType_t wait = 0;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        TickType_t now = xTaskGetTickCount();
+        unsigned int count = atomic_load_explicit(&bus->axis_count, memory_order_acquire);
+
+        complete_replies(bus);
+        expire_requests(bus, now);
+
+        // Send every queued command first; none of them waits for a reply
+        for (unsigned int i = 0; i < count; i++) {
+            drain_commands(bus->axes[i]);
+        }
+
+        wait = poll_axes(bus, now);
+
+        for (unsigned int i = 0; i < count; i++) {
+            check_homing(bus->axes[i], now);
+        }
+
+        TickType_t spent = xTaskGetTickCount() - now;
+        wait = spent < wait ? wait - spent : 0;
+    }
+}
+
+// Queue a command and wake the bus scheduler to send it
+static bool submit_command(struct servo42c_axis* axis, const motor_command_t* cmd) {
+    if (!command_ring_push(&axis->commands, cmd)) {
+        return false;
+    }
+    xTaskNotifyGive(axis->bus->scheduler_task_handle);
+    return true;
+}
+
+esp_err_t servo42c_bus_init(const servo42c_bus_config_t* config, servo42c_bus_handle_t* bus_out) {
+    if (!config || !bus_out) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (buses_used == SERVO42C_MAX_BUSES) {
+        ESP_LOGE(TAG, "No free bus, raise SERVO42C_MAX_BUSES");
+        return ESP_ERR_NO_MEM;
+    }
 
-    ESP_LOGI(TAG, "Initializing Servo42C driver");
+    struct servo42c_bus* bus = &buses[buses_used];
+    memset(bus, 0, sizeof(*bus));
+    bus->uart_num = config->uart_num;
+    bus->baud_rate = config->baud_rate ? config->baud_rate : SERVO42C_BAUD_RATE;
+    bus->half_duplex = config->rts_pin >= 0;
+    atomic_init(&bus->axis_count, 0);
 
     // Initialize UART
     uart_config_t uart_config = {
-        .baud_rate = SERVO42C_BAUD_RATE,
+        .baud_rate = (int)bus->baud_rate,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
@@ -184,185 +817,496 @@ esp_err_t servo42c_init(const servo42c_config_t* config) {
         .source_clk = UART_SCLK_APB,
     };
 
-    ESP_ERROR_CHECK(uart_param_config(SERVO42C_UART_NUM, &uart_config));
-    ESP_ERROR_CHECK(uart_set_pin(SERVO42C_UART_NUM, config->tx_pin, 
-                                config->rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
-    ESP_ERROR_CHECK(uart_driver_install(SERVO42C_UART_NUM, UART_BUFFER_SIZE * 2, 
-                                      UART_BUFFER_SIZE * 2, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(bus->uart_num, &uart_config));
+    ESP_ERROR_CHECK(uart_set_pin(bus->uart_num, config->tx_pin, config->rx_pin,
+                                 bus->half_duplex ? config->rts_pin : UART_PIN_NO_CHANGE,
+                                 UART_PIN_NO_CHANGE));
+    ESP_ERROR_CHECK(uart_driver_install(bus->uart_num, UART_BUFFER_SIZE * 2, 
+                                      UART_BUFFER_SIZE * 2, UART_EVENT_QUEUE_SIZE,
+                                      &bus->uart_event_queue, 0));
+    if (bus->half_duplex) {
+        // The driver toggles RTS around each transmission
+        ESP_ERROR_CHECK(uart_set_mode(bus->uart_num, UART_MODE_RS485_HALF_DUPLEX));
+    }
+    ESP_ERROR_CHECK(uart_set_rx_full_threshold(bus->uart_num, STATUS_FRAME_LEN));
+    ESP_ERROR_CHECK(uart_set_rx_timeout(bus->uart_num, UART_RX_TIMEOUT_SYMBOLS));
 
     // Create synchronization primitives
-    motor.uart_mutex = xSemaphoreCreateMutex();
-    if (!motor.uart_mutex) {
+    bus->uart_mutex = xSemaphoreCreateMutex();
+    if (!bus->uart_mutex) {
         ESP_LOGE(TAG, "Failed to create UART mutex");
         return ESP_ERR_NO_MEM;
     }
+    servo42c_parser_init(&bus->parser, &bus->link_stats);
 
-    motor.command_queue = xQueueCreate(COMMAND_QUEUE_SIZE, sizeof(motor_command_t));
-    if (!motor.command_queue) {
-        vSemaphoreDelete(motor.uart_mutex);
-        ESP_LOGE(TAG, "Failed to create command queue");
+    bus->reply_queue = xQueueCreate(REPLY_QUEUE_SIZE, sizeof(servo42c_frame_t));
+    if (!bus->reply_queue) {
+        vSemaphoreDelete(bus->uart_mutex);
+        ESP_LOGE(TAG, "Failed to create reply queue");
         return ESP_ERR_NO_MEM;
     }
 
-    // Initialize motor state
-    motor.current_position = 0.0f;
-    motor.target_position = 0.0f;
-    motor.speed = 1.0f;
-    motor.is_homed = false;
-    motor.is_moving = false;
-    motor.max_current = MAX_CURRENT;
-
-    // Create monitor task
+    // Create RX task first so no reply can arrive unread
     BaseType_t ret = xTaskCreatePinnedToCore(
-        monitor_task,
-        "motor_monitor",
+        rx_task,
+        "servo_rx",
+        4096,
+        bus,
+        RX_TASK_PRIORITY,
+        &bus->rx_task_handle,
+        1
+    );
+
+    if (ret != pdPASS) {
+        vQueueDelete(bus->reply_queue);
+        vSemaphoreDelete(bus->uart_mutex);
+        ESP_LOGE(TAG, "Failed to create RX task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Create scheduler task
+    ret = xTaskCreatePinnedToCore(
+        scheduler_task,
+        "servo_bus",
         4096,
-        NULL,
-        5,
-        &motor.monitor_task_handle,
+        bus,
+        SCHEDULER_TASK_PRIORITY,
+        &bus->scheduler_task_handle,
         1
     );
 
     if (ret != pdPASS) {
-        vQueueDelete(motor.command_queue);
-        vSemaphoreDelete(motor.uart_mutex);
-        ESP_LOGE(TAG, "Failed to create monitor task");
+        vTaskDelete(bus->rx_task_handle);
+        vQueueDelete(bus->reply_queue);
+        vSemaphoreDelete(bus->uart_mutex);
+        ESP_LOGE(TAG, "Failed to create scheduler task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    buses_used++;
+    *bus_out = bus;
+    ESP_LOGI(TAG, "Servo42C bus on UART%d (TX:%d, RX:%d%s), %lu baud",
+             (int)bus->uart_num, config->tx_pin, config->rx_pin,
+             bus->half_duplex ? ", RS485" : "", (unsigned long)bus->baud_rate);
+    return ESP_OK;
+}
+
+esp_err_t servo42c_add_axis(servo42c_bus_handle_t bus, const servo42c_config_t* config,
+                            servo42c_handle_t* axis_out) {
+    if (!bus || !config || !config->name || !axis_out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Adding axis %s at address 0x%02X", config->name, config->address);
+
+    // Positions are converted with the compiled-in mechanical profile; a
+    // board configuration written for other mechanics must not run
+    esp_err_t err = kinematics_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (fabsf(config->steps_per_mm - KIN_STEPS_PER_MM) > 0.001f) {
+        ESP_LOGE(TAG, "%s: configured %.2f steps/mm, but the %s profile has %.2f", config->name,
+                 config->steps_per_mm, kin_get_profile()->name, KIN_STEPS_PER_MM);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    unsigned int count = atomic_load_explicit(&bus->axis_count, memory_order_relaxed);
+    for (unsigned int i = 0; i < count; i++) {
+        if (bus->axes[i]->address == config->address) {
+            ESP_LOGE(TAG, "%s: address 0x%02X already used by %s", config->name,
+                     config->address, bus->axes[i]->name);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    // The recorder has a single producer
+    if (config->telemetry && telemetry_axis_added) {
+        ESP_LOGE(TAG, "%s: only one axis can record telemetry", config->name);
+        return ESP_ERR_INVALID_STATE;
+    }
+    unsigned int index = atomic_load_explicit(&axes_used, memory_order_relaxed);
+    if (index == SERVO42C_MAX_AXES) {
+        ESP_LOGE(TAG, "No free axis, raise SERVO42C_MAX_AXES");
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "Servo42C initialized on UART%d (TX:%d, RX:%d)", 
-             SERVO42C_UART_NUM, config->tx_pin, config->rx_pin);
+    struct servo42c_axis* axis = &axes[index];
+    memset(axis, 0, sizeof(*axis));
+    axis->name = config->name;
+    axis->address = config->address;
+    axis->telemetry = config->telemetry;
+    axis->bus = bus;
+    portMUX_INITIALIZE(&axis->state_mux);
+    atomic_init(&axis->state_seq, 0);
+    atomic_init(&axis->linked, false);
+    atomic_init(&axis->estop_active, false);
+    atomic_init(&axis->motion_frame, 0);
+    command_ring_init(&axis->commands);
+
+    // Initialize motor state
+    axis->current_position = 0.0f;
+    axis->target_position = 0.0f;
+    axis->speed = 1.0f;
+    axis->is_homed = false;
+    axis->is_moving = false;
+    axis->last_poll = xTaskGetTickCount() - pdMS_TO_TICKS(POLL_PERIOD_IDLE_MS);
+
+    // Publish only once the axis is complete: the scheduler and
+    // servo42c_emergency_stop_all() may already be looking
+    bus->axes[count] = axis;
+    atomic_store_explicit(&bus->axis_count, count + 1, memory_order_release);
+    atomic_store_explicit(&axes_used, index + 1, memory_order_release);
+    telemetry_axis_added |= config->telemetry;
+    xTaskNotifyGive(bus->scheduler_task_handle);
 
+    *axis_out = axis;
     return ESP_OK;
 }
 
-esp_err_t servo42c_move_to(float position_mm, float speed_mm_s) {
-    if (!motor.is_homed) {
-        ESP_LOGE(TAG, "Motor not homed");
+servo42c_handle_t servo42c_find_axis(const char* name) {
+    unsigned int count = atomic_load_explicit(&axes_used, memory_order_acquire);
+    for (unsigned int i = 0; i < count; i++) {
+        if (name && strcmp(axes[i].name, name) == 0) {
+            return &axes[i];
+        }
+    }
+    return NULL;
+}
+
+servo42c_bus_handle_t servo42c_get_bus(servo42c_handle_t axis) {
+    return axis ? axis->bus : NULL;
+}
+
+// Returns the target as the drive will see it: position_mm rounded to
+// the nearest step
+static float encode_move(motor_command_t* cmd, float position_mm, float speed_mm_s) {
+    kin_steps_t steps = kin_mm_to_steps(position_mm);
+    cmd->cmd = CMD_SET_POSITION;
+    cmd->data_len = servo42c_encode_move(cmd->data, steps, kin_speed_to_steps(speed_mm_s));
+    return kin_steps_to_mm(steps);
+}
+
+esp_err_t servo42c_move_to(servo42c_handle_t axis, float position_mm, float speed_mm_s) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!axis->is_homed) {
+        ESP_LOGE(TAG, "%s: Motor not homed", axis->name);
         return ESP_ERR_INVALID_STATE;
     }
 
     if (!safety_is_position_valid(position_mm)) {
-        ESP_LOGE(TAG, "Invalid position: %.2f mm", position_mm);
+        ESP_LOGE(TAG, "%s: Invalid position: %.2f mm", axis->name, position_mm);
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint32_t steps = (uint32_t)(position_mm * SERVO42C_STEPS_PER_MM);
-    uint16_t speed_steps = (uint16_t)(speed_mm_s * SERVO42C_STEPS_PER_MM);
-
-    motor_command_t cmd = {
-        .cmd = CMD_SET_POSITION,
-        .data = {
-            (steps >> 24) & 0xFF,
-            (steps >> 16) & 0xFF,
-            (steps >> 8) & 0xFF,
-            steps & 0xFF,
-            (speed_steps >> 8) & 0xFF,
-            speed_steps & 0xFF
-        },
-        .data_len = 6
-    };
+    motor_command_t cmd;
+    float target = encode_move(&cmd, position_mm, speed_mm_s);
 
-    if (xQueueSend(motor.command_queue, &cmd, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to queue move command");
+    if (!submit_command(axis, &cmd)) {
+        ESP_LOGE(TAG, "%s: Failed to queue move command", axis->name);
         return ESP_FAIL;
     }
 
-    motor.target_position = position_mm;
-    motor.speed = speed_mm_s;
-    motor.is_moving = true;
+    state_write_begin(axis);
+    axis->target_position = target;
+    axis->speed = speed_mm_s;
+    axis->is_moving = true;
+    state_write_end(axis);
+    atomic_store_explicit(&axis->estop_active, false, memory_order_release);
 
-    ESP_LOGI(TAG, "Moving to %.2f mm at %.2f mm/s", position_mm, speed_mm_s);
+    ESP_LOGI(TAG, "%s: Moving to %.2f mm at %.2f mm/s", axis->name, position_mm, speed_mm_s);
     return ESP_OK;
 }
 
-esp_err_t servo42c_stop(void) {
+esp_err_t servo42c_stop(servo42c_handle_t axis) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     motor_command_t cmd = {
         .cmd = CMD_STOP,
         .data_len = 0
     };
 
-    if (xQueueSend(motor.command_queue, &cmd, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to queue stop command");
+    if (!submit_command(axis, &cmd)) {
+        ESP_LOGE(TAG, "%s: Failed to queue stop command", axis->name);
         return ESP_FAIL;
     }
 
-    motor.is_moving = false;
-    ESP_LOGI(TAG, "Motor stopped");
+    state_write_begin(axis);
+    axis->is_moving = false;
+    state_write_end(axis);
+    ESP_LOGI(TAG, "%s: Motor stopped", axis->name);
     return ESP_OK;
 }
 
-esp_err_t servo42c_home(void) {
+esp_err_t servo42c_home(servo42c_handle_t axis) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     motor_command_t cmd = {
         .cmd = CMD_HOME,
         .data_len = 0
     };
 
-    if (xQueueSend(motor.command_queue, &cmd, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to queue home command");
+    if (!submit_command(axis, &cmd)) {
+        ESP_LOGE(TAG, "%s: Failed to queue home command", axis->name);
         return ESP_FAIL;
     }
 
-    motor.is_moving = true;
-    motor.is_homed = false;
-    motor.homing_start_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    ESP_LOGI(TAG, "Starting homing sequence");
+    axis->homing_start_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    state_write_begin(axis);
+    axis->is_moving = true;
+    axis->is_homed = false;
+    state_write_end(axis);
+    atomic_store_explicit(&axis->estop_active, false, memory_order_release);
+    ESP_LOGI(TAG, "%s: Starting homing sequence", axis->name);
+    return ESP_OK;
+}
+
+esp_err_t servo42c_get_state(servo42c_handle_t axis, servo42c_state_t* state) {
+    if (!axis || !state) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    unsigned int begin, end;
+    do {
+        begin = atomic_load_explicit(&axis->state_seq, memory_order_acquire);
+        if (begin & 1) {
+            continue;   // writer active on the other core
+        }
+
+        state->current_position = axis->current_position;
+        state->target_position = axis->target_position;
+        state->speed = axis->speed;
+        state->is_homed = axis->is_homed;
+        state->is_moving = axis->is_moving;
+        state->current = axis->current;
+        state->temperature = axis->temperature;
+        state->status = axis->status;
+
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&axis->state_seq, memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
+
+    state->generation = begin >> 1;
     return ESP_OK;
 }
 
-esp_err_t servo42c_get_state(servo42c_state_t* state) {
-    if (!state) {
+// Advance from a reading toward the target at the commanded speed, as
+// the drive does, for at most MAX_EXTRAPOLATION_US
+static float extrapolate(float from, float target, float speed, int64_t elapsed_us, float* travel_out) {
+    if (elapsed_us < 0) {
+        elapsed_us = 0;
+    } else if (elapsed_us > MAX_EXTRAPOLATION_US) {
+        elapsed_us = MAX_EXTRAPOLATION_US;
+    }
+
+    float travel = speed * (float)elapsed_us / 1e6f;
+    float delta = target - from;
+    if (fabsf(delta) <= travel) {
+        travel = fabsf(delta);
+    }
+    *travel_out = travel;
+    return from + (delta >= 0.0f ? travel : -travel);
+}
+
+esp_err_t servo42c_get_position(servo42c_handle_t axis, servo42c_position_t* position) {
+    if (!axis || !position) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    state->current_position = motor.current_position;
-    state->target_position = motor.target_position;
-    state->speed = motor.speed;
-    state->is_homed = motor.is_homed;
-    state->is_moving = motor.is_moving;
+    float target;
+    float speed;
+    bool moving;
+    unsigned int begin, end;
+    do {
+        begin = atomic_load_explicit(&axis->state_seq, memory_order_acquire);
+        if (begin & 1) {
+            continue;
+        }
+
+        position->encoder = axis->current_position;
+        position->encoder_time_us = axis->encoder_time_us;
+        position->commanded = axis->commanded_position;
+        position->valid = axis->have_encoder;
+        target = axis->target_position;
+        speed = axis->speed;
+        moving = axis->is_moving;
+
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&axis->state_seq, memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
 
+    // Assuming the drive never exceeds the commanded speed, the axis is
+    // somewhere between the reading and the extrapolated point
+    float travel = 0.0f;
+    position->estimated = position->encoder;
+    if (position->valid && moving) {
+        position->estimated = extrapolate(position->encoder, target, speed,
+                                          esp_timer_get_time() - position->encoder_time_us,
+                                          &travel);
+    }
+    position->error_bound = travel;
+    position->following_error = position->commanded - position->encoder;
     return ESP_OK;
 }
 
-esp_err_t servo42c_set_speed(float speed_mm_s) {
+uint32_t servo42c_get_generation(servo42c_handle_t axis) {
+    return atomic_load_explicit(&axis->state_seq, memory_order_acquire) >> 1;
+}
+
+esp_err_t servo42c_set_speed(servo42c_handle_t axis, float speed_mm_s) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
     if (speed_mm_s <= 0.0f) {
-        ESP_LOGE(TAG, "Invalid speed: %.2f mm/s", speed_mm_s);
+        ESP_LOGE(TAG, "%s: Invalid speed: %.2f mm/s", axis->name, speed_mm_s);
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint16_t speed_steps = (uint16_t)(speed_mm_s * SERVO42C_STEPS_PER_MM);
-    motor_command_t cmd = {
-        .cmd = CMD_SET_SPEED,
-        .data = {
-            (speed_steps >> 8) & 0xFF,
-            speed_steps & 0xFF
-        },
-        .data_len = 2
-    };
+    motor_command_t cmd = { .cmd = CMD_SET_SPEED };
+    cmd.data_len = servo42c_encode_speed(cmd.data, kin_speed_to_steps(speed_mm_s));
 
-    if (xQueueSend(motor.command_queue, &cmd, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to queue speed command");
+    if (!submit_command(axis, &cmd)) {
+        ESP_LOGE(TAG, "%s: Failed to queue speed command", axis->name);
         return ESP_FAIL;
     }
 
-    motor.speed = speed_mm_s;
-    ESP_LOGI(TAG, "Speed set to %.2f mm/s", speed_mm_s);
+    state_write_begin(axis);
+    axis->speed = speed_mm_s;
+    state_write_end(axis);
+    ESP_LOGI(TAG, "%s: Speed set to %.2f mm/s", axis->name, speed_mm_s);
     return ESP_OK;
 }
 
-esp_err_t servo42c_emergency_stop(void) {
-    motor_command_t cmd = {
-        .cmd = CMD_EMERGENCY_STOP,
-        .data_len = 0
-    };
+esp_err_t servo42c_emergency_stop(servo42c_handle_t axis) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    // Send emergency stop command directly, bypass queue
-    esp_err_t err = send_command(CMD_EMERGENCY_STOP, NULL, 0);
+    // Drop pending commands, then send the stop directly, bypassing the
+    // ring. Both under the UART lock: the scheduler re-checks the flush
+    // mark under it before each batched command, so none of them goes
+    // out after the stop.
+    struct servo42c_bus* bus = axis->bus;
+    atomic_store_explicit(&axis->estop_active, true, memory_order_release);
+    if (xSemaphoreTake(bus->uart_mutex, pdMS_TO_TICKS(UART_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        command_ring_flush(&axis->commands);
+        ESP_LOGE(TAG, "%s: Failed to take UART mutex for emergency stop", axis->name);
+        return ESP_ERR_TIMEOUT;
+    }
+    command_ring_flush(&axis->commands);
+    esp_err_t err = write_frame(bus, axis->address, bus->tx_seq++, CMD_EMERGENCY_STOP, NULL, 0);
     if (err == ESP_OK) {
-        motor.is_moving = false;
-        // Clear command queue
-        xQueueReset(motor.command_queue);
-        ESP_LOGE(TAG, "Emergency stop activated");
+        atomic_store_explicit(&axis->motion_frame, bus->frames_sent, memory_order_release);
+    }
+    xSemaphoreGive(bus->uart_mutex);
+    if (err == ESP_OK) {
+        state_write_begin(axis);
+        axis->is_moving = false;
+        state_write_end(axis);
+        ESP_LOGE(TAG, "%s: Emergency stop activated", axis->name);
     }
     return err;
+}
+
+// Every axis gets its stop even if sending one of them failed
+esp_err_t servo42c_emergency_stop_all(void) {
+    unsigned int count = atomic_load_explicit(&axes_used, memory_order_acquire);
+    esp_err_t result = ESP_OK;
+
+    for (unsigned int i = 0; i < count; i++) {
+        esp_err_t err = servo42c_emergency_stop(&axes[i]);
+        if (result == ESP_OK) {
+            result = err;
+        }
+    }
+    return result;
+}
+
+esp_err_t servo42c_stream_begin(servo42c_handle_t axis) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!axis->is_homed) {
+        ESP_LOGE(TAG, "%s: Motor not homed", axis->name);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    atomic_store_explicit(&axis->estop_active, false, memory_order_release);
+    return ESP_OK;
+}
+
+esp_err_t servo42c_stream_to(servo42c_handle_t axis, float position_mm, float speed_mm_s) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (atomic_load_explicit(&axis->estop_active, memory_order_acquire) || !axis->is_homed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!safety_is_position_valid(position_mm)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    motor_command_t cmd;
+    float target = encode_move(&cmd, position_mm, speed_mm_s);
+
+    if (!submit_command(axis, &cmd)) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    state_write_begin(axis);
+    axis->target_position = target;
+    axis->speed = speed_mm_s;
+    axis->is_moving = true;
+    state_write_end(axis);
+    return ESP_OK;
+}
+
+esp_err_t servo42c_set_status_callback(servo42c_handle_t axis, servo42c_status_cb_t cb, void* ctx) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    axis->status_ctx = ctx;
+    axis->status_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t servo42c_wait_link(servo42c_handle_t axis, TickType_t ticks_to_wait) {
+    if (!axis) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Registered before the check, so a reply landing in between still
+    // leaves a notification behind
+    axis->link_waiter = xTaskGetCurrentTaskHandle();
+    TickType_t start = xTaskGetTickCount();
+    while (!atomic_load(&axis->linked)) {
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= ticks_to_wait) {
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, ticks_to_wait - waited);
+    }
+    axis->link_waiter = NULL;
+
+    if (!atomic_load(&axis->linked)) {
+        ESP_LOGW(TAG, "%s: no reply from address 0x%02X", axis->name, axis->address);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t servo42c_get_link_stats(servo42c_bus_handle_t bus, servo42c_link_stats_t* stats) {
+    if (!bus || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = bus->link_stats;
+    return ESP_OK;
 }
\ No newline at end of file
@@ -1,38 +1,123 @@
 #pragma once
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "kinematics.h"
+#include "servo42c_proto.h"
 
-// Hardware configuration for JC8048W550C
+// Hardware configuration for JC8048W550C. The drive's UART is wired to
+// two GPIOs neither panel interface, the touch controller (GPIO4-7) nor
+// the safety inputs (18-20) use.
 #define SERVO42C_UART_NUM  1
-#define SERVO42C_TX_PIN    14  // Verified GPIO assignment
-#define SERVO42C_RX_PIN    15  // Verified GPIO assignment
+#define SERVO42C_TX_PIN    17
+#define SERVO42C_RX_PIN    38
 #define SERVO42C_BAUD_RATE 115200
 
-// Mechanical parameters for T8 lead screw
-#define SERVO42C_STEPS_PER_REV   200    // 1.8° step angle
-#define SERVO42C_MICROSTEPS      16     // 16x microstepping
-#define SERVO42C_SCREW_PITCH     2.0f   // T8 lead screw, 2mm pitch
-#define SERVO42C_STEPS_PER_MM    ((SERVO42C_STEPS_PER_REV * SERVO42C_MICROSTEPS) / SERVO42C_SCREW_PITCH)
+// Highest overcurrent trip the drive may be configured with; the trip
+// itself (a status reply above it stops the machine) is a setting
+#define SERVO42C_MAX_CURRENT_MA 3000
+
+// Mechanical parameters (screw, microstepping, gearing) are the
+// compile-time profile in kinematics.h
 
 typedef struct {
-    float current_position;  // mm
+    float current_position;  // mm, last encoder reading
     float target_position;   // mm
     float speed;            // mm/s
     float acceleration;     // mm/s²
     bool is_homed;
     bool is_moving;
+    uint16_t current;       // mA, from the last status reply
+    uint8_t temperature;    // °C
+    uint8_t status;         // raw drive status bits
+    uint32_t generation;    // bumped on every state change
 } servo42c_state_t;
 
+// Measured and estimated axis position. The drive zeroes its encoder and
+// pulse counters when homing completes.
+typedef struct {
+    float estimated;        // mm, now
+    float encoder;          // mm, last encoder reading
+    int64_t encoder_time_us; // esp_timer time the reading was taken
+    float commanded;        // mm, step pulses the drive has generated
+    float following_error;  // mm, commanded - encoder at the last readings
+    float error_bound;      // mm, worst-case error of the extrapolated part
+    bool valid;             // false until the first encoder reply
+} servo42c_position_t;
+
+// One UART (or RS485 segment) with any number of drives on it, each
+// answering to its own slave address. A single scheduler task per bus
+// sends every axis's queued commands and interleaves their status polls
+// within each control period, spending the wire time the replies take
+// round-robin across the axes that are due, so adding an axis adds
+// neither a task nor a UART. Moving axes are polled every period as long
+// as the wire allows; beyond that they share it evenly.
+typedef struct servo42c_bus* servo42c_bus_handle_t;
+typedef struct servo42c_axis* servo42c_handle_t;
+
+#define SERVO42C_MAX_BUSES 2
+#define SERVO42C_MAX_AXES  4     // over all buses
+
 typedef struct {
     uint8_t uart_num;
     uint8_t tx_pin;
     uint8_t rx_pin;
-    float steps_per_mm;
+    int8_t rts_pin;         // RS485 driver enable (half duplex), -1 for a plain UART
+    uint32_t baud_rate;     // 0 for SERVO42C_BAUD_RATE
+} servo42c_bus_config_t;
+
+typedef struct {
+    const char* name;       // "Z", "X", ... for logs and lookup
+    uint8_t address;        // drive slave address, unique on its bus
+    float steps_per_mm;     // must match the compiled-in profile
+    bool telemetry;         // record this axis (at most one)
 } servo42c_config_t;
 
-esp_err_t servo42c_init(const servo42c_config_t* config);
-esp_err_t servo42c_move_to(float position_mm, float speed_mm_s);
-esp_err_t servo42c_stop(void);
-esp_err_t servo42c_home(void);
-esp_err_t servo42c_get_state(servo42c_state_t* state);
-esp_err_t servo42c_set_speed(float speed_mm_s);
-esp_err_t servo42c_emergency_stop(void);
\ No newline at end of file
+esp_err_t servo42c_bus_init(const servo42c_bus_config_t* config, servo42c_bus_handle_t* bus);
+esp_err_t servo42c_add_axis(servo42c_bus_handle_t bus, const servo42c_config_t* config,
+                            servo42c_handle_t* axis);
+
+// NULL if no axis of that name was added
+servo42c_handle_t servo42c_find_axis(const char* name);
+servo42c_bus_handle_t servo42c_get_bus(servo42c_handle_t axis);
+
+esp_err_t servo42c_move_to(servo42c_handle_t axis, float position_mm, float speed_mm_s);
+esp_err_t servo42c_stop(servo42c_handle_t axis);
+esp_err_t servo42c_home(servo42c_handle_t axis);
+// Consistent snapshot of the motor state, safe from any task on either
+// core; never blocks
+esp_err_t servo42c_get_state(servo42c_handle_t axis, servo42c_state_t* state);
+
+// Position at this instant: the last encoder reading advanced along the
+// commanded motion for the time since it was taken. Never blocks.
+esp_err_t servo42c_get_position(servo42c_handle_t axis, servo42c_position_t* position);
+
+// Cheap check for "has anything changed since my last snapshot"
+uint32_t servo42c_get_generation(servo42c_handle_t axis);
+esp_err_t servo42c_set_speed(servo42c_handle_t axis, float speed_mm_s);
+esp_err_t servo42c_emergency_stop(servo42c_handle_t axis);
+
+// Emergency stop for every axis on every bus
+esp_err_t servo42c_emergency_stop_all(void);
+
+// Setpoint streaming for the motion planner: stream_begin() starts a new
+// motion sequence (and clears an emergency-stop latch), stream_to() queues
+// a position setpoint without waiting or logging. stream_to() fails with
+// ESP_ERR_INVALID_STATE once an emergency stop has happened, so a running
+// sequence can never resume motion after one.
+esp_err_t servo42c_stream_begin(servo42c_handle_t axis);
+esp_err_t servo42c_stream_to(servo42c_handle_t axis, float position_mm, float speed_mm_s);
+
+// Called on the bus task with every new status reply of the axis, after
+// the state was updated; must not block. Set before the axis moves.
+typedef void (*servo42c_status_cb_t)(servo42c_handle_t axis, const servo42c_status_reply_t* status,
+                                     void* ctx);
+esp_err_t servo42c_set_status_callback(servo42c_handle_t axis, servo42c_status_cb_t cb, void* ctx);
+
+// Block until the drive has answered its first status poll (the link
+// handshake), ESP_ERR_TIMEOUT if it stays silent. One waiter per axis.
+esp_err_t servo42c_wait_link(servo42c_handle_t axis, TickType_t ticks_to_wait);
+
+// Link-quality counters of a bus since boot (CRC errors, resyncs, timeouts)
+esp_err_t servo42c_get_link_stats(servo42c_bus_handle_t bus, servo42c_link_stats_t* stats);
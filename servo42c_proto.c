@@ -0,0 +1,247 @@
+#include "servo42c_proto.h"
+#include <string.h>
+
+// CRC-8, polynomial 0x07, init 0x00
+static const uint8_t crc8_table[256] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+    0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+    0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+    0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+    0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+    0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+    0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+    0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+    0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+    0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+    0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3,
+};
+
+uint8_t servo42c_crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc8_table[crc ^ data[i]];
+    }
+    return crc;
+}
+
+size_t servo42c_frame_encode(uint8_t* buf, size_t size, uint8_t addr, uint8_t seq, uint8_t cmd,
+                             const uint8_t* payload, size_t len) {
+    if (len > SERVO42C_MAX_PAYLOAD || size < SERVO42C_FRAME_OVERHEAD + len) {
+        return 0;
+    }
+
+    buf[0] = SERVO42C_FRAME_HEADER_1;
+    buf[1] = SERVO42C_FRAME_HEADER_2;
+    buf[2] = addr;
+    buf[3] = (uint8_t)len;
+    buf[4] = seq;
+    buf[5] = cmd;
+    if (len > 0) {
+        memcpy(&buf[6], payload, len);
+    }
+    buf[6 + len] = servo42c_crc8(&buf[2], 4 + len);
+    return SERVO42C_FRAME_OVERHEAD + len;
+}
+
+size_t servo42c_encode_move(uint8_t* payload, int32_t steps, uint16_t speed_steps) {
+    payload[0] = ((uint32_t)steps >> 24) & 0xFF;
+    payload[1] = ((uint32_t)steps >> 16) & 0xFF;
+    payload[2] = ((uint32_t)steps >> 8) & 0xFF;
+    payload[3] = (uint32_t)steps & 0xFF;
+    payload[4] = (speed_steps >> 8) & 0xFF;
+    payload[5] = speed_steps & 0xFF;
+    return SERVO42C_MOVE_PAYLOAD_LEN;
+}
+
+size_t servo42c_encode_speed(uint8_t* payload, uint16_t speed_steps) {
+    payload[0] = (speed_steps >> 8) & 0xFF;
+    payload[1] = speed_steps & 0xFF;
+    return SERVO42C_SPEED_PAYLOAD_LEN;
+}
+
+bool servo42c_decode_status(const servo42c_frame_t* frame, servo42c_status_reply_t* reply) {
+    if (frame->len != SERVO42C_STATUS_PAYLOAD_LEN) {
+        return false;
+    }
+    reply->current = (frame->payload[0] << 8) | frame->payload[1];
+    reply->temperature = frame->payload[2];
+    reply->status = frame->payload[3];
+    return true;
+}
+
+void servo42c_parser_init(servo42c_parser_t* parser, servo42c_link_stats_t* stats) {
+    memset(parser, 0, sizeof(*parser));
+    parser->stats = stats;
+    servo42c_parser_reset(parser);
+}
+
+void servo42c_parser_reset(servo42c_parser_t* parser) {
+    parser->state = PARSE_HEADER_1;
+    parser->raw_len = 0;
+    parser->pending_len = 0;
+    parser->payload_idx = 0;
+    parser->in_sync = false;
+}
+
+static void lose_sync(servo42c_parser_t* parser) {
+    if (parser->in_sync && parser->stats) {
+        parser->stats->resyncs++;
+    }
+    parser->in_sync = false;
+}
+
+// Drop the candidate frame and queue everything after its first header
+// byte to be parsed again, ahead of any bytes already waiting. A real
+// frame may start inside the bytes that were swallowed by the bad one.
+static bool rescan(servo42c_parser_t* parser) {
+    size_t n = parser->raw_len - 1;
+    size_t room = sizeof(parser->pending) - n;
+    if (parser->pending_len > room) {
+        // Only when the caller feeds on without polling
+        if (parser->stats) {
+            parser->stats->overruns++;
+        }
+        parser->pending_len = room;
+    }
+    memmove(&parser->pending[n], parser->pending, parser->pending_len);
+    memcpy(parser->pending, &parser->raw[1], n);
+    parser->pending_len += n;
+
+    lose_sync(parser);
+    parser->state = PARSE_HEADER_1;
+    parser->raw_len = 0;
+    return false;
+}
+
+static bool parse_byte(servo42c_parser_t* parser, uint8_t byte) {
+    servo42c_frame_t* frame = &parser->frame;
+
+    if (parser->state != PARSE_HEADER_1) {
+        parser->raw[parser->raw_len++] = byte;
+    }
+
+    switch (parser->state) {
+        case PARSE_HEADER_1:
+            if (byte == SERVO42C_FRAME_HEADER_1) {
+                parser->raw[0] = byte;
+                parser->raw_len = 1;
+                parser->state = PARSE_HEADER_2;
+            } else {
+                lose_sync(parser);
+            }
+            return false;
+
+        case PARSE_HEADER_2:
+            if (byte == SERVO42C_FRAME_HEADER_2) {
+                parser->state = PARSE_ADDR;
+                return false;
+            }
+            return rescan(parser);
+
+        case PARSE_ADDR:
+            frame->addr = byte;
+            parser->state = PARSE_LEN;
+            return false;
+
+        case PARSE_LEN:
+            if (byte > SERVO42C_MAX_PAYLOAD) {
+                if (parser->stats) {
+                    parser->stats->length_errors++;
+                }
+                return rescan(parser);
+            }
+            frame->len = byte;
+            parser->state = PARSE_SEQ;
+            return false;
+
+        case PARSE_SEQ:
+            frame->seq = byte;
+            parser->state = PARSE_CMD;
+            return false;
+
+        case PARSE_CMD:
+            frame->cmd = byte;
+            parser->payload_idx = 0;
+            parser->state = frame->len > 0 ? PARSE_PAYLOAD : PARSE_CRC;
+            return false;
+
+        case PARSE_PAYLOAD:
+            frame->payload[parser->payload_idx++] = byte;
+            if (parser->payload_idx == frame->len) {
+                parser->state = PARSE_CRC;
+            }
+            return false;
+
+        case PARSE_CRC:
+            if (servo42c_crc8(&parser->raw[2], parser->raw_len - 3) != byte) {
+                if (parser->stats) {
+                    parser->stats->crc_errors++;
+                }
+                return rescan(parser);
+            }
+            if (parser->stats) {
+                parser->stats->frames++;
+            }
+            parser->in_sync = true;
+            parser->state = PARSE_HEADER_1;
+            parser->raw_len = 0;
+            return true;
+    }
+    return false;
+}
+
+// Parse queued bytes up to and including the first one that completes a
+// frame
+static bool drain(servo42c_parser_t* parser) {
+    while (parser->pending_len > 0) {
+        uint8_t byte = parser->pending[0];
+        parser->pending_len--;
+        memmove(parser->pending, &parser->pending[1], parser->pending_len);
+        if (parse_byte(parser, byte)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool servo42c_parser_feed(servo42c_parser_t* parser, uint8_t byte) {
+    if (parser->pending_len == 0) {
+        // A bad frame is re-scanned at once
+        return parse_byte(parser, byte) || drain(parser);
+    }
+
+    // Behind bytes still waiting to be re-scanned
+    if (parser->pending_len == sizeof(parser->pending)) {
+        if (parser->stats) {
+            parser->stats->overruns++;
+        }
+        return drain(parser);
+    }
+    parser->pending[parser->pending_len++] = byte;
+    return drain(parser);
+}
+
+bool servo42c_parser_poll(servo42c_parser_t* parser) {
+    return drain(parser);
+}
+
+size_t servo42c_parser_bytes_needed(const servo42c_parser_t* parser) {
+    const servo42c_frame_t* frame = &parser->frame;
+
+    switch (parser->state) {
+        case PARSE_HEADER_1: return SERVO42C_FRAME_OVERHEAD;
+        case PARSE_HEADER_2: return SERVO42C_FRAME_OVERHEAD - 1;
+        case PARSE_ADDR:     return SERVO42C_FRAME_OVERHEAD - 2;
+        case PARSE_LEN:      return SERVO42C_FRAME_OVERHEAD - 3;
+        case PARSE_SEQ:      return 3 + frame->len;
+        case PARSE_CMD:      return 2 + frame->len;
+        case PARSE_PAYLOAD:  return 1 + (frame->len - parser->payload_idx);
+        case PARSE_CRC:      return 1;
+    }
+    return 1;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// SERVO42C link framing
+//
+//   0xAA 0x55 | addr | len | seq | cmd | payload[len] | crc8
+//
+// addr is the slave address of the drive on a shared bus (requests go to
+// it, replies carry it back), len is the payload length, seq is echoed
+// back in the reply and crc8 (polynomial 0x07) covers addr, len, seq, cmd
+// and the payload.
+
+#define SERVO42C_FRAME_HEADER_1    0xAA
+#define SERVO42C_FRAME_HEADER_2    0x55
+#define SERVO42C_MAX_PAYLOAD       16
+#define SERVO42C_FRAME_OVERHEAD    7    // header(2) + addr + len + seq + cmd + crc
+#define SERVO42C_MAX_FRAME         (SERVO42C_FRAME_OVERHEAD + SERVO42C_MAX_PAYLOAD)
+#define SERVO42C_ADDRESS_DEFAULT   0xE0 // factory setting of the drive
+
+// Payloads, multi-byte fields big-endian:
+//   move    int32 steps | uint16 speed (steps/s)
+//   speed   uint16 speed (steps/s)
+//   status  uint16 current (mA) | uint8 temperature (°C) | uint8 status bits
+#define SERVO42C_MOVE_PAYLOAD_LEN    6
+#define SERVO42C_SPEED_PAYLOAD_LEN   2
+#define SERVO42C_STATUS_PAYLOAD_LEN  4
+
+typedef struct {
+    uint8_t addr;
+    uint8_t seq;
+    uint8_t cmd;
+    uint8_t len;
+    uint8_t payload[SERVO42C_MAX_PAYLOAD];
+} servo42c_frame_t;
+
+// Link-quality counters
+typedef struct {
+    uint32_t frames;        // valid frames received
+    uint32_t crc_errors;    // frames dropped for a bad checksum
+    uint32_t length_errors; // frames dropped for an impossible length
+    uint32_t resyncs;       // times the parser had to hunt for a header
+    uint32_t timeouts;      // replies that never arrived
+    uint32_t overruns;      // receive buffer overflows (bytes lost)
+} servo42c_link_stats_t;
+
+typedef struct {
+    uint16_t current;       // mA
+    uint8_t temperature;    // °C
+    uint8_t status;         // raw status bits
+} servo42c_status_reply_t;
+
+typedef enum {
+    PARSE_HEADER_1,
+    PARSE_HEADER_2,
+    PARSE_ADDR,
+    PARSE_LEN,
+    PARSE_SEQ,
+    PARSE_CMD,
+    PARSE_PAYLOAD,
+    PARSE_CRC,
+} servo42c_parse_state_t;
+
+// Byte-at-a-time frame parser. On a bad frame it re-scans the bytes it
+// consumed for the next header, so one corrupted byte costs one frame
+// and not the frames behind it. Those bytes may hold more than one
+// frame: they wait in `pending` and each call stops at the first frame
+// it completes, so no frame is overwritten before the caller has read it.
+typedef struct {
+    servo42c_parse_state_t state;
+    servo42c_frame_t frame;       // valid once feed() or poll() returned true
+    uint8_t raw[SERVO42C_MAX_FRAME];
+    size_t raw_len;
+    uint8_t pending[2 * SERVO42C_MAX_FRAME];   // bytes to re-scan, oldest first
+    size_t pending_len;
+    size_t payload_idx;
+    bool in_sync;
+    servo42c_link_stats_t* stats; // optional
+} servo42c_parser_t;
+
+void servo42c_parser_init(servo42c_parser_t* parser, servo42c_link_stats_t* stats);
+void servo42c_parser_reset(servo42c_parser_t* parser);
+
+// Returns true when `byte` completed a valid frame (in parser->frame).
+// After a true return, call servo42c_parser_poll() until it returns
+// false: a re-scan may have left further complete frames behind.
+bool servo42c_parser_feed(servo42c_parser_t* parser, uint8_t byte);
+
+// Continue with the bytes left over from a re-scan. Returns true with the
+// next frame in parser->frame, false once they are used up.
+bool servo42c_parser_poll(servo42c_parser_t* parser);
+
+// Bytes still missing before the current frame can complete, with no
+// bytes left to poll. Reading exactly this many never consumes bytes of
+// the frame after it.
+size_t servo42c_parser_bytes_needed(const servo42c_parser_t* parser);
+
+// Encode a frame into buf, returns its length or 0 if it does not fit
+size_t servo42c_frame_encode(uint8_t* buf, size_t size, uint8_t addr, uint8_t seq, uint8_t cmd,
+                             const uint8_t* payload, size_t len);
+
+uint8_t servo42c_crc8(const uint8_t* data, size_t len);
+
+// Payload codecs; encoders return the payload length
+size_t servo42c_encode_move(uint8_t* payload, int32_t steps, uint16_t speed_steps);
+size_t servo42c_encode_speed(uint8_t* payload, uint16_t speed_steps);
+
+// False if the payload is not a status reply
+bool servo42c_decode_status(const servo42c_frame_t* frame, servo42c_status_reply_t* reply);
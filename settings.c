@@ -0,0 +1,301 @@
+#include "settings.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "feed.h"
+#include "kinematics.h"
+#include "servo42c.h"
+
+static const char* TAG = "settings";
+
+#define SETTINGS_DEFAULTS {             \
+    .feed_rate = 1.0f,                  \
+    .depth = 1.0f,                      \
+    .r_plane = 0.5f,                    \
+    .peck = 1.0f,                       \
+    .tool = 0,                          \
+    .jog_speed = 50.0f,                 \
+    .soft_limit_min = 0.0f,             \
+    .soft_limit_max = 200.0f,           \
+    .max_current_ma = 2000,             \
+    .max_temperature = 70,              \
+    .max_speed = 20.0f,                 \
+    .max_accel = 100.0f,                \
+    .max_jerk = 2000.0f,                \
+}
+
+// Usable before settings_init(), e.g. by the benchmarks
+settings_t settings_ram = SETTINGS_DEFAULTS;
+static const settings_t defaults = SETTINGS_DEFAULTS;
+
+typedef enum {
+    TYPE_FLOAT,
+    TYPE_UINT,
+} setting_type_t;
+
+typedef struct {
+    const char* key;        // NVS key, at most 15 characters
+    setting_type_t type;
+    size_t offset;
+    float min;
+    float max;
+} setting_desc_t;
+
+#define FLOAT_SETTING(key, field, min, max) { key, TYPE_FLOAT, offsetof(settings_t, field), min, max }
+#define UINT_SETTING(key, field, min, max)  { key, TYPE_UINT, offsetof(settings_t, field), min, max }
+
+// Indexed by setting_id_t
+static const setting_desc_t descs[SETTING_COUNT] = {
+    [SETTING_FEED_RATE]       = FLOAT_SETTING("feed_rate", feed_rate, 0.1f, 10.0f),
+    [SETTING_DEPTH]           = FLOAT_SETTING("depth", depth, 0.5f, 10.0f),
+    [SETTING_R_PLANE]         = FLOAT_SETTING("r_plane", r_plane, 0.0f, 5.0f),
+    [SETTING_PECK]            = FLOAT_SETTING("peck", peck, 0.1f, 5.0f),
+    [SETTING_TOOL]            = UINT_SETTING("tool", tool, 0, FEED_TOOL_COUNT - 1),
+    [SETTING_JOG_SPEED]       = FLOAT_SETTING("jog_speed", jog_speed, 0.0f, 100.0f),
+    [SETTING_SOFT_LIMIT_MIN]  = FLOAT_SETTING("soft_min", soft_limit_min, -KIN_RANGE_MM, KIN_RANGE_MM),
+    [SETTING_SOFT_LIMIT_MAX]  = FLOAT_SETTING("soft_max", soft_limit_max, -KIN_RANGE_MM, KIN_RANGE_MM),
+    [SETTING_MAX_CURRENT]     = UINT_SETTING("max_current", max_current_ma, 100, SERVO42C_MAX_CURRENT_MA),
+    [SETTING_MAX_TEMPERATURE] = UINT_SETTING("max_temp", max_temperature, 40, 90),
+    [SETTING_MAX_SPEED]       = FLOAT_SETTING("max_speed", max_speed, 1.0f, 100.0f),
+    [SETTING_MAX_ACCEL]       = FLOAT_SETTING("max_accel", max_accel, 10.0f, 1000.0f),
+    [SETTING_MAX_JERK]        = FLOAT_SETTING("max_jerk", max_jerk, 100.0f, 20000.0f),
+};
+
+_Static_assert(sizeof(settings_t) == SETTING_COUNT * sizeof(uint32_t), "one word per setting");
+
+static struct {
+    nvs_handle_t nvs;
+    uint32_t stored[SETTING_COUNT];     // bits last written to (or read from) NVS
+    uint32_t in_nvs;                    // bitmask of setting_id_t with a stored value
+    uint32_t dirty;                     // bitmask of setting_id_t
+    SemaphoreHandle_t mutex;            // setters and the writer
+    TaskHandle_t task_handle;
+} store;
+
+_Static_assert(SETTING_COUNT <= 32, "dirty mask is 32 bits");
+
+// Floats are stored by their bit pattern
+static uint32_t* word(settings_t* settings, setting_id_t id) {
+    return (uint32_t*)((char*)settings + descs[id].offset);
+}
+
+static uint32_t default_bits(setting_id_t id) {
+    uint32_t bits;
+    memcpy(&bits, (const char*)&defaults + descs[id].offset, sizeof(bits));
+    return bits;
+}
+
+static bool in_range(setting_id_t id, uint32_t bits) {
+    const setting_desc_t* desc = &descs[id];
+    if (desc->type == TYPE_UINT) {
+        return bits >= (uint32_t)desc->min && bits <= (uint32_t)desc->max;
+    }
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value >= desc->min && value <= desc->max;   // false for NaN
+}
+
+static float as_float(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Constraints between settings, checked against the values after the
+// change
+static bool consistent(setting_id_t id, uint32_t bits) {
+    const settings_t* s = &settings_ram;
+    switch (id) {
+        case SETTING_SOFT_LIMIT_MIN:
+            return as_float(bits) < s->soft_limit_max;
+        case SETTING_SOFT_LIMIT_MAX:
+            return as_float(bits) > s->soft_limit_min;
+        case SETTING_MAX_SPEED:
+            // Rapids must be expressible in the drive's steps/s field
+            return as_float(bits) <= kin_max_speed();
+        default:
+            return true;
+    }
+}
+
+static esp_err_t set_bits(setting_id_t id, setting_type_t type, uint32_t bits) {
+    if (id >= SETTING_COUNT || descs[id].type != type || !in_range(id, bits)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!store.mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(store.mutex, portMAX_DELAY);
+    if (!consistent(id, bits)) {
+        xSemaphoreGive(store.mutex);
+        ESP_LOGW(TAG, "%s conflicts with a related setting", descs[id].key);
+        return ESP_ERR_INVALID_ARG;
+    }
+    *word(&settings_ram, id) = bits;
+    if (!(store.in_nvs & (1u << id)) || bits != store.stored[id]) {
+        store.dirty |= 1u << id;
+    } else {
+        store.dirty &= ~(1u << id);
+    }
+    bool notify = store.dirty != 0;
+    xSemaphoreGive(store.mutex);
+
+    if (notify && store.task_handle) {
+        xTaskNotifyGive(store.task_handle);
+    }
+    return ESP_OK;
+}
+
+esp_err_t settings_set_float(setting_id_t id, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return set_bits(id, TYPE_FLOAT, bits);
+}
+
+esp_err_t settings_set_uint(setting_id_t id, uint32_t value) {
+    return set_bits(id, TYPE_UINT, value);
+}
+
+esp_err_t settings_flush(void) {
+    uint32_t values[SETTING_COUNT];
+
+    if (!store.mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Snapshot under the lock, write without it: a flash write can take
+    // milliseconds and setters run on the UI task
+    xSemaphoreTake(store.mutex, portMAX_DELAY);
+    uint32_t dirty = store.dirty;
+    store.dirty = 0;
+    for (int id = 0; id < SETTING_COUNT; id++) {
+        values[id] = *word(&settings_ram, id);
+    }
+    xSemaphoreGive(store.mutex);
+
+    if (!dirty) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = ESP_OK;
+    uint32_t written = 0;
+    for (int id = 0; id < SETTING_COUNT && err == ESP_OK; id++) {
+        if (dirty & (1u << id)) {
+            err = nvs_set_u32(store.nvs, descs[id].key, values[id]);
+            written |= 1u << id;
+        }
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(store.nvs);
+    }
+
+    xSemaphoreTake(store.mutex, portMAX_DELAY);
+    if (err == ESP_OK) {
+        for (int id = 0; id < SETTING_COUNT; id++) {
+            if (written & (1u << id)) {
+                store.stored[id] = values[id];
+                store.in_nvs |= 1u << id;
+                // Changed back to the old stored value during the write
+                if (*word(&settings_ram, id) != values[id]) {
+                    store.dirty |= 1u << id;
+                }
+            }
+        }
+    } else {
+        // Retried with the next change or flush
+        store.dirty |= dirty;
+    }
+    bool again = err == ESP_OK && store.dirty != 0;
+    xSemaphoreGive(store.mutex);
+
+    if (again && store.task_handle) {
+        xTaskNotifyGive(store.task_handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGD(TAG, "Wrote %d values", __builtin_popcount(written));
+    return ESP_OK;
+}
+
+// Waits for a change, then for the edits to go quiet (or for
+// SETTINGS_COMMIT_MAX_MS to pass) before writing
+static void settings_task(void* arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        TickType_t first = xTaskGetTickCount();
+        while (xTaskGetTickCount() - first < pdMS_TO_TICKS(SETTINGS_COMMIT_MAX_MS) &&
+               ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS))) {
+        }
+        settings_flush();
+    }
+}
+
+esp_err_t settings_init(void) {
+    ESP_LOGI(TAG, "Loading settings");
+
+    esp_err_t err = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &store.nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    int loaded = 0;
+    for (int id = 0; id < SETTING_COUNT; id++) {
+        uint32_t bits;
+        err = nvs_get_u32(store.nvs, descs[id].key, &bits);
+        if (err == ESP_OK) {
+            store.stored[id] = bits;
+            store.in_nvs |= 1u << id;
+        }
+        if (err == ESP_OK && in_range(id, bits)) {
+            *word(&settings_ram, id) = bits;
+            loaded++;
+        } else {
+            if (err == ESP_OK) {
+                ESP_LOGW(TAG, "%s out of range, using the default", descs[id].key);
+            } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+                ESP_LOGW(TAG, "%s: %s, using the default", descs[id].key, esp_err_to_name(err));
+            }
+            *word(&settings_ram, id) = default_bits(id);
+        }
+    }
+
+    if (!(settings_ram.soft_limit_min < settings_ram.soft_limit_max)) {
+        ESP_LOGW(TAG, "Soft limits inverted, using the defaults");
+        settings_ram.soft_limit_min = defaults.soft_limit_min;
+        settings_ram.soft_limit_max = defaults.soft_limit_max;
+    }
+
+    store.mutex = xSemaphoreCreateMutex();
+    if (!store.mutex) {
+        ESP_LOGE(TAG, "Failed to create settings mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t ret = xTaskCreatePinnedToCore(
+        settings_task,
+        "settings",
+        3072,
+        NULL,
+        1,
+        &store.task_handle,
+        0
+    );
+
+    if (ret != pdPASS) {
+        vSemaphoreDelete(store.mutex);
+        ESP_LOGE(TAG, "Failed to create settings task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "%d of %d settings from NVS", loaded, SETTING_COUNT);
+    return ESP_OK;
+}
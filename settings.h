@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+// Persistent machine settings. Every value lives in a RAM copy loaded
+// from NVS in one pass at boot; reads are plain loads of that copy and
+// never touch flash. Setters validate and update the RAM copy at once
+// and mark the value dirty. A background task writes dirty values to NVS
+// once edits have been quiet for SETTINGS_COMMIT_DELAY_MS, so dragging a
+// slider costs one flash write rather than one per step, and a value
+// whose edits end where they started is not written at all.
+//
+// Each value is one aligned 32-bit word and is updated with a single
+// store, so a reader on any task sees either the old or the new value.
+// Values missing from NVS or outside their range load as the defaults.
+
+#define SETTINGS_NAMESPACE          "settings"
+#define SETTINGS_COMMIT_DELAY_MS    2000    // quiet time before dirty values are written
+#define SETTINGS_COMMIT_MAX_MS      10000   // longest a change waits while edits continue
+
+typedef enum {
+    // Auto cycle
+    SETTING_FEED_RATE = 0,
+    SETTING_DEPTH,
+    SETTING_R_PLANE,
+    SETTING_PECK,
+    SETTING_TOOL,
+    // Manual jog
+    SETTING_JOG_SPEED,
+    // Protection
+    SETTING_SOFT_LIMIT_MIN,
+    SETTING_SOFT_LIMIT_MAX,
+    SETTING_MAX_CURRENT,
+    SETTING_MAX_TEMPERATURE,
+    // Mechanics
+    SETTING_MAX_SPEED,
+    SETTING_MAX_ACCEL,
+    SETTING_MAX_JERK,
+    SETTING_COUNT,
+} setting_id_t;
+
+typedef struct {
+    float feed_rate;            // mm/s
+    float depth;                // mm
+    float r_plane;              // mm
+    float peck;                 // mm
+    uint32_t tool;              // feed_get_tool() index
+    float jog_speed;            // % of the jog maximum
+    float soft_limit_min;       // mm
+    float soft_limit_max;       // mm
+    uint32_t max_current_ma;    // drive overcurrent trip
+    uint32_t max_temperature;   // °C, drive overtemperature trip
+    float max_speed;            // mm/s, also used for rapids
+    float max_accel;            // mm/s²
+    float max_jerk;             // mm/s³
+} settings_t;
+
+// The RAM copy; write only through the setters
+extern settings_t settings_ram;
+
+static inline const settings_t* settings_get(void) {
+    return &settings_ram;
+}
+
+// Load everything from NVS and start the writer. NVS flash must already
+// be initialized.
+esp_err_t settings_init(void);
+
+// ESP_ERR_INVALID_ARG if the value is out of range, of the other type
+// or inconsistent with a related setting
+esp_err_t settings_set_float(setting_id_t id, float value);
+esp_err_t settings_set_uint(setting_id_t id, uint32_t value);
+
+// Write dirty values now, e.g. before a restart
+esp_err_t settings_flush(void);
@@ -0,0 +1,242 @@
+// Control-loop benchmark: boots the firmware on the FreeRTOS POSIX port,
+// homes the simulated axes, runs drill cycles for N simulated seconds and
+// reports loop period, jitter and CPU time of every periodic task, plus
+// the status poll rate of each axis and the link counters of the bus.
+//
+//   bench_control_loop [-t seconds] [-a axes] [-v]
+//
+// -a adds drives next to Z on the same bus (at the following addresses)
+// that make every move together with it, to see how the bus scheduler
+// shares the wire. Exit status is non-zero if an axis failed to home or
+// no cycle finished.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "latency.h"
+#include "servo42c.h"
+#include "sim.h"
+#include "sim_trace.h"
+
+#define DEFAULT_SECONDS 10
+#define HOMING_WAIT_MS 10000
+#define DRILL_DEPTH_MM 5.0f
+#define DRILL_FEED_MM_S 2.0f
+#define RETRACT_MM 1.0f
+#define RETRACT_SPEED_MM_S 10.0f
+
+void app_main(void);
+
+static const char* const axis_names[SERVO42C_MAX_AXES] = { "Z", "X", "Y", "A" };
+
+static uint32_t bench_seconds = DEFAULT_SECONDS;
+static unsigned int axis_count = 1;
+static servo42c_handle_t axes[SERVO42C_MAX_AXES];
+
+static uint32_t elapsed_ms(TickType_t since) {
+    return (uint32_t)((xTaskGetTickCount() - since) * portTICK_PERIOD_MS);
+}
+
+static uint8_t axis_address(unsigned int index) {
+    return SERVO42C_ADDRESS_DEFAULT + index;
+}
+
+static bool all_axes(bool (*test)(const servo42c_state_t* state)) {
+    servo42c_state_t state;
+    for (unsigned int i = 0; i < axis_count; i++) {
+        servo42c_get_state(axes[i], &state);
+        if (!test(&state)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_idle(const servo42c_state_t* state) {
+    return !state->is_moving;
+}
+
+static bool is_homed(const servo42c_state_t* state) {
+    return state->is_homed;
+}
+
+static bool wait_until_idle(uint32_t timeout_ms) {
+    TickType_t start = xTaskGetTickCount();
+
+    do {
+        if (all_axes(is_idle)) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    } while (elapsed_ms(start) < timeout_ms);
+    return false;
+}
+
+static void move_all(float position_mm, float speed_mm_s) {
+    for (unsigned int i = 0; i < axis_count; i++) {
+        servo42c_move_to(axes[i], position_mm, speed_mm_s);
+    }
+}
+
+static void print_report(uint32_t holes, uint32_t run_ms, const uint32_t* status_polls) {
+    sim_trace_stats_t stats[SIM_TRACE_MAX_TASKS];
+    size_t n = sim_trace_get_stats(stats, SIM_TRACE_MAX_TASKS);
+
+    printf("\nControl loop benchmark: %.1f s simulated, %u drill cycles (%.1f holes/min)\n\n",
+           run_ms / 1000.0, (unsigned)holes, run_ms > 0 ? holes * 60000.0 / run_ms : 0.0);
+    printf("%-14s %8s %9s %9s %9s %9s %9s %9s %8s %9s\n",
+           "task", "loops", "nominal", "mean", "min", "max", "jitter", "max_dev", "overrun", "cpu");
+    printf("%-14s %8s %9s %9s %9s %9s %9s %9s %8s %9s\n",
+           "", "", "us", "us", "us", "us", "us(sd)", "us", "", "%");
+
+    for (size_t i = 0; i < n; i++) {
+        const sim_trace_stats_t* s = &stats[i];
+        printf("%-14s %8u %9u %9.1f %9.1f %9.1f %9.1f %9.1f %8u %9.3f\n",
+               s->name, (unsigned)s->loops, (unsigned)s->nominal_us, s->period_mean_us,
+               s->period_min_us, s->period_max_us, s->period_stddev_us, s->max_deviation_us,
+               (unsigned)s->overruns, run_ms > 0 ? 100.0 * s->cpu_us / (run_ms * 1000.0) : 0.0);
+    }
+    printf("\n");
+
+    // One machine-readable line per task for CI scripts
+    for (size_t i = 0; i < n; i++) {
+        const sim_trace_stats_t* s = &stats[i];
+        printf("BENCH task=%s loops=%u mean_us=%.1f stddev_us=%.1f max_us=%.1f overruns=%u cpu_us=%.0f\n",
+               s->name, (unsigned)s->loops, s->period_mean_us, s->period_stddev_us,
+               s->period_max_us, (unsigned)s->overruns, s->cpu_us);
+    }
+
+    uint32_t total_polls = 0;
+    for (unsigned int i = 0; i < axis_count; i++) {
+        printf("BENCH axis=%s status_polls=%u polls_per_s=%.1f\n", axis_names[i],
+               (unsigned)status_polls[i], run_ms > 0 ? status_polls[i] * 1000.0 / run_ms : 0.0);
+        total_polls += status_polls[i];
+    }
+    printf("BENCH status_polls=%u polls_per_s=%.1f\n", (unsigned)total_polls,
+           run_ms > 0 ? total_polls * 1000.0 / run_ms : 0.0);
+
+    servo42c_link_stats_t link;
+    servo42c_get_link_stats(servo42c_get_bus(axes[0]), &link);
+    printf("BENCH link frames=%u crc_errors=%u length_errors=%u resyncs=%u timeouts=%u overruns=%u\n",
+           (unsigned)link.frames, (unsigned)link.crc_errors, (unsigned)link.length_errors,
+           (unsigned)link.resyncs, (unsigned)link.timeouts, (unsigned)link.overruns);
+
+    printf("\n");
+    latency_dump_console();
+    fflush(stdout);
+}
+
+static void bench_task(void* arg) {
+    sim_trace_expect("motion_ctrl", 10000);
+    sim_trace_expect("ui_update", 10000);
+
+    app_main();
+
+    axes[0] = servo42c_find_axis(axis_names[0]);
+    for (unsigned int i = 1; i < axis_count; i++) {
+        servo42c_config_t config = {
+            .name = axis_names[i],
+            .address = axis_address(i),
+            .steps_per_mm = KIN_STEPS_PER_MM,
+        };
+        if (servo42c_add_axis(servo42c_get_bus(axes[0]), &config, &axes[i]) != ESP_OK) {
+            fprintf(stderr, "bench: could not add axis %s\n", axis_names[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (unsigned int i = 0; i < axis_count; i++) {
+        servo42c_home(axes[i]);
+    }
+    TickType_t start = xTaskGetTickCount();
+    bool homed;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        homed = all_axes(is_homed);
+    } while (!homed && elapsed_ms(start) < HOMING_WAIT_MS);
+
+    if (!homed) {
+        fprintf(stderr, "bench: axes did not home within %d ms\n", HOMING_WAIT_MS);
+        exit(EXIT_FAILURE);
+    }
+    wait_until_idle(HOMING_WAIT_MS);
+
+    // Measurement window starts after homing
+    sim_servo_state_t drive;
+    uint32_t polls[SERVO42C_MAX_AXES];
+    for (unsigned int i = 0; i < axis_count; i++) {
+        sim_servo_get_state(axis_address(i), &drive);
+        polls[i] = drive.status_requests;
+    }
+
+    sim_trace_reset();
+    start = xTaskGetTickCount();
+    uint32_t holes = 0;
+    uint32_t window_ms = bench_seconds * 1000;
+
+    while (elapsed_ms(start) < window_ms) {
+        move_all(DRILL_DEPTH_MM, DRILL_FEED_MM_S);
+        if (!wait_until_idle(window_ms)) {
+            break;
+        }
+        move_all(RETRACT_MM, RETRACT_SPEED_MM_S);
+        if (!wait_until_idle(window_ms)) {
+            break;
+        }
+        holes++;
+    }
+
+    uint32_t run_ms = elapsed_ms(start);
+    for (unsigned int i = 0; i < axis_count; i++) {
+        sim_servo_get_state(axis_address(i), &drive);
+        polls[i] = drive.status_requests - polls[i];
+    }
+    print_report(holes, run_ms, polls);
+    exit(holes > 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    bool verbose = false;
+
+    while ((opt = getopt(argc, argv, "t:a:v")) != -1) {
+        switch (opt) {
+            case 't':
+                bench_seconds = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'a':
+                axis_count = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-t seconds] [-a axes] [-v]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (bench_seconds == 0) {
+        bench_seconds = DEFAULT_SECONDS;
+    }
+
+    if (axis_count < 1 || axis_count > SERVO42C_MAX_AXES) {
+        fprintf(stderr, "bench: 1 to %d axes\n", SERVO42C_MAX_AXES);
+        return EXIT_FAILURE;
+    }
+
+    sim_init();
+    for (unsigned int i = 1; i < axis_count; i++) {
+        sim_servo_start(SERVO42C_UART_NUM, axis_address(i));
+    }
+    if (verbose) {
+        esp_log_level_set("*", ESP_LOG_INFO);
+    }
+
+    xTaskCreate(bench_task, "bench", configMINIMAL_STACK_SIZE * 4, NULL, 2, NULL);
+    vTaskStartScheduler();
+    return EXIT_FAILURE;
+}
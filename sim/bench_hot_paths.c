@@ -0,0 +1,386 @@
+// Host microbenchmarks for the firmware's per-poll and per-refresh hot
+// paths: command encoding, status decoding, unit conversion, the soft
+// limit check and the position readout (model update, formatting and
+// label text against a headless LVGL).
+//
+// Each benchmark is timed in isolation, best of several runs, and
+// reported as ns/op and allocations/op (malloc family and LVGL's
+// allocator). With -b the results are compared against a baseline file
+// and any benchmark slower than the tolerance, or allocating more, fails
+// the run:
+//
+//   ./build-sim/bench_hot_paths -w sim/bench_baseline.txt    (record)
+//   ./build-sim/bench_hot_paths -b sim/bench_baseline.txt    (compare)
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "kinematics.h"
+#include "lvgl.h"
+#include "safety.h"
+#include "servo42c.h"
+#include "servo42c_proto.h"
+#include "ui_common.h"
+
+#define TARGET_RUN_NS       20000000ULL   // calibrate each run to ~20 ms
+#define RUNS                5
+#define DEFAULT_TOLERANCE   20.0          // % slower than baseline
+#define MAX_BENCHMARKS      16
+#define NAME_LEN            32
+
+// Allocation counting: the linker routes these through the wrappers
+// below (-Wl,--wrap=...)
+static uint64_t allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real_lv_mem_alloc(size_t size);
+void* __real_lv_mem_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+void* __wrap_lv_mem_alloc(size_t size) {
+    allocations++;
+    return __real_lv_mem_alloc(size);
+}
+
+void* __wrap_lv_mem_realloc(void* ptr, size_t size) {
+    allocations++;
+    return __real_lv_mem_realloc(ptr, size);
+}
+
+// Results feed this so the compiler cannot drop the work
+static volatile uint32_t sink;
+
+static void bench_steps_conversion(uint32_t iters) {
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        float mm = (float)(i & 1023) * 0.05f;
+        acc += kin_mm_to_steps(mm) + kin_speed_to_steps(mm * 0.1f);
+    }
+    sink = acc;
+}
+
+// The integer core alone, as used once a position is fixed-point
+static void bench_nm_to_steps(uint32_t iters) {
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        kin_nm_t nm = (kin_nm_t)(i & 0xFFFFF) * 97 - 50000000;
+        acc += kin_nm_to_steps(nm) + kin_steps_to_nm((kin_steps_t)i & 0xFFFF);
+    }
+    sink = acc;
+}
+
+static void bench_encoder_to_nm(uint32_t iters) {
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        acc += kin_encoder_to_nm((int32_t)(i >> 16 & 63), (uint16_t)i);
+    }
+    sink = acc;
+}
+
+// Same work as encode_move() in servo42c_move_to()
+static void bench_move_encode(uint32_t iters) {
+    uint8_t payload[SERVO42C_MAX_PAYLOAD];
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        float mm = (float)(i & 1023) * 0.05f;
+        acc += servo42c_encode_move(payload, kin_mm_to_steps(mm), kin_speed_to_steps(5.0f));
+        acc += payload[3];
+    }
+    sink = acc;
+}
+
+// Move payload plus framing, as written to the UART
+static void bench_move_frame(uint32_t iters) {
+    uint8_t payload[SERVO42C_MAX_PAYLOAD];
+    uint8_t frame[SERVO42C_MAX_FRAME];
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        float mm = (float)(i & 1023) * 0.05f;
+        size_t len = servo42c_encode_move(payload, kin_mm_to_steps(mm), kin_speed_to_steps(5.0f));
+        acc += servo42c_frame_encode(frame, sizeof(frame), SERVO42C_ADDRESS_DEFAULT, (uint8_t)i, 0x91,
+                                     payload, len);
+        acc += frame[SERVO42C_FRAME_OVERHEAD + len - 1];
+    }
+    sink = acc;
+}
+
+static void bench_speed_encode(uint32_t iters) {
+    uint8_t payload[SERVO42C_MAX_PAYLOAD];
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        acc += servo42c_encode_speed(payload, kin_speed_to_steps((float)(i & 255) * 0.1f));
+        acc += payload[1];
+    }
+    sink = acc;
+}
+
+// A status reply from the wire: parsed byte by byte, then decoded
+static void bench_status_decode(uint32_t iters) {
+    static servo42c_parser_t parser;
+    uint8_t payload[SERVO42C_STATUS_PAYLOAD_LEN] = { 0x01, 0x2C, 35, 0x03 };
+    uint8_t frame[SERVO42C_MAX_FRAME];
+    size_t frame_len = servo42c_frame_encode(frame, sizeof(frame), SERVO42C_ADDRESS_DEFAULT, 0, 0x90,
+                                             payload, sizeof(payload));
+    servo42c_status_reply_t reply;
+    uint32_t acc = 0;
+
+    servo42c_parser_init(&parser, NULL);
+    for (uint32_t i = 0; i < iters; i++) {
+        for (size_t b = 0; b < frame_len; b++) {
+            if (servo42c_parser_feed(&parser, frame[b]) && servo42c_decode_status(&parser.frame, &reply)) {
+                acc += reply.current + reply.status;
+            }
+        }
+    }
+    sink = acc;
+}
+
+static void bench_position_check(uint32_t iters) {
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iters; i++) {
+        acc += safety_is_position_valid((float)(i & 1023) * 0.05f);
+    }
+    sink = acc;
+}
+
+// Every op moves the readout by 0.01 mm, so each one is redrawn
+static void bench_ui_position_changed(uint32_t iters) {
+    static uint32_t step;
+    for (uint32_t i = 0; i < iters; i++) {
+        ui_update_position((float)(step++ % 100000) * 0.01f);
+        ui_process_updates();
+    }
+}
+
+// Republishing the shown value: the model must skip the redraw
+static void bench_ui_position_unchanged(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        ui_update_position(12.34f);
+        ui_process_updates();
+    }
+}
+
+typedef struct {
+    const char* name;
+    void (*run)(uint32_t iters);
+} benchmark_t;
+
+static const benchmark_t benchmarks[] = {
+    { "steps_conversion",     bench_steps_conversion },
+    { "nm_to_steps",          bench_nm_to_steps },
+    { "encoder_to_nm",        bench_encoder_to_nm },
+    { "move_encode",          bench_move_encode },
+    { "move_frame",           bench_move_frame },
+    { "speed_encode",         bench_speed_encode },
+    { "status_decode",        bench_status_decode },
+    { "position_check",       bench_position_check },
+    { "ui_position_changed",  bench_ui_position_changed },
+    { "ui_position_unchanged", bench_ui_position_unchanged },
+};
+
+#define BENCHMARK_COUNT (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+typedef struct {
+    char name[NAME_LEN];
+    double ns_per_op;
+    double allocs_per_op;
+} result_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void measure(const benchmark_t* bench, result_t* result) {
+    // Grow the iteration count until one run takes long enough to time
+    uint32_t iters = 1;
+    for (;;) {
+        uint64_t start = now_ns();
+        bench->run(iters);
+        uint64_t elapsed = now_ns() - start;
+        if (elapsed >= TARGET_RUN_NS / 4 || iters >= (1u << 30)) {
+            if (elapsed > 0) {
+                double scaled = (double)iters * TARGET_RUN_NS / elapsed;
+                iters = scaled > (1u << 30) ? (1u << 30) : (uint32_t)scaled + 1;
+            }
+            break;
+        }
+        iters *= 2;
+    }
+
+    double best = 0.0;
+    for (int run = 0; run < RUNS; run++) {
+        uint64_t allocs_before = allocations;
+        uint64_t start = now_ns();
+        bench->run(iters);
+        double ns_per_op = (double)(now_ns() - start) / iters;
+
+        if (run == 0 || ns_per_op < best) {
+            best = ns_per_op;
+        }
+        result->allocs_per_op = (double)(allocations - allocs_before) / iters;
+    }
+
+    snprintf(result->name, sizeof(result->name), "%s", bench->name);
+    result->ns_per_op = best;
+}
+
+// Baseline file: "name ns_per_op allocs_per_op" per line, '#' comments
+static size_t load_baseline(const char* path, result_t* out, size_t max) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+
+    char line[128];
+    size_t count = 0;
+    while (count < max && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        result_t* r = &out[count];
+        if (sscanf(line, "%31s %lf %lf", r->name, &r->ns_per_op, &r->allocs_per_op) == 3) {
+            count++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+static int save_baseline(const char* path, const result_t* results, size_t count) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "# bench_hot_paths baseline: name ns_per_op allocs_per_op\n");
+    for (size_t i = 0; i < count; i++) {
+        fprintf(f, "%s %.2f %.3f\n", results[i].name, results[i].ns_per_op, results[i].allocs_per_op);
+    }
+    fclose(f);
+    return 0;
+}
+
+static const result_t* find_result(const result_t* results, size_t count, const char* name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(results[i].name, name) == 0) {
+            return &results[i];
+        }
+    }
+    return NULL;
+}
+
+// A headless display, so labels can be created and updated
+static void null_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map) {
+    (void)area;
+    (void)color_map;
+    lv_disp_flush_ready(drv);
+}
+
+static void ui_setup(void) {
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t pixels[800 * 40];
+    static lv_disp_drv_t disp_drv;
+
+    lv_init();
+    lv_disp_draw_buf_init(&draw_buf, pixels, NULL, sizeof(pixels) / sizeof(pixels[0]));
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = 800;
+    disp_drv.ver_res = 480;
+    disp_drv.flush_cb = null_flush;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+
+    position_label = lv_label_create(lv_scr_act());
+}
+
+int main(int argc, char** argv) {
+    const char* baseline_path = NULL;
+    const char* write_path = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:w:t:")) != -1) {
+        switch (opt) {
+            case 'b':
+                baseline_path = optarg;
+                break;
+            case 'w':
+                write_path = optarg;
+                break;
+            case 't':
+                tolerance = strtod(optarg, NULL);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-b baseline] [-w baseline] [-t tolerance %%]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // The soft limit check logs on rejects only; keep the console quiet
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    if (kinematics_init() != ESP_OK) {
+        return EXIT_FAILURE;
+    }
+    ui_setup();
+
+    result_t results[BENCHMARK_COUNT];
+    for (size_t i = 0; i < BENCHMARK_COUNT; i++) {
+        measure(&benchmarks[i], &results[i]);
+    }
+
+    result_t baseline[MAX_BENCHMARKS];
+    size_t baseline_count = baseline_path ? load_baseline(baseline_path, baseline, MAX_BENCHMARKS) : 0;
+    int regressions = 0;
+
+    printf("%-24s %10s %10s %10s %8s\n", "benchmark", "ns/op", "allocs/op", "base ns/op", "change");
+    for (size_t i = 0; i < BENCHMARK_COUNT; i++) {
+        const result_t* r = &results[i];
+        const result_t* base = find_result(baseline, baseline_count, r->name);
+        printf("%-24s %10.2f %10.3f", r->name, r->ns_per_op, r->allocs_per_op);
+
+        if (!base) {
+            printf(" %10s %8s\n", "-", "-");
+            continue;
+        }
+        double change = base->ns_per_op > 0 ? (r->ns_per_op / base->ns_per_op - 1.0) * 100.0 : 0.0;
+        bool slower = change > tolerance;
+        bool allocates = r->allocs_per_op > base->allocs_per_op + 0.0005;
+        printf(" %10.2f %+7.1f%%%s%s\n", base->ns_per_op, change,
+               slower ? "  SLOWER" : "", allocates ? "  MORE ALLOCS" : "");
+        if (slower || allocates) {
+            regressions++;
+        }
+    }
+
+    if (write_path && save_baseline(write_path, results, BENCHMARK_COUNT) == 0) {
+        printf("\nBaseline written to %s\n", write_path);
+    }
+    if (baseline_path) {
+        printf("\n%d regression(s) against %s (tolerance %.0f%%)\n", regressions, baseline_path, tolerance);
+    }
+    return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
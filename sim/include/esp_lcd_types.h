@@ -0,0 +1,4 @@
+#pragma once
+// Host stand-in for ESP-IDF esp_lcd_types.h
+
+typedef struct esp_lcd_panel_t* esp_lcd_panel_handle_t;
@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in for ESP-IDF esp_rom_sys.h
+
+#include <stdint.h>
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in for ESP-IDF esp_system.h
+
+#include "esp_err.h"
+
+void esp_restart(void) __attribute__((noreturn));
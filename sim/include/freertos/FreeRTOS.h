@@ -0,0 +1,34 @@
+#pragma once
+// Host stand-in for ESP-IDF's freertos/FreeRTOS.h: the vanilla kernel
+// (POSIX port) plus the ESP-IDF SMP extensions the firmware relies on.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <FreeRTOS.h>
+#include "esp_attr.h"
+
+// The POSIX port runs every task on one host scheduler; the core
+// affinity is accepted and ignored. ESP-IDF stack sizes are in bytes.
+#define xTaskCreatePinnedToCore(fn, name, stack_bytes, arg, prio, handle, core) \
+    xTaskCreate((fn), (name), (stack_bytes) / sizeof(StackType_t) + configMINIMAL_STACK_SIZE, \
+                (arg), (prio), (handle))
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// ESP-IDF critical sections take a spinlock that also keeps the other
+// core out. With one host scheduler the kernel critical section alone
+// gives the same guarantee, so the lock argument is ignored.
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0, 0 }
+#define portMUX_INITIALIZE(mux)      (*(mux) = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED)
+
+#undef portENTER_CRITICAL
+#undef portEXIT_CRITICAL
+#define portENTER_CRITICAL(...)      vPortEnterCritical()
+#define portEXIT_CRITICAL(...)       vPortExitCritical()
+#define portENTER_CRITICAL_ISR(mux)  vPortEnterCritical()
+#define portEXIT_CRITICAL_ISR(mux)   vPortExitCritical()
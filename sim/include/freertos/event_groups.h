@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for ESP-IDF's freertos/event_groups.h
+
+#include "freertos/FreeRTOS.h"
+#include <event_groups.h>
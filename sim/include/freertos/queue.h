@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for ESP-IDF's freertos/queue.h
+
+#include "freertos/FreeRTOS.h"
+#include <queue.h>
@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for ESP-IDF's freertos/semphr.h
+
+#include "freertos/FreeRTOS.h"
+#include <semphr.h>
@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for ESP-IDF's freertos/stream_buffer.h
+
+#include "freertos/FreeRTOS.h"
+#include <stream_buffer.h>
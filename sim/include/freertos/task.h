@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for ESP-IDF's freertos/task.h
+
+#include "freertos/FreeRTOS.h"
+#include <task.h>
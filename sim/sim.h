@@ -0,0 +1,53 @@
+#pragma once
+// Control surface of the host simulation: the stand-in ESP-IDF drivers
+// talk to the simulated devices declared here.
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/i2c.h"
+#include "gt911.h"
+
+// Bring up the simulated board: SERVO42C at the default address on
+// UART1, GT911 on I2C0
+void sim_init(void);
+
+// Drive an input pin from the outside world, firing its ISR on an edge
+void sim_gpio_set_input(int gpio_num, int level);
+
+// Device side of a simulated UART link
+size_t sim_uart_device_read(int uart_num, uint8_t* buf, size_t len, TickType_t ticks_to_wait);
+size_t sim_uart_device_write(int uart_num, const uint8_t* buf, size_t len);
+
+// Simulated I2C slave
+typedef struct {
+    uint8_t addr;
+    void (*write)(void* ctx, const uint8_t* data, size_t len);
+    void (*read)(void* ctx, uint8_t* data, size_t len);
+    void* ctx;
+} sim_i2c_device_t;
+
+esp_err_t sim_i2c_attach(i2c_port_t port, const sim_i2c_device_t* dev);
+
+// Burn the wall-clock time a transfer of `bits` takes at `clock_hz`
+void sim_wire_delay(uint64_t bits, uint32_t clock_hz);
+
+// SERVO42C drive models, any number on one UART up to a small limit,
+// each at its own address
+typedef struct {
+    float position_mm;
+    float target_mm;
+    bool homed;
+    bool moving;
+    uint32_t commands;
+    uint32_t status_requests;
+} sim_servo_state_t;
+
+void sim_servo_start(int uart_num, uint8_t address);
+bool sim_servo_get_state(uint8_t address, sim_servo_state_t* state);
+
+// GT911 touch controller model
+void sim_gt911_start(i2c_port_t port, int int_gpio);
+void sim_gt911_touch(int x, int y, bool pressed);
+void sim_gt911_report(const gt911_point_t* points, int count);
@@ -0,0 +1,14 @@
+// JC8048W550C board model: wires the simulated devices to the buses the
+// firmware drivers expect them on.
+
+#include "esp_log.h"
+#include "driver/i2c.h"
+#include "gt911.h"
+#include "servo42c.h"
+#include "sim.h"
+
+void sim_init(void) {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    sim_servo_start(SERVO42C_UART_NUM, SERVO42C_ADDRESS_DEFAULT);
+    sim_gt911_start(I2C_NUM_0, GT911_INT_PIN);
+}
@@ -0,0 +1,207 @@
+// Host implementations of the ESP-IDF system services the firmware uses:
+// error names, logging, esp_timer, heap_caps, the cycle counter and the
+// FreeRTOS assert hook.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "sim.h"
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    TimerHandle_t timer;
+};
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                   return "ESP_OK";
+        case ESP_FAIL:                 return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:           return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:      return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:    return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:     return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:        return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:    return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:          return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:      return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_NVS_NOT_INITIALIZED:   return "ESP_ERR_NVS_NOT_INITIALIZED";
+        case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_NOT_ENOUGH_SPACE:  return "ESP_ERR_NVS_NOT_ENOUGH_SPACE";
+        case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+        default:                       return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+    (void)tag;  // one global level is enough for the simulation
+    log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    static const char letters[] = "NEWIDV";
+
+    if (level > log_level) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%c (%lu) %s: ", letters[level],
+            (unsigned long)(esp_timer_get_time() / 1000), tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+void esp_restart(void) {
+    fprintf(stderr, "esp_restart() called, exiting simulation\n");
+    exit(EXIT_FAILURE);
+}
+
+void vAssertCalled(const char* file, unsigned long line) {
+    fprintf(stderr, "FreeRTOS assert failed at %s:%lu\n", file, line);
+    abort();
+}
+
+int64_t esp_timer_get_time(void) {
+    static struct timespec start;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (start.tv_sec == 0 && start.tv_nsec == 0) {
+        start = now;
+    }
+    return (int64_t)(now.tv_sec - start.tv_sec) * 1000000 +
+           (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+// Nanoseconds stand in for CPU cycles: 1000 "cycles" per microsecond
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (esp_cpu_cycle_count_t)((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void) {
+    return 1000;
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+// The host heap is not modelled: reports nothing free, which callers
+// treat as unknown
+size_t heap_caps_get_free_size(uint32_t caps) {
+    (void)caps;
+    return 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    (void)caps;
+    return 0;
+}
+
+static void timer_trampoline(TimerHandle_t timer) {
+    struct esp_timer* t = pvTimerGetTimerID(timer);
+    t->callback(t->arg);
+}
+
+static TickType_t us_to_ticks(uint64_t us) {
+    TickType_t ticks = (TickType_t)(us / (1000 * portTICK_PERIOD_MS));
+    return ticks > 0 ? ticks : 1;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct esp_timer* t = calloc(1, sizeof(*t));
+    if (!t) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    t->callback = create_args->callback;
+    t->arg = create_args->arg;
+    t->timer = xTimerCreate(create_args->name ? create_args->name : "esp_timer",
+                            1, pdFALSE, t, timer_trampoline);
+    if (!t->timer) {
+        free(t);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *out_handle = t;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t us, bool periodic) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    vTimerSetReloadMode(timer->timer, periodic ? pdTRUE : pdFALSE);
+    if (xTimerChangePeriod(timer->timer, us_to_ticks(us), portMAX_DELAY) != pdPASS) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return timer_start(timer, timeout_us, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    return timer_start(timer, period, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!xTimerIsTimerActive(timer->timer)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTimerStop(timer->timer, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xTimerDelete(timer->timer, portMAX_DELAY);
+    free(timer);
+    return ESP_OK;
+}
+
+void sim_wire_delay(uint64_t bits, uint32_t clock_hz) {
+    if (clock_hz == 0 || bits == 0) {
+        return;
+    }
+
+    // Busy-wait: the polled drivers being modelled keep the CPU spinning
+    int64_t until = esp_timer_get_time() + (int64_t)(bits * 1000000ULL / clock_hz);
+    while (esp_timer_get_time() < until) {
+    }
+}
@@ -0,0 +1,157 @@
+// Stand-in GPIO driver: pin levels live in RAM, inputs are driven by
+// sim_gpio_set_input() and edge ISRs run in the caller's context.
+
+#include <string.h>
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sim.h"
+
+static struct {
+    int level;
+    gpio_mode_t mode;
+    gpio_int_type_t intr_type;
+    bool intr_enabled;
+    gpio_isr_t isr;
+    void* isr_arg;
+} pins[GPIO_NUM_MAX];
+
+static bool isr_service_installed;
+
+static bool valid_pin(int gpio_num) {
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (!(config->pin_bit_mask & (1ULL << pin))) {
+            continue;
+        }
+        pins[pin].mode = config->mode;
+        pins[pin].intr_type = config->intr_type;
+        pins[pin].intr_enabled = config->intr_type != GPIO_INTR_DISABLE;
+        if (config->pull_up_en == GPIO_PULLUP_ENABLE) {
+            pins[pin].level = 1;
+        } else if (config->pull_down_en == GPIO_PULLDOWN_ENABLE) {
+            pins[pin].level = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&pins[gpio_num], 0, sizeof(pins[gpio_num]));
+    pins[gpio_num].level = 1;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].intr_type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].level = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return 0;
+    }
+    return pins[gpio_num].level;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+    if (isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    isr_service_installed = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pins[gpio_num].isr = isr_handler;
+    pins[gpio_num].isr_arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].isr = NULL;
+    pins[gpio_num].isr_arg = NULL;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].intr_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+    if (!valid_pin(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pins[gpio_num].intr_enabled = false;
+    return ESP_OK;
+}
+
+static bool edge_fires(gpio_int_type_t type, int old_level, int new_level) {
+    switch (type) {
+        case GPIO_INTR_POSEDGE:    return old_level == 0 && new_level == 1;
+        case GPIO_INTR_NEGEDGE:    return old_level == 1 && new_level == 0;
+        case GPIO_INTR_ANYEDGE:    return old_level != new_level;
+        case GPIO_INTR_LOW_LEVEL:  return new_level == 0;
+        case GPIO_INTR_HIGH_LEVEL: return new_level == 1;
+        default:                   return false;
+    }
+}
+
+void sim_gpio_set_input(int gpio_num, int level) {
+    if (!valid_pin(gpio_num)) {
+        return;
+    }
+
+    int old_level = pins[gpio_num].level;
+    pins[gpio_num].level = level ? 1 : 0;
+
+    if (pins[gpio_num].intr_enabled && pins[gpio_num].isr &&
+        edge_fires(pins[gpio_num].intr_type, old_level, pins[gpio_num].level)) {
+        // The POSIX port has no real interrupt context; the handler runs
+        // in the calling task and its FromISR calls behave accordingly.
+        pins[gpio_num].isr(pins[gpio_num].isr_arg);
+    }
+}
@@ -0,0 +1,99 @@
+// GT911 touch controller model: a register file behind I2C address 0x5D
+// that reports up to five touch points and pulses INT for every report.
+
+#include <string.h>
+#include "gt911.h"
+#include "sim.h"
+
+#define REG_BASE 0x8040
+#define REG_SIZE 0x1C0
+
+static struct {
+    uint8_t regs[REG_SIZE];
+    uint16_t pointer;
+    int int_gpio;
+} gt911;
+
+static uint8_t* reg_at(uint16_t reg) {
+    if (reg < REG_BASE || reg >= REG_BASE + REG_SIZE) {
+        return NULL;
+    }
+    return &gt911.regs[reg - REG_BASE];
+}
+
+static void regs_write(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    if (len < 2) {
+        return;
+    }
+
+    gt911.pointer = (uint16_t)((data[0] << 8) | data[1]);
+    for (size_t i = 2; i < len; i++) {
+        uint8_t* reg = reg_at(gt911.pointer++);
+        if (reg) {
+            *reg = data[i];
+        }
+    }
+}
+
+static void regs_read(void* ctx, uint8_t* data, size_t len) {
+    (void)ctx;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t* reg = reg_at(gt911.pointer++);
+        data[i] = reg ? *reg : 0;
+    }
+}
+
+void sim_gt911_start(i2c_port_t port, int int_gpio) {
+    memset(&gt911, 0, sizeof(gt911));
+    gt911.int_gpio = int_gpio;
+    memcpy(reg_at(0x8140), "911", 3);  // product ID
+
+    // 800x480 reported in the config block
+    *reg_at(GT911_REG_RESOLUTION + 0) = 800 & 0xFF;
+    *reg_at(GT911_REG_RESOLUTION + 1) = 800 >> 8;
+    *reg_at(GT911_REG_RESOLUTION + 2) = 480 & 0xFF;
+    *reg_at(GT911_REG_RESOLUTION + 3) = 480 >> 8;
+
+    sim_i2c_device_t dev = {
+        .addr = GT911_I2C_ADDR,
+        .write = regs_write,
+        .read = regs_read,
+    };
+    ESP_ERROR_CHECK(sim_i2c_attach(port, &dev));
+    sim_gpio_set_input(int_gpio, 1);
+}
+
+void sim_gt911_report(const gt911_point_t* points, int count) {
+    if (count > GT911_MAX_TOUCH) {
+        count = GT911_MAX_TOUCH;
+    }
+
+    uint8_t* records = reg_at(GT911_REG_TRACK_ID);
+    memset(records, 0, GT911_MAX_TOUCH * GT911_POINT_SIZE);
+    for (int i = 0; i < count; i++) {
+        uint8_t* point = &records[i * GT911_POINT_SIZE];
+        point[0] = points[i].id;
+        point[1] = points[i].x & 0xFF;
+        point[2] = (points[i].x >> 8) & 0xFF;
+        point[3] = points[i].y & 0xFF;
+        point[4] = (points[i].y >> 8) & 0xFF;
+        point[5] = points[i].size & 0xFF;
+        point[6] = (points[i].size >> 8) & 0xFF;
+    }
+    // Buffer-ready flag plus number of touch points
+    *reg_at(GT911_REG_STATUS) = 0x80 | (uint8_t)count;
+
+    // INT is pulsed low for each new report
+    sim_gpio_set_input(gt911.int_gpio, 0);
+    sim_gpio_set_input(gt911.int_gpio, 1);
+}
+
+void sim_gt911_touch(int x, int y, bool pressed) {
+    gt911_point_t point = {
+        .x = (uint16_t)x,
+        .y = (uint16_t)y,
+        .size = 30,  // contact size
+    };
+    sim_gt911_report(&point, pressed ? 1 : 0);
+}
\ No newline at end of file
@@ -0,0 +1,234 @@
+// Stand-in for the legacy I2C command-link driver: the queued operations
+// are replayed against simulated slaves attached with sim_i2c_attach().
+
+#include <stdlib.h>
+#include <string.h>
+#include "driver/i2c.h"
+#include "sim.h"
+
+#define SIM_I2C_MAX_PORTS 2
+#define SIM_I2C_MAX_DEVICES 4
+#define SIM_I2C_LINK_OPS 16
+#define SIM_I2C_MAX_WRITE 64
+
+typedef enum {
+    OP_START,
+    OP_WRITE,
+    OP_READ,
+    OP_STOP,
+} i2c_op_type_t;
+
+typedef struct {
+    i2c_op_type_t type;
+    uint8_t byte;            // single-byte write payload
+    const uint8_t* src;      // multi-byte write payload, NULL for single byte
+    uint8_t* dst;
+    size_t len;
+} i2c_op_t;
+
+typedef struct {
+    bool is_static;
+    size_t count;
+    size_t capacity;
+    i2c_op_t ops[];
+} i2c_link_t;
+
+static struct {
+    bool installed;
+    uint32_t clk_speed;
+    sim_i2c_device_t devices[SIM_I2C_MAX_DEVICES];
+    size_t device_count;
+} ports[SIM_I2C_MAX_PORTS];
+
+static bool valid_port(i2c_port_t port) {
+    return port >= 0 && port < SIM_I2C_MAX_PORTS;
+}
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t* i2c_conf) {
+    if (!valid_port(i2c_num) || !i2c_conf) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ports[i2c_num].clk_speed = i2c_conf->master.clk_speed;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len,
+                             size_t slv_tx_buf_len, int intr_alloc_flags) {
+    (void)slv_rx_buf_len;
+    (void)slv_tx_buf_len;
+    (void)intr_alloc_flags;
+    if (!valid_port(i2c_num) || mode != I2C_MODE_MASTER) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ports[i2c_num].installed) {
+        return ESP_FAIL;
+    }
+    ports[i2c_num].installed = true;
+    return ESP_OK;
+}
+
+esp_err_t sim_i2c_attach(i2c_port_t port, const sim_i2c_device_t* dev) {
+    if (!valid_port(port) || !dev || ports[port].device_count >= SIM_I2C_MAX_DEVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ports[port].devices[ports[port].device_count++] = *dev;
+    return ESP_OK;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void) {
+    i2c_link_t* link = calloc(1, sizeof(i2c_link_t) + SIM_I2C_LINK_OPS * sizeof(i2c_op_t));
+    if (link) {
+        link->capacity = SIM_I2C_LINK_OPS;
+    }
+    return link;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t* buffer, uint32_t size) {
+    if (!buffer || size < sizeof(i2c_link_t) + sizeof(i2c_op_t)) {
+        return NULL;
+    }
+    i2c_link_t* link = (i2c_link_t*)buffer;
+    memset(link, 0, sizeof(*link));
+    link->is_static = true;
+    link->capacity = (size - sizeof(i2c_link_t)) / sizeof(i2c_op_t);
+    return link;
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle) {
+    free(cmd_handle);
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle) {
+    (void)cmd_handle;
+}
+
+static esp_err_t push_op(i2c_cmd_handle_t cmd_handle, const i2c_op_t* op) {
+    i2c_link_t* link = cmd_handle;
+    if (!link) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (link->count >= link->capacity) {
+        return ESP_ERR_NO_MEM;
+    }
+    link->ops[link->count++] = *op;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle) {
+    return push_op(cmd_handle, &(i2c_op_t){ .type = OP_START });
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle) {
+    return push_op(cmd_handle, &(i2c_op_t){ .type = OP_STOP });
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data, bool ack_en) {
+    (void)ack_en;
+    return push_op(cmd_handle, &(i2c_op_t){ .type = OP_WRITE, .byte = data, .len = 1 });
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, const uint8_t* data, size_t data_len, bool ack_en) {
+    (void)ack_en;
+    return push_op(cmd_handle, &(i2c_op_t){ .type = OP_WRITE, .src = data, .len = data_len });
+}
+
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd_handle, uint8_t* data, i2c_ack_type_t ack) {
+    (void)ack;
+    return push_op(cmd_handle, &(i2c_op_t){ .type = OP_READ, .dst = data, .len = 1 });
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t* data, size_t data_len, i2c_ack_type_t ack) {
+    (void)ack;
+    return push_op(cmd_handle, &(i2c_op_t){ .type = OP_READ, .dst = data, .len = data_len });
+}
+
+static sim_i2c_device_t* find_device(i2c_port_t port, uint8_t addr) {
+    for (size_t i = 0; i < ports[port].device_count; i++) {
+        if (ports[port].devices[i].addr == addr) {
+            return &ports[port].devices[i];
+        }
+    }
+    return NULL;
+}
+
+// Write bytes of one addressed segment are delivered in a single call so
+// the device sees register pointer and payload together.
+static void flush_writes(sim_i2c_device_t* dev, const uint8_t* buf, size_t* len) {
+    if (dev && dev->write && *len > 0) {
+        dev->write(dev->ctx, buf, *len);
+    }
+    *len = 0;
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    i2c_link_t* link = cmd_handle;
+    if (!valid_port(i2c_num) || !link) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!ports[i2c_num].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sim_i2c_device_t* dev = NULL;
+    bool expect_address = false;
+    uint8_t pending[SIM_I2C_MAX_WRITE];
+    size_t pending_len = 0;
+    uint64_t bits = 0;
+    esp_err_t ret = ESP_OK;
+
+    for (size_t i = 0; i < link->count && ret == ESP_OK; i++) {
+        const i2c_op_t* op = &link->ops[i];
+        const uint8_t* src = op->src ? op->src : &op->byte;
+        size_t len = op->len;
+
+        switch (op->type) {
+            case OP_START:
+                flush_writes(dev, pending, &pending_len);
+                expect_address = true;
+                bits += 1;
+                break;
+            case OP_STOP:
+                flush_writes(dev, pending, &pending_len);
+                dev = NULL;
+                bits += 1;
+                break;
+            case OP_WRITE:
+                bits += 9 * (uint64_t)len;
+                if (expect_address && len > 0) {
+                    dev = find_device(i2c_num, src[0] >> 1);
+                    if (!dev) {
+                        ret = ESP_FAIL;  // address NACK
+                        break;
+                    }
+                    expect_address = false;
+                    src++;
+                    len--;
+                }
+                if (pending_len + len > sizeof(pending)) {
+                    ret = ESP_ERR_INVALID_SIZE;
+                    break;
+                }
+                memcpy(pending + pending_len, src, len);
+                pending_len += len;
+                break;
+            case OP_READ:
+                bits += 9 * (uint64_t)len;
+                flush_writes(dev, pending, &pending_len);
+                if (!dev) {
+                    ret = ESP_FAIL;
+                    break;
+                }
+                if (dev->read) {
+                    dev->read(dev->ctx, op->dst, len);
+                }
+                break;
+        }
+    }
+
+    if (ret == ESP_OK) {
+        flush_writes(dev, pending, &pending_len);
+    }
+    sim_wire_delay(bits, ports[i2c_num].clk_speed);
+    return ret;
+}
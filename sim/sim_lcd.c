@@ -0,0 +1,170 @@
+// Stand-in RGB LCD panel: framebuffers live in host memory and a scan
+// task raises the frame events at the rate the panel timings give.
+// draw_bitmap() with a framebuffer pointer switches scan-out to that
+// buffer at the next frame, like the real driver.
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_rgb.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define MAX_FBS 3
+
+struct esp_lcd_panel_t {
+    esp_lcd_rgb_panel_config_t config;
+    uint8_t* fbs[MAX_FBS];
+    size_t fb_size;
+    volatile int front;        // buffer being scanned out
+    volatile int next;         // buffer to show from the next frame on
+    esp_lcd_rgb_panel_event_callbacks_t callbacks;
+    void* user_ctx;
+    TaskHandle_t scan_task;
+    uint32_t frames;
+};
+
+static void scan_task(void* arg) {
+    esp_lcd_panel_handle_t panel = arg;
+    const esp_lcd_rgb_timing_t* t = &panel->config.timings;
+    uint64_t h_total = t->h_res + t->hsync_pulse_width + t->hsync_back_porch + t->hsync_front_porch;
+    uint64_t v_total = t->v_res + t->vsync_pulse_width + t->vsync_back_porch + t->vsync_front_porch;
+    TickType_t frame_ticks = pdMS_TO_TICKS(h_total * v_total * 1000 / t->pclk_hz);
+    if (frame_ticks == 0) {
+        frame_ticks = 1;
+    }
+    TickType_t last_wake_time = xTaskGetTickCount();
+    esp_lcd_rgb_panel_event_data_t edata;
+
+    while (1) {
+        vTaskDelayUntil(&last_wake_time, frame_ticks);
+
+        // Frame done: raise the event the real driver raises, then start
+        // the next frame from the newly selected buffer
+        if (panel->config.bounce_buffer_size_px && panel->callbacks.on_bounce_frame_finish) {
+            panel->callbacks.on_bounce_frame_finish(panel, &edata, panel->user_ctx);
+        }
+        if (panel->callbacks.on_vsync) {
+            panel->callbacks.on_vsync(panel, &edata, panel->user_ctx);
+        }
+        panel->front = panel->next;
+        panel->frames++;
+    }
+}
+
+esp_err_t esp_lcd_new_rgb_panel(const esp_lcd_rgb_panel_config_t* rgb_panel_config,
+                                esp_lcd_panel_handle_t* ret_panel) {
+    if (!rgb_panel_config || !ret_panel || rgb_panel_config->num_fbs > MAX_FBS ||
+        rgb_panel_config->timings.pclk_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_lcd_panel_handle_t panel = calloc(1, sizeof(*panel));
+    if (!panel) {
+        return ESP_ERR_NO_MEM;
+    }
+    panel->config = *rgb_panel_config;
+
+    size_t bpp = rgb_panel_config->bits_per_pixel ? rgb_panel_config->bits_per_pixel
+                                                  : rgb_panel_config->data_width;
+    size_t num_fbs = rgb_panel_config->num_fbs ? rgb_panel_config->num_fbs : 1;
+    panel->fb_size = rgb_panel_config->timings.h_res * rgb_panel_config->timings.v_res * bpp / 8;
+    for (size_t i = 0; i < num_fbs; i++) {
+        panel->fbs[i] = calloc(1, panel->fb_size);
+        if (!panel->fbs[i]) {
+            esp_lcd_panel_del(panel);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    *ret_panel = panel;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_rgb_panel_register_event_callbacks(esp_lcd_panel_handle_t panel,
+                                                     const esp_lcd_rgb_panel_event_callbacks_t* callbacks,
+                                                     void* user_ctx) {
+    if (!panel || !callbacks) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    panel->callbacks = *callbacks;
+    panel->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_rgb_panel_get_frame_buffer(esp_lcd_panel_handle_t panel, uint32_t fb_num, void** fb0, ...) {
+    if (!panel || fb_num == 0 || fb_num > MAX_FBS || !panel->fbs[fb_num - 1]) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    va_list args;
+    va_start(args, fb0);
+    *fb0 = panel->fbs[0];
+    for (uint32_t i = 1; i < fb_num; i++) {
+        void** fb = va_arg(args, void**);
+        *fb = panel->fbs[i];
+    }
+    va_end(args);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel) {
+    return panel ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel) {
+    if (!panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!panel->scan_task &&
+        xTaskCreate(scan_task, "sim_lcd", configMINIMAL_STACK_SIZE, panel,
+                    configMAX_PRIORITIES - 2, &panel->scan_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel) {
+    if (!panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (panel->scan_task) {
+        vTaskDelete(panel->scan_task);
+    }
+    for (int i = 0; i < MAX_FBS; i++) {
+        free(panel->fbs[i]);
+    }
+    free(panel);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start,
+                                    int x_end, int y_end, const void* color_data) {
+    if (!panel || !color_data || x_start >= x_end || y_start >= y_end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < MAX_FBS; i++) {
+        if (panel->fbs[i] && color_data == panel->fbs[i]) {
+            panel->next = i;
+            return ESP_OK;
+        }
+    }
+
+    // Not a framebuffer: copy the window into the one on screen
+    size_t bytes_pp = panel->fb_size / (panel->config.timings.h_res * panel->config.timings.v_res);
+    size_t row = (size_t)(x_end - x_start) * bytes_pp;
+    const uint8_t* src = color_data;
+    for (int y = y_start; y < y_end; y++) {
+        memcpy(panel->fbs[panel->front] + ((size_t)y * panel->config.timings.h_res + x_start) * bytes_pp,
+               src, row);
+        src += row;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off) {
+    (void)on_off;
+    return panel ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
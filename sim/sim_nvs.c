@@ -0,0 +1,117 @@
+// Stand-in NVS: a small key/value table in RAM, empty at every start,
+// so the firmware always boots on its default settings.
+
+#include <string.h>
+#include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+
+#define MAX_NAMESPACES 4
+#define MAX_ENTRIES    64
+
+typedef struct {
+    nvs_handle_t handle;
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint32_t value;
+} entry_t;
+
+static char namespaces[MAX_NAMESPACES][NVS_KEY_NAME_MAX_SIZE];
+static entry_t entries[MAX_ENTRIES];
+static size_t entry_count;
+static bool initialized;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t nvs_flash_init(void) {
+    initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    portENTER_CRITICAL(&lock);
+    memset(namespaces, 0, sizeof(namespaces));
+    entry_count = 0;
+    portEXIT_CRITICAL(&lock);
+    return ESP_OK;
+}
+
+// Handles are namespace index + 1
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    if (!initialized) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (!name || !out_handle || strlen(name) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < MAX_NAMESPACES; i++) {
+        if (namespaces[i][0] == '\0') {
+            strcpy(namespaces[i], name);
+        }
+        if (strcmp(namespaces[i], name) == 0) {
+            *out_handle = i + 1;
+            err = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+static entry_t* find(nvs_handle_t handle, const char* key) {
+    for (size_t i = 0; i < entry_count; i++) {
+        if (entries[i].handle == handle && strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value) {
+    if (handle == 0 || handle > MAX_NAMESPACES) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+
+    esp_err_t err = ESP_ERR_NVS_NOT_FOUND;
+    portENTER_CRITICAL(&lock);
+    entry_t* entry = find(handle, key);
+    if (entry) {
+        *out_value = entry->value;
+        err = ESP_OK;
+    }
+    portEXIT_CRITICAL(&lock);
+    return err;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+    if (handle == 0 || handle > MAX_NAMESPACES) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&lock);
+    entry_t* entry = find(handle, key);
+    if (!entry && entry_count < MAX_ENTRIES) {
+        entry = &entries[entry_count++];
+        entry->handle = handle;
+        strcpy(entry->key, key);
+    }
+    if (entry) {
+        entry->value = value;
+    } else {
+        err = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    portEXIT_CRITICAL(&lock);
+    return err;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return handle == 0 || handle > MAX_NAMESPACES ? ESP_ERR_NVS_INVALID_HANDLE : ESP_OK;
+}
@@ -0,0 +1,243 @@
+// SERVO42C drive models on the device side of a simulated UART. They
+// speak the same wire protocol as servo42c.c, each answering only frames
+// sent to its own address as on a multi-drop bus, move a virtual carriage
+// at the commanded speed and answer status requests.
+
+#include <math.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "servo42c.h"
+#include "sim.h"
+
+// Protocol constants (device side of servo42c.c)
+#define CMD_GET_STATUS 0x90
+#define CMD_SET_POSITION 0x91
+#define CMD_STOP 0x92
+#define CMD_HOME 0x93
+#define CMD_SET_SPEED 0x94
+#define CMD_EMERGENCY_STOP 0x95
+#define CMD_READ_ENCODER 0x30
+#define CMD_READ_PULSES 0x33
+
+#define STATUS_MOVING    (1 << 0)
+#define STATUS_HOMED     (1 << 1)
+
+#define MODEL_PERIOD_MS 1
+#define HOMING_SPEED_STEPS (5.0 * KIN_STEPS_PER_MM)
+#define START_POSITION_STEPS (12.5 * KIN_STEPS_PER_MM)
+#define IDLE_CURRENT_MA 180
+#define MOVING_CURRENT_MA 650
+#define DRIVE_TEMPERATURE_C 35
+#define STEPS_PER_REV (KIN_STEPS_PER_REV * KIN_MICROSTEPS)   // per motor revolution
+#define ENCODER_COUNTS_PER_REV KIN_ENCODER_COUNTS
+#define MAX_DRIVES 4
+
+typedef struct {
+    uint8_t address;
+    double position;     // steps
+    double target;       // steps
+    double speed;        // steps/s
+    bool homing;
+    bool homed;
+    uint32_t commands;
+    uint32_t status_requests;
+} drive_t;
+
+// All drives share one wire, so one parser sees every frame
+static struct {
+    int uart_num;
+    servo42c_parser_t parser;
+    drive_t drives[MAX_DRIVES];
+    size_t count;
+} bus;
+
+static size_t payload_len(uint8_t cmd) {
+    switch (cmd) {
+        case CMD_SET_POSITION: return 6;
+        case CMD_SET_SPEED:    return 2;
+        default:               return 0;
+    }
+}
+
+static void send_reply(const drive_t* drive, uint8_t seq, uint8_t cmd, const uint8_t* payload, size_t len) {
+    uint8_t frame[SERVO42C_MAX_FRAME];
+    size_t frame_len = servo42c_frame_encode(frame, sizeof(frame), drive->address, seq, cmd, payload, len);
+    sim_uart_device_write(bus.uart_num, frame, frame_len);
+}
+
+static void put_be32(uint8_t* p, int32_t value) {
+    p[0] = ((uint32_t)value >> 24) & 0xFF;
+    p[1] = ((uint32_t)value >> 16) & 0xFF;
+    p[2] = ((uint32_t)value >> 8) & 0xFF;
+    p[3] = (uint32_t)value & 0xFF;
+}
+
+static bool is_moving(const drive_t* drive) {
+    return drive->homing || fabs(drive->target - drive->position) > 0.5;
+}
+
+static void send_status(const drive_t* drive, uint8_t seq) {
+    bool moving = is_moving(drive);
+    uint16_t current = moving ? MOVING_CURRENT_MA : IDLE_CURRENT_MA;
+    uint8_t status = (moving ? STATUS_MOVING : 0) | (drive->homed ? STATUS_HOMED : 0);
+    uint8_t reply[4] = {
+        current >> 8,
+        current & 0xFF,
+        DRIVE_TEMPERATURE_C,
+        status,
+    };
+    send_reply(drive, seq, CMD_GET_STATUS, reply, sizeof(reply));
+}
+
+// The carriage follows the step pulses exactly, so the encoder reads the
+// model position quantized to encoder counts
+static void send_encoder(const drive_t* drive, uint8_t seq) {
+    double revs = drive->position / STEPS_PER_REV;
+    int32_t turns = (int32_t)floor(revs);
+    uint16_t fraction = (uint16_t)((revs - turns) * ENCODER_COUNTS_PER_REV);
+    uint8_t reply[6];
+    put_be32(reply, turns);
+    reply[4] = fraction >> 8;
+    reply[5] = fraction & 0xFF;
+    send_reply(drive, seq, CMD_READ_ENCODER, reply, sizeof(reply));
+}
+
+static void send_pulses(const drive_t* drive, uint8_t seq) {
+    uint8_t reply[4];
+    put_be32(reply, (int32_t)lround(drive->position));
+    send_reply(drive, seq, CMD_READ_PULSES, reply, sizeof(reply));
+}
+
+static drive_t* find_drive(uint8_t address) {
+    for (size_t i = 0; i < bus.count; i++) {
+        if (bus.drives[i].address == address) {
+            return &bus.drives[i];
+        }
+    }
+    return NULL;
+}
+
+static void execute(drive_t* drive, const servo42c_frame_t* frame) {
+    const uint8_t* data = frame->payload;
+
+    // A real drive rejects frames whose payload does not match the command
+    if (frame->len != payload_len(frame->cmd)) {
+        return;
+    }
+    drive->commands++;
+
+    switch (frame->cmd) {
+        case CMD_GET_STATUS:
+            drive->status_requests++;
+            send_status(drive, frame->seq);
+            break;
+        case CMD_SET_POSITION:
+            drive->target = (double)(int32_t)(((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                                              ((uint32_t)data[2] << 8) | data[3]);
+            drive->speed = (double)((data[4] << 8) | data[5]);
+            break;
+        case CMD_SET_SPEED:
+            drive->speed = (double)((data[0] << 8) | data[1]);
+            break;
+        case CMD_READ_ENCODER:
+            send_encoder(drive, frame->seq);
+            break;
+        case CMD_READ_PULSES:
+            send_pulses(drive, frame->seq);
+            break;
+        case CMD_HOME:
+            drive->homing = true;
+            drive->homed = false;
+            drive->target = 0.0;
+            drive->speed = HOMING_SPEED_STEPS;
+            break;
+        case CMD_STOP:
+        case CMD_EMERGENCY_STOP:
+            drive->homing = false;
+            drive->target = drive->position;
+            break;
+        default:
+            break;
+    }
+}
+
+static void integrate(drive_t* drive, double dt) {
+    double step = drive->speed * dt;
+    double delta = drive->target - drive->position;
+
+    if (fabs(delta) <= step) {
+        drive->position = drive->target;
+        if (drive->homing) {
+            drive->homing = false;
+            drive->homed = true;
+        }
+    } else {
+        drive->position += delta > 0 ? step : -step;
+    }
+}
+
+static void servo_model_task(void* arg) {
+    TickType_t last_wake_time = xTaskGetTickCount();
+    uint8_t buf[64];
+
+    while (1) {
+        size_t n;
+        while ((n = sim_uart_device_read(bus.uart_num, buf, sizeof(buf), 0)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                if (!servo42c_parser_feed(&bus.parser, buf[i])) {
+                    continue;
+                }
+                do {
+                    // Frames for other addresses are not this drive's business
+                    drive_t* drive = find_drive(bus.parser.frame.addr);
+                    if (drive) {
+                        execute(drive, &bus.parser.frame);
+                    }
+                } while (servo42c_parser_poll(&bus.parser));
+            }
+        }
+
+        for (size_t i = 0; i < bus.count; i++) {
+            integrate(&bus.drives[i], MODEL_PERIOD_MS / 1000.0);
+        }
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(MODEL_PERIOD_MS));
+    }
+}
+
+void sim_servo_start(int uart_num, uint8_t address) {
+    if (bus.count == MAX_DRIVES || (bus.count > 0 && uart_num != bus.uart_num)) {
+        return;
+    }
+
+    drive_t* drive = &bus.drives[bus.count];
+    memset(drive, 0, sizeof(*drive));
+    drive->address = address;
+    drive->position = START_POSITION_STEPS;
+    drive->target = START_POSITION_STEPS;
+
+    if (bus.count++ == 0) {
+        bus.uart_num = uart_num;
+        servo42c_parser_init(&bus.parser, NULL);
+        xTaskCreate(servo_model_task, "sim_servo", configMINIMAL_STACK_SIZE, NULL,
+                    configMAX_PRIORITIES - 3, NULL);
+    }
+}
+
+bool sim_servo_get_state(uint8_t address, sim_servo_state_t* state) {
+    bool found = false;
+
+    vTaskSuspendAll();
+    const drive_t* drive = find_drive(address);
+    if (drive) {
+        state->position_mm = (float)(drive->position / KIN_STEPS_PER_MM);
+        state->target_mm = (float)(drive->target / KIN_STEPS_PER_MM);
+        state->homed = drive->homed;
+        state->moving = is_moving(drive);
+        state->commands = drive->commands;
+        state->status_requests = drive->status_requests;
+        found = true;
+    }
+    xTaskResumeAll();
+    return found;
+}
@@ -0,0 +1,139 @@
+// Stand-in SPI master: polled transfers spin for their wire time, queued
+// transfers complete asynchronously on a per-device "DMA" task that
+// sleeps for the wire time and then runs the post-transfer callback.
+
+#include <stdlib.h>
+#include "driver/spi_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "sim.h"
+
+#define SIM_SPI_MAX_HOSTS 3
+#define SIM_SPI_DEFAULT_QUEUE 4
+
+struct spi_device_t {
+    spi_device_interface_config_t cfg;
+    QueueHandle_t pending;
+    QueueHandle_t done;
+    TaskHandle_t dma_task;
+    uint64_t debt_ns;
+};
+
+static struct {
+    bool initialized;
+    int max_transfer_sz;
+} hosts[SIM_SPI_MAX_HOSTS];
+
+static void run_callbacks_and_wait(spi_device_handle_t dev, spi_transaction_t* t, bool polling) {
+    if (dev->cfg.pre_cb) {
+        dev->cfg.pre_cb(t);
+    }
+
+    if (polling) {
+        sim_wire_delay(t->length, (uint32_t)dev->cfg.clock_speed_hz);
+    } else {
+        // Sleep whole ticks only, carrying the remainder to the next transfer
+        dev->debt_ns += (uint64_t)t->length * 1000000000ULL / (uint64_t)dev->cfg.clock_speed_hz;
+        TickType_t ticks = (TickType_t)(dev->debt_ns / (1000000ULL * portTICK_PERIOD_MS));
+        if (ticks > 0) {
+            dev->debt_ns -= (uint64_t)ticks * 1000000ULL * portTICK_PERIOD_MS;
+            vTaskDelay(ticks);
+        }
+    }
+
+    if (dev->cfg.post_cb) {
+        dev->cfg.post_cb(t);
+    }
+}
+
+static void dma_task(void* arg) {
+    spi_device_handle_t dev = arg;
+    spi_transaction_t* t;
+
+    while (1) {
+        if (xQueueReceive(dev->pending, &t, portMAX_DELAY) == pdTRUE) {
+            run_callbacks_and_wait(dev, t, false);
+            xQueueSend(dev->done, &t, portMAX_DELAY);
+        }
+    }
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t* bus_config, int dma_chan) {
+    (void)dma_chan;
+    if (host_id < 0 || host_id >= SIM_SPI_MAX_HOSTS || !bus_config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (hosts[host_id].initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    hosts[host_id].initialized = true;
+    hosts[host_id].max_transfer_sz = bus_config->max_transfer_sz > 0 ? bus_config->max_transfer_sz : 4092;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config,
+                             spi_device_handle_t* handle) {
+    if (host_id < 0 || host_id >= SIM_SPI_MAX_HOSTS || !dev_config || !handle ||
+        dev_config->clock_speed_hz <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!hosts[host_id].initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spi_device_handle_t dev = calloc(1, sizeof(*dev));
+    if (!dev) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int depth = dev_config->queue_size > 0 ? dev_config->queue_size : SIM_SPI_DEFAULT_QUEUE;
+    dev->cfg = *dev_config;
+    dev->pending = xQueueCreate(depth, sizeof(spi_transaction_t*));
+    dev->done = xQueueCreate(depth, sizeof(spi_transaction_t*));
+    if (!dev->pending || !dev->done ||
+        xTaskCreate(dma_task, "sim_spi_dma", configMINIMAL_STACK_SIZE, dev,
+                    configMAX_PRIORITIES - 2, &dev->dma_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    *handle = dev;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc) {
+    if (!handle || !trans_desc) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    run_callbacks_and_wait(handle, trans_desc, true);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t ticks_to_wait) {
+    if (!handle || !trans_desc) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (xQueueSend(handle->pending, &trans_desc, ticks_to_wait) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc, TickType_t ticks_to_wait) {
+    if (!handle || !trans_desc) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (xQueueReceive(handle->done, trans_desc, ticks_to_wait) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc) {
+    spi_transaction_t* done;
+    esp_err_t ret = spi_device_queue_trans(handle, trans_desc, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return spi_device_get_trans_result(handle, &done, portMAX_DELAY);
+}
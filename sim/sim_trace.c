@@ -0,0 +1,159 @@
+// Loop period / jitter / CPU accounting for the benchmark runner.
+// The hooks run with the scheduler suspended (inside vTaskDelay and
+// vTaskDelayUntil), so the table needs no further locking on the task side.
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sim_trace.h"
+
+typedef struct {
+    TaskHandle_t task;
+    char name[16];
+    bool primed;          // first sample of the window taken
+    uint64_t last_ns;
+    uint64_t cpu_start_ns;
+    uint64_t cpu_last_ns;
+    uint32_t loops;
+    uint32_t overruns;
+    double sum_us;
+    double sum_sq_us;
+    double min_us;
+    double max_us;
+    double max_dev_us;
+} trace_entry_t;
+
+typedef struct {
+    char name[16];
+    uint32_t period_us;
+} trace_expect_t;
+
+static trace_entry_t entries[SIM_TRACE_MAX_TASKS];
+static size_t entry_count;
+static trace_expect_t expects[SIM_TRACE_MAX_TASKS];
+static size_t expect_count;
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t nominal_for(const char* name) {
+    for (size_t i = 0; i < expect_count; i++) {
+        if (strncmp(expects[i].name, name, sizeof(expects[i].name)) == 0) {
+            return expects[i].period_us;
+        }
+    }
+    return 0;
+}
+
+void sim_trace_expect(const char* task_name, uint32_t period_us) {
+    vTaskSuspendAll();
+    if (expect_count < SIM_TRACE_MAX_TASKS) {
+        strncpy(expects[expect_count].name, task_name, sizeof(expects[expect_count].name) - 1);
+        expects[expect_count].period_us = period_us;
+        expect_count++;
+    }
+    xTaskResumeAll();
+}
+
+void sim_trace_reset(void) {
+    vTaskSuspendAll();
+    for (size_t i = 0; i < entry_count; i++) {
+        TaskHandle_t task = entries[i].task;
+        char name[16];
+        memcpy(name, entries[i].name, sizeof(name));
+        memset(&entries[i], 0, sizeof(entries[i]));
+        entries[i].task = task;
+        memcpy(entries[i].name, name, sizeof(name));
+    }
+    xTaskResumeAll();
+}
+
+void sim_trace_task_delay(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    trace_entry_t* e = NULL;
+
+    for (size_t i = 0; i < entry_count; i++) {
+        if (entries[i].task == self) {
+            e = &entries[i];
+            break;
+        }
+    }
+    if (!e) {
+        if (entry_count >= SIM_TRACE_MAX_TASKS) {
+            return;
+        }
+        e = &entries[entry_count++];
+        e->task = self;
+        strncpy(e->name, pcTaskGetName(self), sizeof(e->name) - 1);
+    }
+
+    uint64_t now = clock_ns(CLOCK_MONOTONIC);
+    uint64_t cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    if (!e->primed) {
+        e->primed = true;
+        e->last_ns = now;
+        e->cpu_start_ns = cpu;
+        e->cpu_last_ns = cpu;
+        return;
+    }
+
+    double period_us = (double)(now - e->last_ns) / 1000.0;
+    e->last_ns = now;
+    e->cpu_last_ns = cpu;
+
+    if (e->loops == 0 || period_us < e->min_us) {
+        e->min_us = period_us;
+    }
+    if (period_us > e->max_us) {
+        e->max_us = period_us;
+    }
+    e->sum_us += period_us;
+    e->sum_sq_us += period_us * period_us;
+    e->loops++;
+
+    uint32_t nominal = nominal_for(e->name);
+    if (nominal > 0) {
+        double dev = fabs(period_us - (double)nominal);
+        if (dev > e->max_dev_us) {
+            e->max_dev_us = dev;
+        }
+        if (period_us > 1.5 * (double)nominal) {
+            e->overruns++;
+        }
+    }
+}
+
+size_t sim_trace_get_stats(sim_trace_stats_t* out, size_t max) {
+    size_t n = 0;
+
+    vTaskSuspendAll();
+    for (size_t i = 0; i < entry_count && n < max; i++) {
+        const trace_entry_t* e = &entries[i];
+        sim_trace_stats_t* s = &out[n++];
+
+        memset(s, 0, sizeof(*s));
+        memcpy(s->name, e->name, sizeof(s->name));
+        s->loops = e->loops;
+        s->overruns = e->overruns;
+        s->nominal_us = nominal_for(e->name);
+        s->cpu_us = (double)(e->cpu_last_ns - e->cpu_start_ns) / 1000.0;
+        if (e->loops > 0) {
+            double mean = e->sum_us / e->loops;
+            double var = e->sum_sq_us / e->loops - mean * mean;
+            s->period_min_us = e->min_us;
+            s->period_max_us = e->max_us;
+            s->period_mean_us = mean;
+            s->period_stddev_us = var > 0.0 ? sqrt(var) : 0.0;
+            s->max_deviation_us = e->max_dev_us;
+        }
+    }
+    xTaskResumeAll();
+
+    return n;
+}
@@ -0,0 +1,32 @@
+#pragma once
+// Per-task loop timing collected from the FreeRTOS delay trace hooks
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_TRACE_MAX_TASKS 24
+
+typedef struct {
+    char name[16];
+    uint32_t loops;           // completed loop iterations since reset
+    uint32_t overruns;        // iterations longer than 1.5x the nominal period
+    uint32_t nominal_us;      // 0 if no nominal period was registered
+    double period_min_us;
+    double period_max_us;
+    double period_mean_us;
+    double period_stddev_us;  // jitter
+    double max_deviation_us;  // worst |period - nominal|
+    double cpu_us;            // thread CPU time consumed since reset
+} sim_trace_stats_t;
+
+// Register the expected loop period of a task by name
+void sim_trace_expect(const char* task_name, uint32_t period_us);
+
+// Drop all samples; the next delay of every task starts a fresh window
+void sim_trace_reset(void);
+
+// Copy the statistics of every task seen so far, returns the count
+size_t sim_trace_get_stats(sim_trace_stats_t* out, size_t max);
+
+// Called from traceTASK_DELAY / traceTASK_DELAY_UNTIL
+void sim_trace_task_delay(void);
@@ -0,0 +1,204 @@
+// Stand-in UART driver: each port is a pair of stream buffers between
+// the firmware (host side) and a simulated device (device side).
+//
+// With an event queue installed, every device write is reported as one
+// UART_DATA event, as if the burst ended in an RX timeout. Writes that
+// do not fit the RX buffer are reported as UART_BUFFER_FULL.
+
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "sim.h"
+
+static struct {
+    bool installed;
+    int baud_rate;
+    StreamBufferHandle_t to_device;
+    StreamBufferHandle_t to_host;
+    SemaphoreHandle_t write_lock;
+    QueueHandle_t event_queue;
+    int rx_full_threshold;
+    uint8_t rx_timeout;
+} ports[UART_NUM_MAX];
+
+static bool valid_port(uart_port_t uart_num) {
+    return uart_num >= 0 && uart_num < UART_NUM_MAX;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t* uart_config) {
+    if (!valid_port(uart_num) || !uart_config || uart_config->baud_rate <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ports[uart_num].baud_rate = uart_config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num) {
+    (void)tx_io_num;
+    (void)rx_io_num;
+    (void)rts_io_num;
+    (void)cts_io_num;
+    return valid_port(uart_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t* uart_queue, int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+
+    if (!valid_port(uart_num) || rx_buffer_size <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ports[uart_num].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t tx_size = tx_buffer_size > 0 ? (size_t)tx_buffer_size : (size_t)rx_buffer_size;
+    ports[uart_num].to_device = xStreamBufferCreate(tx_size, 1);
+    ports[uart_num].to_host = xStreamBufferCreate((size_t)rx_buffer_size, 1);
+    ports[uart_num].write_lock = xSemaphoreCreateMutex();
+    if (!ports[uart_num].to_device || !ports[uart_num].to_host || !ports[uart_num].write_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ports[uart_num].event_queue = NULL;
+    if (queue_size > 0 && uart_queue) {
+        ports[uart_num].event_queue = xQueueCreate(queue_size, sizeof(uart_event_t));
+        if (!ports[uart_num].event_queue) {
+            return ESP_ERR_NO_MEM;
+        }
+        *uart_queue = ports[uart_num].event_queue;
+    }
+
+    ports[uart_num].installed = true;
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    vStreamBufferDelete(ports[uart_num].to_device);
+    vStreamBufferDelete(ports[uart_num].to_host);
+    vSemaphoreDelete(ports[uart_num].write_lock);
+    if (ports[uart_num].event_queue) {
+        vQueueDelete(ports[uart_num].event_queue);
+        ports[uart_num].event_queue = NULL;
+    }
+    ports[uart_num].installed = false;
+    return ESP_OK;
+}
+
+// The simulated wire has no driver to switch; both directions always work
+esp_err_t uart_set_mode(uart_port_t uart_num, uart_mode_t mode) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_set_rx_full_threshold(uart_port_t uart_num, int threshold) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed || threshold <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ports[uart_num].rx_full_threshold = threshold;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, const uint8_t tout_thresh) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ports[uart_num].rx_timeout = tout_thresh;
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void* src, size_t size) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed || !src) {
+        return -1;
+    }
+
+    xSemaphoreTake(ports[uart_num].write_lock, portMAX_DELAY);
+    size_t sent = xStreamBufferSend(ports[uart_num].to_device, src, size, portMAX_DELAY);
+    xSemaphoreGive(ports[uart_num].write_lock);
+    return (int)sent;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void* buf, uint32_t length, TickType_t ticks_to_wait) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed || !buf) {
+        return -1;
+    }
+
+    // Like the real driver: keep waiting until `length` bytes arrived or
+    // the whole timeout elapsed, whichever comes first.
+    uint8_t* dst = buf;
+    size_t received = 0;
+    TickType_t start = xTaskGetTickCount();
+    while (received < length) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= ticks_to_wait) {
+            received += xStreamBufferReceive(ports[uart_num].to_host, dst + received,
+                                             length - received, 0);
+            break;
+        }
+        received += xStreamBufferReceive(ports[uart_num].to_host, dst + received,
+                                         length - received, ticks_to_wait - elapsed);
+    }
+    return (int)received;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t* size) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed || !size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *size = xStreamBufferBytesAvailable(ports[uart_num].to_host);
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xStreamBufferReset(ports[uart_num].to_host);
+    return ESP_OK;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    TickType_t start = xTaskGetTickCount();
+    while (xStreamBufferBytesAvailable(ports[uart_num].to_device) > 0) {
+        if (xTaskGetTickCount() - start >= ticks_to_wait) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+size_t sim_uart_device_read(int uart_num, uint8_t* buf, size_t len, TickType_t ticks_to_wait) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed) {
+        vTaskDelay(ticks_to_wait);
+        return 0;
+    }
+    return xStreamBufferReceive(ports[uart_num].to_device, buf, len, ticks_to_wait);
+}
+
+size_t sim_uart_device_write(int uart_num, const uint8_t* buf, size_t len) {
+    if (!valid_port(uart_num) || !ports[uart_num].installed) {
+        return 0;
+    }
+    size_t sent = xStreamBufferSend(ports[uart_num].to_host, buf, len, 0);
+
+    if (ports[uart_num].event_queue && len > 0) {
+        uart_event_t event = {
+            .type = sent < len ? UART_BUFFER_FULL : UART_DATA,
+            .size = sent,
+            .timeout_flag = true,
+        };
+        xQueueSend(ports[uart_num].event_queue, &event, 0);
+    }
+    return sent;
+}
@@ -0,0 +1,155 @@
+// Host decoder for telemetry exports (see telemetry.h): reads either the
+// raw stream saved to flash or a console capture containing the "TLM "
+// hex lines, and prints the samples as CSV.
+//
+//   telemetry_decode capture.txt > trip.csv
+//   telemetry_decode -        (read standard input)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry.h"
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+} buffer_t;
+
+static void append(buffer_t* b, const uint8_t* data, size_t len) {
+    if (b->len + len > b->cap) {
+        b->cap = (b->len + len) * 2;
+        b->data = realloc(b->data, b->cap);
+        if (!b->data) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Console capture: collect the payload of every "TLM " line, ignoring
+// log output interleaved with them
+static void unhex_capture(const buffer_t* text, buffer_t* out) {
+    size_t prefix = strlen(TELEMETRY_HEX_PREFIX);
+    size_t end_len = strlen(TELEMETRY_HEX_END);
+    const char* p = (const char*)text->data;
+    const char* end = p + text->len;
+
+    while (p < end) {
+        const char* eol = memchr(p, '\n', end - p);
+        if (!eol) {
+            eol = end;
+        }
+
+        // Lines may carry a log prefix before the marker
+        for (const char* q = p; q + prefix <= eol; q++) {
+            if (memcmp(q, TELEMETRY_HEX_PREFIX, prefix) != 0) {
+                continue;
+            }
+            if ((size_t)(eol - q) >= end_len && memcmp(q, TELEMETRY_HEX_END, end_len) == 0) {
+                break;
+            }
+            for (q += prefix; q + 1 < eol && hex_value(q[0]) >= 0 && hex_value(q[1]) >= 0; q += 2) {
+                uint8_t byte = (uint8_t)(hex_value(q[0]) << 4 | hex_value(q[1]));
+                append(out, &byte, 1);
+            }
+            break;
+        }
+        p = eol + 1;
+    }
+}
+
+static int decode(const uint8_t* buf, size_t buf_len) {
+    if (buf_len < 4 || memcmp(buf, TELEMETRY_MAGIC, 4) != 0) {
+        fprintf(stderr, "not a telemetry stream\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t pos = 4;
+    uint32_t time_us;
+    size_t n = telemetry_get_varint(buf + pos, buf_len - pos, &time_us);
+    if (n == 0) {
+        fprintf(stderr, "truncated header\n");
+        return EXIT_FAILURE;
+    }
+    pos += n;
+
+    uint32_t t0 = time_us;
+    int32_t position_um = 0;
+    int32_t current_ma = 0;
+    int32_t temperature = 0;
+    int32_t status = 0;
+    size_t samples = 0;
+
+    printf("time_ms,position_mm,current_ma,temperature_c,status\n");
+    while (pos < buf_len) {
+        uint32_t fields[5];
+        for (int i = 0; i < 5; i++) {
+            n = telemetry_get_varint(buf + pos, buf_len - pos, &fields[i]);
+            if (n == 0) {
+                fprintf(stderr, "truncated sample %zu\n", samples);
+                return EXIT_FAILURE;
+            }
+            pos += n;
+        }
+
+        time_us += fields[0];
+        position_um += telemetry_unzigzag(fields[1]);
+        current_ma += telemetry_unzigzag(fields[2]);
+        temperature += telemetry_unzigzag(fields[3]);
+        status += telemetry_unzigzag(fields[4]);
+        samples++;
+
+        printf("%.3f,%.3f,%d,%d,0x%02x\n", (uint32_t)(time_us - t0) / 1000.0,
+               position_um / 1000.0, current_ma, temperature, (unsigned)status);
+    }
+
+    fprintf(stderr, "%zu samples, %zu bytes (%.1f bytes/sample)\n", samples, buf_len,
+            samples ? (double)buf_len / samples : 0.0);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <export file | console capture | ->\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    buffer_t input = {0};
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        append(&input, chunk, n);
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+    // A raw export starts with the magic; anything else is a console log
+    int ret;
+    if (input.len >= 4 && memcmp(input.data, TELEMETRY_MAGIC, 4) == 0) {
+        ret = decode(input.data, input.len);
+    } else {
+        buffer_t stream = {0};
+        unhex_capture(&input, &stream);
+        ret = decode(stream.data, stream.len);
+        free(stream.data);
+    }
+    free(input.data);
+    return ret;
+}
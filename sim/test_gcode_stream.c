@@ -0,0 +1,174 @@
+// Host test for the serial G-code source: boots the firmware, homes the
+// simulated axis and streams a program several times longer than the
+// block buffer over the console UART, one line per "ok" the way a host
+// sender does. Every line must be answered, the buffer must fill and
+// hold the sender back, no canned cycle may start while the program
+// holds the planner, and the drive must end up where the program left it.
+// A '!' line must then abort a second program and close it.
+//
+//   ctest --test-dir build-sim
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cycles.h"
+#include "gcode.h"
+#include "servo42c.h"
+#include "sim.h"
+
+#define HOMING_WAIT_MS   10000
+#define REPLY_WAIT_MS    5000    // a full buffer holds a reply back for one move
+#define FINISH_WAIT_MS   10000
+#define PECK_PAIRS       40      // G1 + G0 lines, well past GCODE_BLOCK_BUFFER
+#define FINAL_Z_MM       1.0f
+
+void app_main(void);
+
+static int failures;
+
+#define CHECK(cond) do {                                            \
+    if (!(cond)) {                                                  \
+        fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);  \
+        failures++;                                                 \
+    }                                                               \
+} while (0)
+
+static uint32_t elapsed_ms(TickType_t since) {
+    return (uint32_t)((xTaskGetTickCount() - since) * portTICK_PERIOD_MS);
+}
+
+// Next line the firmware sent, without its newline; false on timeout
+static bool read_reply(char* reply, size_t size) {
+    size_t len = 0;
+    TickType_t start = xTaskGetTickCount();
+
+    while (elapsed_ms(start) < REPLY_WAIT_MS) {
+        uint8_t c;
+        if (sim_uart_device_read(GCODE_UART_NUM, &c, 1, pdMS_TO_TICKS(10)) == 0) {
+            continue;
+        }
+        if (c == '\n') {
+            reply[len] = '\0';
+            return true;
+        }
+        if (len < size - 1) {
+            reply[len++] = (char)c;
+        }
+    }
+    return false;
+}
+
+// Sends one line and waits for its answer; false unless it is "ok"
+static bool send_line(const char* line) {
+    char reply[64];
+
+    sim_uart_device_write(GCODE_UART_NUM, (const uint8_t*)line, strlen(line));
+    sim_uart_device_write(GCODE_UART_NUM, (const uint8_t*)"\n", 1);
+    if (!read_reply(reply, sizeof(reply))) {
+        fprintf(stderr, "test: no reply to \"%s\"\n", line);
+        return false;
+    }
+    if (strcmp(reply, "ok") != 0) {
+        fprintf(stderr, "test: \"%s\" answered \"%s\"\n", line, reply);
+        return false;
+    }
+    return true;
+}
+
+static void test_task(void* arg) {
+    app_main();
+
+    servo42c_handle_t axis = servo42c_find_axis("Z");
+    servo42c_state_t state;
+    servo42c_home(axis);
+    TickType_t start = xTaskGetTickCount();
+    do {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        servo42c_get_state(axis, &state);
+    } while ((!state.is_homed || state.is_moving) && elapsed_ms(start) < HOMING_WAIT_MS);
+    if (!state.is_homed) {
+        fprintf(stderr, "test: axis did not home within %d ms\n", HOMING_WAIT_MS);
+        exit(EXIT_FAILURE);
+    }
+
+    // Lines outside a program are refused
+    CHECK(!send_line("G0 Z1"));
+
+    CHECK(send_line("%"));
+    CHECK(send_line("G21 G90 (modes only)"));
+    CHECK(send_line("G0 Z1"));
+
+    size_t peak_buffered = 0;
+    size_t acked = 0;
+    bool cycle_refused = true;
+    const cycle_params_t cycle = {
+        .type = CYCLE_DRILL,
+        .r_plane = 1.0f,
+        .depth = 2.0f,
+        .feed = 1.0f,
+    };
+    for (int i = 0; i < PECK_PAIRS; i++) {
+        acked += send_line("G1 Z1.5 F600");
+        acked += send_line("G0 Z1");
+
+        gcode_status_t status;
+        gcode_get_status(&status);
+        if (status.blocks_buffered > peak_buffered) {
+            peak_buffered = status.blocks_buffered;
+        }
+        if (cycle_start(&cycle) != ESP_ERR_INVALID_STATE) {
+            cycle_refused = false;
+        }
+    }
+    // No M30: closing the program ends it
+    CHECK(send_line("%"));
+
+    CHECK(acked == 2 * PECK_PAIRS);
+    // An "ok" comes back as soon as its block is queued, so only a full
+    // buffer keeps a reply back: the executor has taken at most one more
+    CHECK(peak_buffered >= GCODE_BLOCK_BUFFER - 1);
+    CHECK(cycle_refused);
+
+    gcode_status_t status;
+    start = xTaskGetTickCount();
+    do {
+        vTaskDelay(pdMS_TO_TICKS(20));
+        gcode_get_status(&status);
+    } while (status.state == GCODE_RUNNING && elapsed_ms(start) < FINISH_WAIT_MS);
+    CHECK(status.state == GCODE_DONE);
+    CHECK(planner_get_owner() == PLANNER_OWNER_NONE);
+
+    sim_servo_state_t drive;
+    sim_servo_get_state(SERVO42C_ADDRESS_DEFAULT, &drive);
+    CHECK(fabsf(drive.position_mm - FINAL_Z_MM) < 0.05f);
+
+    // '!' aborts mid-move and closes the program
+    CHECK(send_line("%"));
+    CHECK(send_line("G1 Z3 F60"));
+    CHECK(send_line("!"));
+    gcode_get_status(&status);
+    CHECK(status.state == GCODE_ABORTED);
+    CHECK(planner_get_owner() == PLANNER_OWNER_NONE);
+    CHECK(!send_line("G0 Z1"));
+
+    // The planner is free for cycles again
+    CHECK(cycle_start(&cycle) == ESP_OK);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        exit(EXIT_FAILURE);
+    }
+    printf("gcode_stream: %u lines streamed, up to %u blocks buffered\n",
+           (unsigned)acked, (unsigned)peak_buffered);
+    exit(EXIT_SUCCESS);
+}
+
+int main(void) {
+    sim_init();
+    xTaskCreate(test_task, "test", configMINIMAL_STACK_SIZE * 4, NULL, 2, NULL);
+    vTaskStartScheduler();
+    return EXIT_FAILURE;
+}
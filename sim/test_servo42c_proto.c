@@ -0,0 +1,145 @@
+// Host tests for the Servo42C frame parser: byte streams with corrupted
+// frames in them must yield exactly the valid frames they carry, in
+// order and unchanged.
+//
+//   ctest --test-dir build-sim
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "servo42c_proto.h"
+
+#define MAX_FRAMES 8
+
+static int failures;
+
+#define CHECK(cond) do {                                            \
+    if (!(cond)) {                                                  \
+        fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);  \
+        failures++;                                                 \
+    }                                                               \
+} while (0)
+
+typedef struct {
+    servo42c_frame_t frames[MAX_FRAMES];
+    size_t count;
+} received_t;
+
+// Feed the way the receive task does: after each frame, poll for any
+// the same byte left behind
+static void feed_all(servo42c_parser_t* parser, const uint8_t* data, size_t len, received_t* out) {
+    for (size_t i = 0; i < len; i++) {
+        if (!servo42c_parser_feed(parser, data[i])) {
+            continue;
+        }
+        do {
+            if (out->count < MAX_FRAMES) {
+                out->frames[out->count] = parser->frame;
+            }
+            out->count++;
+        } while (servo42c_parser_poll(parser));
+    }
+}
+
+static size_t append_frame(uint8_t* buf, size_t at, uint8_t addr, uint8_t seq, uint8_t cmd,
+                           const uint8_t* payload, size_t len) {
+    return at + servo42c_frame_encode(&buf[at], SERVO42C_MAX_FRAME, addr, seq, cmd, payload, len);
+}
+
+static bool same_frame(const servo42c_frame_t* frame, uint8_t addr, uint8_t seq, uint8_t cmd,
+                       const uint8_t* payload, size_t len) {
+    return frame->addr == addr && frame->seq == seq && frame->cmd == cmd && frame->len == len &&
+           memcmp(frame->payload, payload, len) == 0;
+}
+
+// A header whose length byte got corrupted to the maximum swallows the
+// next frame whole and the one after it in part. Both must come out
+// intact once the bad frame's checksum fails.
+static void test_long_header_swallows_two_frames(void) {
+    static const uint8_t payload_a[] = { 1, 2, 3, 4 };
+    static const uint8_t payload_b[] = { 5, 6, 7, 8 };
+    uint8_t stream[64] = {
+        SERVO42C_FRAME_HEADER_1, SERVO42C_FRAME_HEADER_2, 0xE0, SERVO42C_MAX_PAYLOAD, 0x10, 0x90,
+    };
+    size_t len = 6;
+    len = append_frame(stream, len, 0xE0, 0x11, 0x90, payload_a, sizeof(payload_a));
+    len = append_frame(stream, len, 0xE1, 0x12, 0x91, payload_b, sizeof(payload_b));
+
+    // The bad frame's checksum byte lands inside frame B and must not match
+    size_t crc_at = 6 + SERVO42C_MAX_PAYLOAD;
+    CHECK(crc_at < len);
+    CHECK(servo42c_crc8(&stream[2], crc_at - 2) != stream[crc_at]);
+
+    servo42c_link_stats_t stats = { 0 };
+    servo42c_parser_t parser;
+    received_t got = { 0 };
+    servo42c_parser_init(&parser, &stats);
+    feed_all(&parser, stream, len, &got);
+
+    CHECK(got.count == 2);
+    CHECK(same_frame(&got.frames[0], 0xE0, 0x11, 0x90, payload_a, sizeof(payload_a)));
+    CHECK(same_frame(&got.frames[1], 0xE1, 0x12, 0x91, payload_b, sizeof(payload_b)));
+    CHECK(stats.crc_errors == 1);
+    CHECK(stats.frames == 2);
+}
+
+// Several complete frames inside one bad frame come out one per call
+static void test_several_frames_in_one_rescan(void) {
+    uint8_t stream[64] = {
+        SERVO42C_FRAME_HEADER_1, SERVO42C_FRAME_HEADER_2, 0xE0, SERVO42C_MAX_PAYLOAD, 0x20, 0x90,
+    };
+    size_t len = 6;
+    for (uint8_t seq = 0; seq < 3; seq++) {
+        len = append_frame(stream, len, 0xE0, 0x21 + seq, 0x90, NULL, 0);
+    }
+    // Filler up to and including the bad checksum
+    while (len <= 6 + SERVO42C_MAX_PAYLOAD) {
+        stream[len++] = 0x00;
+    }
+    CHECK(servo42c_crc8(&stream[2], 4 + SERVO42C_MAX_PAYLOAD) != 0x00);
+
+    servo42c_parser_t parser;
+    received_t got = { 0 };
+    servo42c_parser_init(&parser, NULL);
+    feed_all(&parser, stream, len, &got);
+
+    CHECK(got.count == 3);
+    for (uint8_t seq = 0; seq < 3 && seq < got.count; seq++) {
+        CHECK(same_frame(&got.frames[seq], 0xE0, 0x21 + seq, 0x90, NULL, 0));
+    }
+    CHECK(parser.pending_len == 0);
+}
+
+// The parser keeps working normally after a re-scan
+static void test_clean_frames_after_rescan(void) {
+    static const uint8_t payload[] = { 0x01, 0x2C, 35, 0x03 };
+    uint8_t stream[64] = { SERVO42C_FRAME_HEADER_1, 0x00 };
+    size_t len = 2;
+    len = append_frame(stream, len, 0xE0, 0x30, 0x90, payload, sizeof(payload));
+    len = append_frame(stream, len, 0xE0, 0x31, 0x90, payload, sizeof(payload));
+
+    servo42c_parser_t parser;
+    received_t got = { 0 };
+    servo42c_parser_init(&parser, NULL);
+    feed_all(&parser, stream, len, &got);
+
+    CHECK(got.count == 2);
+    CHECK(same_frame(&got.frames[0], 0xE0, 0x30, 0x90, payload, sizeof(payload)));
+    CHECK(same_frame(&got.frames[1], 0xE0, 0x31, 0x90, payload, sizeof(payload)));
+    CHECK(servo42c_parser_bytes_needed(&parser) == SERVO42C_FRAME_OVERHEAD);
+}
+
+int main(void) {
+    test_long_header_swallows_two_frames();
+    test_several_frames_in_one_rescan();
+    test_clean_frames_after_rescan();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("servo42c_proto: all tests passed\n");
+    return EXIT_SUCCESS;
+}
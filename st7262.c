@@ -1,12 +1,200 @@
-// Update ST7262 initialization sequence
+#include "st7262.h"
+#include <stdint.h>
+#include <string.h>
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "latency.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#if ST7262_RGB_MODE
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_rgb.h"
+#else
+#include "driver/spi_master.h"
+#endif
+
+static const char* TAG = "st7262";
+
+#if ST7262_RGB_MODE
+
+// The panel scans out continuously from one of two PSRAM framebuffers,
+// streamed through small internal-RAM bounce buffers. LVGL draws
+// straight into the other framebuffer (direct mode); at the end of a
+// refresh the two are swapped on a frame boundary, so no frame ever
+// shows a half-drawn buffer.
+
+static esp_lcd_panel_handle_t panel;
+static void* framebuffers[2];
+static TaskHandle_t volatile frame_waiter;  // LVGL task waiting for the swap
+
+static bool IRAM_ATTR on_frame_done(esp_lcd_panel_handle_t p, const esp_lcd_rgb_panel_event_data_t* edata,
+                                    void* user_ctx) {
+    BaseType_t high_task_wakeup = pdFALSE;
+    TaskHandle_t waiter = frame_waiter;
+
+    if (waiter) {
+        frame_waiter = NULL;
+        vTaskNotifyGiveFromISR(waiter, &high_task_wakeup);
+    }
+    return high_task_wakeup == pdTRUE;
+}
+
+void st7262_init(void) {
+    ESP_LOGI(TAG, "Initializing ST7262 display (RGB)");
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << PIN_NUM_BCKL,
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+    gpio_set_level(PIN_NUM_BCKL, 0);
+
+    esp_lcd_rgb_panel_config_t panel_config = {
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .timings = {
+            .pclk_hz = ST7262_PCLK_HZ,
+            .h_res = ST7262_WIDTH,
+            .v_res = ST7262_HEIGHT,
+            .hsync_pulse_width = ST7262_HSYNC_PULSE,
+            .hsync_back_porch = ST7262_HSYNC_BACK,
+            .hsync_front_porch = ST7262_HSYNC_FRONT,
+            .vsync_pulse_width = ST7262_VSYNC_PULSE,
+            .vsync_back_porch = ST7262_VSYNC_BACK,
+            .vsync_front_porch = ST7262_VSYNC_FRONT,
+            .flags.pclk_active_neg = 1,
+        },
+        .data_width = 16,
+        .bits_per_pixel = 16,
+        .num_fbs = 2,
+        .bounce_buffer_size_px = ST7262_WIDTH * ST7262_BOUNCE_LINES,
+        .psram_trans_align = 64,
+        .hsync_gpio_num = PIN_NUM_HSYNC,
+        .vsync_gpio_num = PIN_NUM_VSYNC,
+        .de_gpio_num = PIN_NUM_DE,
+        .pclk_gpio_num = PIN_NUM_PCLK,
+        .disp_gpio_num = -1,
+        .data_gpio_nums = PIN_NUM_DATA,
+        .flags.fb_in_psram = 1,
+    };
+    ESP_ERROR_CHECK(esp_lcd_new_rgb_panel(&panel_config, &panel));
+
+    // With bounce buffers the frame boundary is reported by the bounce
+    // engine once it has copied the last line of a frame
+    esp_lcd_rgb_panel_event_callbacks_t callbacks = {
+        .on_bounce_frame_finish = on_frame_done,
+    };
+    ESP_ERROR_CHECK(esp_lcd_rgb_panel_register_event_callbacks(panel, &callbacks, NULL));
+
+    ESP_ERROR_CHECK(esp_lcd_panel_reset(panel));
+    ESP_ERROR_CHECK(esp_lcd_panel_init(panel));
+    ESP_ERROR_CHECK(esp_lcd_rgb_panel_get_frame_buffer(panel, 2, &framebuffers[0], &framebuffers[1]));
+
+    gpio_set_level(PIN_NUM_BCKL, 1);
+    ESP_LOGI(TAG, "ST7262 initialized (%dx%d, 2 PSRAM framebuffers)", ST7262_WIDTH, ST7262_HEIGHT);
+}
+
+void st7262_get_framebuffers(void** fb1, void** fb2) {
+    *fb1 = framebuffers[0];
+    *fb2 = framebuffers[1];
+}
+
+// Direct mode only redraws invalidated areas, so after a swap the new
+// back buffer is missing what was just drawn into the front one. Copy
+// those areas across before LVGL draws the next refresh into it.
+static void sync_dirty_areas(const lv_color_t* front, lv_color_t* back) {
+    lv_disp_t* disp = _lv_refr_get_disp_refreshing();
+
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        if (disp->inv_area_joined[i]) {
+            continue;
+        }
+
+        const lv_area_t* area = &disp->inv_areas[i];
+        size_t row_bytes = lv_area_get_width(area) * sizeof(lv_color_t);
+        for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+            size_t offset = (size_t)y * ST7262_WIDTH + area->x1;
+            memcpy(back + offset, front + offset, row_bytes);
+        }
+    }
+}
+
+void st7262_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map) {
+    // LVGL already drew this area into the framebuffer; only the last
+    // area of a refresh needs the swap
+    if (!lv_disp_flush_is_last(drv)) {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+    uint32_t start = latency_now();
+
+    // Scan-out switches to color_map at the next frame start; wait for
+    // that boundary so the old front buffer is free to draw into
+    ulTaskNotifyTake(pdTRUE, 0);
+    frame_waiter = xTaskGetCurrentTaskHandle();
+    ESP_ERROR_CHECK(esp_lcd_panel_draw_bitmap(panel, 0, 0, ST7262_WIDTH, ST7262_HEIGHT, color_map));
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) == 0) {
+        frame_waiter = NULL;
+        ESP_LOGW(TAG, "No frame event after buffer swap");
+    }
+
+    lv_color_t* back = (color_map == framebuffers[0]) ? framebuffers[1] : framebuffers[0];
+    sync_dirty_areas(color_map, back);
+
+    lv_disp_flush_ready(drv);
+    latency_end(LATENCY_DISPLAY_FLUSH, start);
+}
+
+#else
+
+#define LCD_PIXEL_CLOCK_HZ (40 * 1000 * 1000)
+
+// D/C level for a transaction travels in its user field and is applied
+// by lcd_spi_pre_cb right before the transfer starts
+#define DC_CMD  ((void*)0)
+#define DC_DATA ((void*)1)
+
+// Flush transaction list: CASET, x1/x2, RASET, y1/y2, RAMWR, pixels
+enum {
+    FLUSH_CASET,
+    FLUSH_CASET_DATA,
+    FLUSH_RASET,
+    FLUSH_RASET_DATA,
+    FLUSH_RAMWR,
+    FLUSH_PIXELS,
+    FLUSH_TRANS_COUNT,
+};
+
+static spi_device_handle_t spi;
+static spi_transaction_t flush_trans[FLUSH_TRANS_COUNT];
+static int flush_in_flight;         // queued transactions not yet reclaimed
+static lv_disp_drv_t* flush_drv;
+static TaskHandle_t flush_waiter;   // LVGL task, woken when a flush completes
+
+static void IRAM_ATTR lcd_spi_pre_cb(spi_transaction_t* t) {
+    gpio_set_level(PIN_NUM_DC, (int)(intptr_t)t->user);
+}
+
+// Runs in the SPI ISR once a transfer completes; the pixel transfer is
+// the last of a flush, so LVGL may reuse that buffer from here on
+static void IRAM_ATTR lcd_spi_post_cb(spi_transaction_t* t) {
+    if (t == &flush_trans[FLUSH_PIXELS] && flush_drv) {
+        BaseType_t high_task_wakeup = pdFALSE;
+        lv_disp_flush_ready(flush_drv);
+        vTaskNotifyGiveFromISR(flush_waiter, &high_task_wakeup);
+        portYIELD_FROM_ISR(high_task_wakeup);
+    }
+}
+
 static void st7262_send_cmd(const uint8_t cmd) {
     esp_err_t ret;
     spi_transaction_t t = {
         .length = 8,
-        .tx_buffer = &cmd,
-        .flags = SPI_TRANS_USE_TXDATA
+        .tx_data = {cmd},
+        .flags = SPI_TRANS_USE_TXDATA,
+        .user = DC_CMD,
     };
-    gpio_set_level(PIN_NUM_DC, 0);
     ret = spi_device_polling_transmit(spi, &t);
     assert(ret == ESP_OK);
 }
@@ -15,42 +203,143 @@ static void st7262_send_data(const uint8_t data) {
     esp_err_t ret;
     spi_transaction_t t = {
         .length = 8,
-        .tx_buffer = &data,
-        .flags = SPI_TRANS_USE_TXDATA
+        .tx_data = {data},
+        .flags = SPI_TRANS_USE_TXDATA,
+        .user = DC_DATA,
     };
-    gpio_set_level(PIN_NUM_DC, 1);
     ret = spi_device_polling_transmit(spi, &t);
     assert(ret == ESP_OK);
 }
 
+static void set_cmd_trans(spi_transaction_t* t, uint8_t cmd) {
+    t->length = 8;
+    t->tx_data[0] = cmd;
+    t->flags = SPI_TRANS_USE_TXDATA;
+    t->user = DC_CMD;
+}
+
+static void set_window_trans(spi_transaction_t* t) {
+    t->length = 4 * 8;
+    t->flags = SPI_TRANS_USE_TXDATA;
+    t->user = DC_DATA;
+}
+
+// Built once; a flush only patches the window coordinates and the
+// pixel pointer/length
+static void build_flush_trans(void) {
+    memset(flush_trans, 0, sizeof(flush_trans));
+    set_cmd_trans(&flush_trans[FLUSH_CASET], 0x2A);
+    set_window_trans(&flush_trans[FLUSH_CASET_DATA]);
+    set_cmd_trans(&flush_trans[FLUSH_RASET], 0x2B);
+    set_window_trans(&flush_trans[FLUSH_RASET_DATA]);
+    set_cmd_trans(&flush_trans[FLUSH_RAMWR], 0x2C);
+    flush_trans[FLUSH_PIXELS].user = DC_DATA;
+}
+
+// Reclaim the previous flush's transactions. They are already finished
+// (LVGL only flushes again after lv_disp_flush_ready), so this never
+// waits on the wire.
+static void reclaim_flush_trans(void) {
+    spi_transaction_t* done;
+    while (flush_in_flight > 0) {
+        ESP_ERROR_CHECK(spi_device_get_trans_result(spi, &done, portMAX_DELAY));
+        flush_in_flight--;
+    }
+}
+
+void st7262_init(void) {
+    ESP_LOGI(TAG, "Initializing ST7262 display");
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << PIN_NUM_DC) | (1ULL << PIN_NUM_RST) | (1ULL << PIN_NUM_BCKL),
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+
+    spi_bus_config_t buscfg = {
+        .miso_io_num = PIN_NUM_MISO,
+        .mosi_io_num = PIN_NUM_MOSI,
+        .sclk_io_num = PIN_NUM_CLK,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = ST7262_WIDTH * 40 * sizeof(uint16_t),
+    };
+    ESP_ERROR_CHECK(spi_bus_initialize(LCD_HOST, &buscfg, DMA_CHAN));
+
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = LCD_PIXEL_CLOCK_HZ,
+        .mode = 0,
+        .spics_io_num = PIN_NUM_CS,
+        .queue_size = FLUSH_TRANS_COUNT + 1,
+        .pre_cb = lcd_spi_pre_cb,
+        .post_cb = lcd_spi_post_cb,
+    };
+    ESP_ERROR_CHECK(spi_bus_add_device(LCD_HOST, &devcfg, &spi));
+    build_flush_trans();
+
+    // Hardware reset
+    gpio_set_level(PIN_NUM_RST, 0);
+    vTaskDelay(pdMS_TO_TICKS(10));
+    gpio_set_level(PIN_NUM_RST, 1);
+    vTaskDelay(pdMS_TO_TICKS(120));
+
+    st7262_send_cmd(0x11);  // Sleep out
+    vTaskDelay(pdMS_TO_TICKS(120));
+    st7262_send_cmd(0x3A);  // Pixel format: RGB565
+    st7262_send_data(0x55);
+    st7262_send_cmd(0x36);  // Memory access control
+    st7262_send_data(0x00);
+    st7262_send_cmd(0x29);  // Display on
+
+    gpio_set_level(PIN_NUM_BCKL, 1);
+    ESP_LOGI(TAG, "ST7262 initialized (%dx%d)", ST7262_WIDTH, ST7262_HEIGHT);
+}
+
 void st7262_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map) {
+    uint32_t start = latency_now();
     uint32_t size = (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
-    
-    // Set column address
-    st7262_send_cmd(0x2A);
-    st7262_send_data(area->x1 >> 8);
-    st7262_send_data(area->x1 & 0xFF);
-    st7262_send_data(area->x2 >> 8);
-    st7262_send_data(area->x2 & 0xFF);
-    
-    // Set row address
-    st7262_send_cmd(0x2B);
-    st7262_send_data(area->y1 >> 8);
-    st7262_send_data(area->y1 & 0xFF);
-    st7262_send_data(area->y2 >> 8);
-    st7262_send_data(area->y2 & 0xFF);
-    
-    // Send memory write command
-    st7262_send_cmd(0x2C);
-    
-    // Send pixel data using DMA
-    spi_transaction_t t = {
-        .length = size * 16, // 16-bit color
-        .tx_buffer = color_map,
-        .flags = 0
-    };
-    gpio_set_level(PIN_NUM_DC, 1);
-    ESP_ERROR_CHECK(spi_device_polling_transmit(spi, &t));
-    
-    lv_disp_flush_ready(drv);
-}
\ No newline at end of file
+
+    reclaim_flush_trans();
+    flush_drv = drv;
+    flush_waiter = xTaskGetCurrentTaskHandle();
+
+    // Column and row window
+    uint8_t* caset = flush_trans[FLUSH_CASET_DATA].tx_data;
+    caset[0] = area->x1 >> 8;
+    caset[1] = area->x1 & 0xFF;
+    caset[2] = area->x2 >> 8;
+    caset[3] = area->x2 & 0xFF;
+
+    uint8_t* raset = flush_trans[FLUSH_RASET_DATA].tx_data;
+    raset[0] = area->y1 >> 8;
+    raset[1] = area->y1 & 0xFF;
+    raset[2] = area->y2 >> 8;
+    raset[3] = area->y2 & 0xFF;
+
+    // Pixel data goes out by DMA straight from LVGL's draw buffer
+    flush_trans[FLUSH_PIXELS].length = size * 16; // 16-bit color
+    flush_trans[FLUSH_PIXELS].tx_buffer = color_map;
+
+    // Queue the whole list and return; LVGL renders into the other draw
+    // buffer meanwhile and lcd_spi_post_cb reports completion
+    for (int i = 0; i < FLUSH_TRANS_COUNT; i++) {
+        ESP_ERROR_CHECK(spi_device_queue_trans(spi, &flush_trans[i], portMAX_DELAY));
+        flush_in_flight++;
+    }
+    latency_end(LATENCY_DISPLAY_FLUSH, start);
+}
+
+void st7262_get_framebuffers(void** fb1, void** fb2) {
+    // Command-mode panel: LVGL renders into partial buffers instead
+    *fb1 = NULL;
+    *fb2 = NULL;
+}
+
+#endif
+
+// LVGL calls this while it waits for a buffer to come back; sleep until
+// the post callback signals instead of spinning. The timeout only
+// bounds a missed notification, LVGL re-checks and calls again.
+void st7262_wait(lv_disp_drv_t* drv) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+}
@@ -6,7 +6,37 @@
 #define ST7262_WIDTH 800
 #define ST7262_HEIGHT 480
 
-// Hardware configuration
+// ST7262_RGB_MODE (lv_conf.h) selects the interface
+#if ST7262_RGB_MODE
+
+// Parallel RGB565 interface (JC8048W550C board wiring)
+#define ST7262_PCLK_HZ        (16 * 1000 * 1000)
+#define ST7262_HSYNC_PULSE    4
+#define ST7262_HSYNC_BACK     8
+#define ST7262_HSYNC_FRONT    8
+#define ST7262_VSYNC_PULSE    4
+#define ST7262_VSYNC_BACK     8
+#define ST7262_VSYNC_FRONT    8
+#define ST7262_BOUNCE_LINES   10   // internal-RAM bounce buffer height
+
+#define PIN_NUM_DE    40
+#define PIN_NUM_VSYNC 41
+#define PIN_NUM_HSYNC 39
+#define PIN_NUM_PCLK  42
+#define PIN_NUM_BCKL  2
+#define ST7262_DATA_PINS                  \
+    8, 3, 46, 9, 1,          /* B0..B4 */   \
+    5, 6, 7, 15, 16, 4,      /* G0..G5 */   \
+    45, 48, 47, 21, 14       /* R0..R4 */
+#define PIN_NUM_DATA { ST7262_DATA_PINS }
+
+// Every GPIO the panel drives, for the boot-time pin map check
+#define ST7262_PINS { ST7262_DATA_PINS, PIN_NUM_DE, PIN_NUM_VSYNC, PIN_NUM_HSYNC, \
+                      PIN_NUM_PCLK, PIN_NUM_BCKL }
+
+#else
+
+// SPI command-mode interface
 #define LCD_HOST SPI2_HOST
 #define DMA_CHAN 2
 #define PIN_NUM_MISO -1
@@ -17,5 +47,15 @@
 #define PIN_NUM_RST  9
 #define PIN_NUM_BCKL 8
 
+// Every GPIO the panel drives, for the boot-time pin map check
+#define ST7262_PINS { PIN_NUM_MOSI, PIN_NUM_CLK, PIN_NUM_CS, PIN_NUM_DC, PIN_NUM_RST, PIN_NUM_BCKL }
+
+#endif
+
 void st7262_init(void);
-void st7262_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map);
\ No newline at end of file
+
+// RGB mode: the two PSRAM framebuffers LVGL draws into directly
+void st7262_get_framebuffers(void** fb1, void** fb2);
+
+void st7262_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map);
+void st7262_wait(lv_disp_drv_t* drv);
@@ -0,0 +1,173 @@
+#include "telemetry.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "telemetry";
+
+#define EXPORT_CHUNK      256
+#define MAX_SAMPLE_BYTES  25    // five varints of up to 5 bytes
+
+_Static_assert((TELEMETRY_CAPACITY & (TELEMETRY_CAPACITY - 1)) == 0,
+               "TELEMETRY_CAPACITY must be a power of two");
+
+// Single producer: the slot is written first, then head is published.
+// Readers check head again after copying a slot to detect that the
+// producer lapped them meanwhile.
+static struct {
+    telemetry_sample_t samples[TELEMETRY_CAPACITY];
+    atomic_uint head;           // samples ever recorded
+    atomic_uint stop_at;        // freeze once head reaches this; 0 = never
+    atomic_bool frozen;
+} ring;
+
+void telemetry_record(float position_mm, uint16_t current_ma, uint8_t temperature, uint8_t status) {
+    if (atomic_load_explicit(&ring.frozen, memory_order_relaxed)) {
+        return;
+    }
+
+    unsigned int head = atomic_load_explicit(&ring.head, memory_order_relaxed);
+    telemetry_sample_t* slot = &ring.samples[head & (TELEMETRY_CAPACITY - 1)];
+    slot->time_us = (uint32_t)esp_timer_get_time();
+    slot->position_um = (int32_t)lroundf(position_mm * 1000.0f);
+    slot->current_ma = current_ma;
+    slot->temperature = temperature;
+    slot->status = status;
+    atomic_store_explicit(&ring.head, head + 1, memory_order_release);
+
+    unsigned int stop_at = atomic_load_explicit(&ring.stop_at, memory_order_relaxed);
+    if (stop_at != 0 && head + 1 == stop_at) {
+        atomic_store_explicit(&ring.frozen, true, memory_order_relaxed);
+    }
+}
+
+void telemetry_trigger(void) {
+    unsigned int expected = 0;
+    unsigned int stop_at = atomic_load_explicit(&ring.head, memory_order_relaxed) + TELEMETRY_POST_TRIGGER;
+    if (stop_at == 0) {
+        stop_at = 1;
+    }
+    // Only the first trip since re-arming decides the window
+    atomic_compare_exchange_strong(&ring.stop_at, &expected, stop_at);
+}
+
+void telemetry_rearm(void) {
+    atomic_store(&ring.stop_at, 0);
+    atomic_store(&ring.frozen, false);
+}
+
+bool telemetry_is_frozen(void) {
+    return atomic_load(&ring.frozen);
+}
+
+size_t telemetry_count(void) {
+    unsigned int head = atomic_load_explicit(&ring.head, memory_order_acquire);
+    return head < TELEMETRY_CAPACITY ? head : TELEMETRY_CAPACITY;
+}
+
+// Copies sample `index`; false if the producer has overwritten it
+static bool read_sample(unsigned int index, telemetry_sample_t* out) {
+    *out = ring.samples[index & (TELEMETRY_CAPACITY - 1)];
+    atomic_thread_fence(memory_order_acquire);
+    unsigned int head = atomic_load_explicit(&ring.head, memory_order_relaxed);
+    return head - index < TELEMETRY_CAPACITY;
+}
+
+esp_err_t telemetry_export(telemetry_sink_t sink, void* ctx) {
+    uint8_t chunk[EXPORT_CHUNK];
+    size_t used = 0;
+
+    unsigned int end = atomic_load_explicit(&ring.head, memory_order_acquire);
+    unsigned int index = end > TELEMETRY_CAPACITY ? end - TELEMETRY_CAPACITY : 0;
+
+    // Skip what the producer overwrites before we get to it
+    telemetry_sample_t prev;
+    while (index < end && !read_sample(index, &prev)) {
+        index++;
+    }
+    if (index == end) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memcpy(chunk, TELEMETRY_MAGIC, 4);
+    used = 4;
+    used += telemetry_put_varint(&chunk[used], prev.time_us);
+    uint32_t last_time = prev.time_us;
+    memset(&prev, 0, sizeof(prev));
+    prev.time_us = last_time;
+
+    for (; index < end; index++) {
+        telemetry_sample_t sample;
+        if (!read_sample(index, &sample)) {
+            continue;
+        }
+
+        if (used + MAX_SAMPLE_BYTES > sizeof(chunk)) {
+            esp_err_t err = sink(chunk, used, ctx);
+            if (err != ESP_OK) {
+                return err;
+            }
+            used = 0;
+        }
+
+        used += telemetry_put_varint(&chunk[used], sample.time_us - prev.time_us);
+        used += telemetry_put_varint(&chunk[used], telemetry_zigzag(sample.position_um - prev.position_um));
+        used += telemetry_put_varint(&chunk[used], telemetry_zigzag((int32_t)sample.current_ma - prev.current_ma));
+        used += telemetry_put_varint(&chunk[used], telemetry_zigzag((int32_t)sample.temperature - prev.temperature));
+        used += telemetry_put_varint(&chunk[used], telemetry_zigzag((int32_t)sample.status - prev.status));
+        prev = sample;
+    }
+
+    return used > 0 ? sink(chunk, used, ctx) : ESP_OK;
+}
+
+static esp_err_t console_sink(const uint8_t* data, size_t len, void* ctx) {
+    static const char hex[] = "0123456789abcdef";
+    char line[sizeof(TELEMETRY_HEX_PREFIX) + TELEMETRY_HEX_LINE * 2 + 1];
+    (void)ctx;
+
+    while (len > 0) {
+        size_t n = len < TELEMETRY_HEX_LINE ? len : TELEMETRY_HEX_LINE;
+        char* p = line + strlen(TELEMETRY_HEX_PREFIX);
+        memcpy(line, TELEMETRY_HEX_PREFIX, strlen(TELEMETRY_HEX_PREFIX));
+        for (size_t i = 0; i < n; i++) {
+            *p++ = hex[data[i] >> 4];
+            *p++ = hex[data[i] & 0x0F];
+        }
+        *p = '\0';
+        printf("%s\n", line);
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t telemetry_dump_console(void) {
+    esp_err_t err = telemetry_export(console_sink, NULL);
+    printf("%s\n", TELEMETRY_HEX_END);
+    return err;
+}
+
+static esp_err_t file_sink(const uint8_t* data, size_t len, void* ctx) {
+    return fwrite(data, 1, len, (FILE*)ctx) == len ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t telemetry_save(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot open %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = telemetry_export(file_sink, f);
+    if (fclose(f) != 0 && err == ESP_OK) {
+        err = ESP_FAIL;
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Saved %u samples to %s", (unsigned int)telemetry_count(), path);
+    }
+    return err;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Drive telemetry recorder: a preallocated ring of samples taken at the
+// status poll rate, overwritten oldest first. Recording is a slot copy
+// and an index store, safe to call from the servo bus task on every
+// reply.
+//
+// telemetry_trigger() (called when a fault trips) keeps recording for
+// TELEMETRY_POST_TRIGGER more samples and then freezes the buffer, so it
+// holds the run-up to a trip and what followed until re-armed.
+
+#ifndef TELEMETRY_CAPACITY
+#define TELEMETRY_CAPACITY     2048    // power of two, ~4 s at 500 Hz
+#endif
+#define TELEMETRY_POST_TRIGGER (TELEMETRY_CAPACITY / 4)
+
+// Export stream:
+//
+//   "TLM1" | varint t0 | sample... (to the end of the stream)
+//
+// Each sample is five varints: time delta (us, unsigned), then zigzag
+// deltas of position (um), current (mA), temperature (°C) and status
+// against the previous sample (the first against t0 and zeros). A
+// typical sample takes 5-7 bytes instead of 12.
+#define TELEMETRY_MAGIC        "TLM1"
+
+// Console export: the stream as hex, TELEMETRY_HEX_LINE bytes per line,
+// each line prefixed with TELEMETRY_HEX_PREFIX, then TELEMETRY_HEX_END
+#define TELEMETRY_HEX_PREFIX   "TLM "
+#define TELEMETRY_HEX_END      "TLM END"
+#define TELEMETRY_HEX_LINE     32
+
+typedef struct {
+    uint32_t time_us;       // esp_timer time, low 32 bits
+    int32_t position_um;
+    uint16_t current_ma;
+    uint8_t temperature;    // °C
+    uint8_t status;         // raw drive status bits
+} telemetry_sample_t;
+
+typedef esp_err_t (*telemetry_sink_t)(const uint8_t* data, size_t len, void* ctx);
+
+// Hot path: single producer (the servo bus task of the recorded axis)
+void telemetry_record(float position_mm, uint16_t current_ma, uint8_t temperature, uint8_t status);
+
+void telemetry_trigger(void);
+void telemetry_rearm(void);
+bool telemetry_is_frozen(void);
+
+// Samples currently held
+size_t telemetry_count(void);
+
+// Encode everything held, oldest first, through sink in small chunks.
+// Safe while recording continues; samples overwritten mid-export are
+// left out.
+esp_err_t telemetry_export(telemetry_sink_t sink, void* ctx);
+
+// Export as hex lines on the console, or as raw bytes to a file on a
+// mounted VFS path
+esp_err_t telemetry_dump_console(void);
+esp_err_t telemetry_save(const char* path);
+
+// Varint and zigzag helpers, shared with the host decoder
+
+// Writes at most 5 bytes, returns the count
+static inline size_t telemetry_put_varint(uint8_t* out, uint32_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// Returns bytes consumed, 0 if the input ends mid-varint or is malformed
+static inline size_t telemetry_get_varint(const uint8_t* in, size_t len, uint32_t* value) {
+    uint32_t result = 0;
+    for (size_t i = 0; i < len && i < 5; i++) {
+        result |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if (!(in[i] & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static inline uint32_t telemetry_zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t telemetry_unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
@@ -1,94 +1,224 @@
 #include "ui_common.h"
+#include <math.h>
 #include "servo42c.h"
 #include "safety.h"
+#include "cycles.h"
+#include "feed.h"
+#include "gcode.h"
+#include "settings.h"
 #include "esp_log.h"
 
 static const char* TAG = "ui_auto";
 
-lv_obj_t* auto_screen = NULL;
+static lv_obj_t* auto_screen = NULL;
 static lv_obj_t* feed_rate_slider = NULL;
 static lv_obj_t* depth_spinbox = NULL;
 static lv_obj_t* start_btn = NULL;
 static lv_obj_t* stop_btn = NULL;
+static lv_obj_t* cycle_dd = NULL;
+static lv_obj_t* r_plane_spinbox = NULL;
+static lv_obj_t* peck_spinbox = NULL;
+static lv_obj_t* progress_label = NULL;
+static lv_obj_t* tool_dd = NULL;
+static lv_timer_t* progress_timer = NULL;
+
+#define CYCLE_DWELL_S 0.3f  // at the bottom, lets the drill clear the chip
 
-static float current_feed_rate = 1.0f; // mm/s
-static float current_depth = 1.0f; // mm
 static bool cycle_running = false;
+static bool program_running = false;    // a G-code program holds the axis
+
+// Outlives the widgets when the screen is evicted; the cycle parameters
+// and the tool are settings
+static struct {
+    uint16_t cycle_type;    // cycle_type_t, in dropdown order
+} saved = {
+    .cycle_type = CYCLE_DRILL,
+};
 
+// Stop works for a cycle started here and for a G-code program; the
+// rest of the screen is locked while either runs
 static void update_cycle_status(bool running) {
     cycle_running = running;
+    bool busy = running || program_running;
     lv_obj_clear_state(start_btn, LV_STATE_DISABLED);
     lv_obj_clear_state(stop_btn, LV_STATE_DISABLED);
     lv_obj_clear_state(feed_rate_slider, LV_STATE_DISABLED);
     lv_obj_clear_state(depth_spinbox, LV_STATE_DISABLED);
+    lv_obj_clear_state(cycle_dd, LV_STATE_DISABLED);
+    lv_obj_clear_state(r_plane_spinbox, LV_STATE_DISABLED);
+    lv_obj_clear_state(peck_spinbox, LV_STATE_DISABLED);
+    lv_obj_clear_state(tool_dd, LV_STATE_DISABLED);
     
-    if (running) {
+    if (busy) {
         lv_obj_add_state(start_btn, LV_STATE_DISABLED);
         lv_obj_add_state(feed_rate_slider, LV_STATE_DISABLED);
         lv_obj_add_state(depth_spinbox, LV_STATE_DISABLED);
+        lv_obj_add_state(cycle_dd, LV_STATE_DISABLED);
+        lv_obj_add_state(r_plane_spinbox, LV_STATE_DISABLED);
+        lv_obj_add_state(peck_spinbox, LV_STATE_DISABLED);
+        lv_obj_add_state(tool_dd, LV_STATE_DISABLED);
     } else {
         lv_obj_add_state(stop_btn, LV_STATE_DISABLED);
     }
 }
 
-static void feed_rate_event_cb(lv_event_t* e) {
-    current_feed_rate = lv_slider_get_value(feed_rate_slider) / 10.0f;
+// Polls the cycle runner, and the G-code interpreter since a program
+// can be started from the serial port at any time
+static void progress_timer_cb(lv_timer_t* timer) {
+    uint16_t peck;
+    uint16_t pecks;
+    feed_status_t feed;
+    gcode_status_t program;
+    char buf[64];
+    gcode_get_status(&program);
+    bool program_now = program.state == GCODE_RUNNING;
+    bool cycle_now = cycle_is_running();
+    if (program_now != program_running || cycle_now != cycle_running) {
+        program_running = program_now;
+        update_cycle_status(cycle_now);
+    }
+
+    if (program_running) {
+        snprintf(buf, sizeof(buf), "G-code line %lu", (unsigned long)program.line_executing);
+        lv_label_set_text(progress_label, buf);
+        return;
+    }
+    if (!cycle_running) {
+        return;
+    }
+
+    cycle_get_progress(&peck, &pecks);
+    feed_get_status(&feed);
+    if (feed.target_ma) {
+        snprintf(buf, sizeof(buf), "Peck %u/%u  Feed x%.2f  Load %.0f%%", peck, pecks,
+                 feed.override, feed.load * 100.0f);
+    } else {
+        snprintf(buf, sizeof(buf), "Peck %u/%u", peck, pecks);
+    }
+    lv_label_set_text(progress_label, buf);
+}
+
+static void update_feed_rate_label(void) {
     char buf[32];
-    snprintf(buf, sizeof(buf), "Feed: %.1f mm/s", current_feed_rate);
+    snprintf(buf, sizeof(buf), "Feed: %.1f mm/s", settings_get()->feed_rate);
     lv_obj_t* label = lv_obj_get_child(feed_rate_slider, 0);
     lv_label_set_text(label, buf);
 }
 
+// Cycle parameters are settings: kept in RAM, saved once editing stops
+static void feed_rate_event_cb(lv_event_t* e) {
+    settings_set_float(SETTING_FEED_RATE, lv_slider_get_value(feed_rate_slider) / 10.0f);
+    update_feed_rate_label();
+}
+
+static void cycle_type_event_cb(lv_event_t* e) {
+    saved.cycle_type = lv_dropdown_get_selected(cycle_dd);
+}
+
 static void depth_event_cb(lv_event_t* e) {
-    current_depth = lv_spinbox_get_value(depth_spinbox) / 10.0f;
+    settings_set_float(SETTING_DEPTH, lv_spinbox_get_value(depth_spinbox) / 10.0f);
+}
+
+static void r_plane_event_cb(lv_event_t* e) {
+    settings_set_float(SETTING_R_PLANE, lv_spinbox_get_value(r_plane_spinbox) / 10.0f);
+}
+
+static void peck_event_cb(lv_event_t* e) {
+    settings_set_float(SETTING_PECK, lv_spinbox_get_value(peck_spinbox) / 10.0f);
 }
 
 static void start_btn_event_cb(lv_event_t* e) {
     if (!cycle_running) {
         servo42c_state_t state;
-        servo42c_get_state(&state);
+        servo42c_get_state(ui_axis, &state);
         
-        if (state.is_homed && safety_is_position_valid(current_depth)) {
+        if (!state.is_homed) {
+            ui_show_error("Home machine first!");
+            return;
+        }
+
+        // Dropdown order matches cycle_type_t
+        const settings_t* settings = settings_get();
+        cycle_params_t params = {
+            .type = (cycle_type_t)saved.cycle_type,
+            .r_plane = settings->r_plane,
+            .depth = settings->depth,
+            .peck = settings->peck,
+            .feed = settings->feed_rate,
+            .dwell = CYCLE_DWELL_S,
+        };
+        esp_err_t ret = cycle_start(&params);
+        if (ret == ESP_OK) {
             update_cycle_status(true);
-            servo42c_move_to(current_depth, current_feed_rate);
+        } else if (ret == ESP_ERR_INVALID_ARG) {
+            ui_show_error("R plane must be above depth");
+        } else if (planner_get_owner() == PLANNER_OWNER_GCODE) {
+            ui_show_error("G-code program running");
         } else {
-            ui_show_error("Home machine first!");
+            ui_show_error("Axis busy");
         }
     }
 }
 
 static void stop_btn_event_cb(lv_event_t* e) {
-    if (cycle_running) {
-        servo42c_stop();
+    if (program_running) {
+        gcode_abort();
+        servo42c_stop(ui_axis);
+        program_running = false;
+        update_cycle_status(false);
+    } else if (cycle_running) {
+        cycle_stop();
+        servo42c_stop(ui_axis);
         update_cycle_status(false);
     }
 }
 
+// Adaptive feed targets the selected tool's cutting current
+static void tool_event_cb(lv_event_t* e) {
+    uint16_t tool = lv_dropdown_get_selected(tool_dd);
+    if (feed_set_tool(feed_get_tool(tool)) != ESP_OK) {
+        ui_show_error("Tool not available");
+        tool = 0;
+        lv_dropdown_set_selected(tool_dd, tool);
+        feed_set_tool(feed_get_tool(tool));
+    }
+    settings_set_uint(SETTING_TOOL, tool);
+}
+
 static void return_btn_event_cb(lv_event_t* e) {
     if (!cycle_running) {
         ui_show_screen(SCREEN_MAIN);
     }
 }
 
-void ui_auto_init(void) {
+// The progress timer lives outside the widget tree
+static void screen_delete_cb(lv_event_t* e) {
+    lv_timer_del(progress_timer);
+    progress_timer = NULL;
+    auto_screen = NULL;
+}
+
+lv_obj_t* ui_auto_create(void) {
+    const settings_t* settings = settings_get();
     auto_screen = lv_obj_create(NULL);
+    lv_obj_add_event_cb(auto_screen, screen_delete_cb, LV_EVENT_DELETE, NULL);
     
     // Feed rate control
     feed_rate_slider = lv_slider_create(auto_screen);
     lv_obj_set_size(feed_rate_slider, 200, 20);
     lv_obj_align(feed_rate_slider, LV_ALIGN_TOP_MID, 0, 50);
     lv_slider_set_range(feed_rate_slider, 1, 100); // 0.1 to 10.0 mm/s
-    lv_slider_set_value(feed_rate_slider, current_feed_rate * 10, LV_ANIM_OFF);
+    lv_slider_set_value(feed_rate_slider, lroundf(settings->feed_rate * 10), LV_ANIM_OFF);
     lv_obj_add_event_cb(feed_rate_slider, feed_rate_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
     
     lv_obj_t* label = lv_label_create(feed_rate_slider);
-    lv_label_set_text(label, "Feed: 1.0 mm/s");
+    update_feed_rate_label();
     lv_obj_align_to(label, feed_rate_slider, LV_ALIGN_OUT_BOTTOM_MID, 0, 5);
     
     // Depth control
     depth_spinbox = lv_spinbox_create(auto_screen);
     lv_spinbox_set_range(depth_spinbox, 5, 100); // 0.5 to 10.0 mm
-    lv_spinbox_set_value(depth_spinbox, current_depth * 10);
+    lv_spinbox_set_value(depth_spinbox, lroundf(settings->depth * 10));
     lv_spinbox_set_step(depth_spinbox, 1);
     lv_obj_set_size(depth_spinbox, 100, 40);
     lv_obj_align(depth_spinbox, LV_ALIGN_TOP_MID, 0, 100);
@@ -98,6 +228,60 @@ void ui_auto_init(void) {
     lv_label_set_text(label, "Depth (mm)");
     lv_obj_align_to(label, depth_spinbox, LV_ALIGN_OUT_TOP_MID, 0, -5);
     
+    // Cycle column: type, clearance plane and peck increment
+    cycle_dd = lv_dropdown_create(auto_screen);
+    lv_dropdown_set_options(cycle_dd,
+        "Drill\n"
+        "Peck\n"
+        "Chip break");
+    lv_dropdown_set_selected(cycle_dd, saved.cycle_type);
+    lv_obj_align(cycle_dd, LV_ALIGN_TOP_LEFT, 20, 50);
+    lv_obj_add_event_cb(cycle_dd, cycle_type_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    
+    r_plane_spinbox = lv_spinbox_create(auto_screen);
+    lv_spinbox_set_range(r_plane_spinbox, 0, 50); // 0.0 to 5.0 mm
+    lv_spinbox_set_value(r_plane_spinbox, lroundf(settings->r_plane * 10));
+    lv_spinbox_set_step(r_plane_spinbox, 1);
+    lv_obj_set_size(r_plane_spinbox, 100, 40);
+    lv_obj_align(r_plane_spinbox, LV_ALIGN_TOP_LEFT, 20, 130);
+    lv_obj_add_event_cb(r_plane_spinbox, r_plane_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    
+    label = lv_label_create(auto_screen);
+    lv_label_set_text(label, "R plane (mm)");
+    lv_obj_align_to(label, r_plane_spinbox, LV_ALIGN_OUT_TOP_LEFT, 0, -5);
+    
+    peck_spinbox = lv_spinbox_create(auto_screen);
+    lv_spinbox_set_range(peck_spinbox, 1, 50); // 0.1 to 5.0 mm
+    lv_spinbox_set_value(peck_spinbox, lroundf(settings->peck * 10));
+    lv_spinbox_set_step(peck_spinbox, 1);
+    lv_obj_set_size(peck_spinbox, 100, 40);
+    lv_obj_align(peck_spinbox, LV_ALIGN_TOP_LEFT, 20, 210);
+    lv_obj_add_event_cb(peck_spinbox, peck_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    
+    label = lv_label_create(auto_screen);
+    lv_label_set_text(label, "Peck (mm)");
+    lv_obj_align_to(label, peck_spinbox, LV_ALIGN_OUT_TOP_LEFT, 0, -5);
+    
+    // Tool column: fixed feed or adaptive feed at the tool's current
+    tool_dd = lv_dropdown_create(auto_screen);
+    lv_dropdown_clear_options(tool_dd);
+    for (size_t i = 0; i < FEED_TOOL_COUNT; i++) {
+        lv_dropdown_add_option(tool_dd, feed_get_tool(i)->name, LV_DROPDOWN_POS_LAST);
+    }
+    lv_dropdown_set_selected(tool_dd, settings->tool);
+    lv_obj_align(tool_dd, LV_ALIGN_TOP_RIGHT, -20, 50);
+    lv_obj_add_event_cb(tool_dd, tool_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    
+    label = lv_label_create(auto_screen);
+    lv_label_set_text(label, "Tool");
+    lv_obj_align_to(label, tool_dd, LV_ALIGN_OUT_TOP_LEFT, 0, -5);
+    
+    progress_label = lv_label_create(auto_screen);
+    lv_label_set_text(progress_label, "");
+    lv_obj_align(progress_label, LV_ALIGN_TOP_LEFT, 20, 270);
+    
+    progress_timer = lv_timer_create(progress_timer_cb, 100, NULL);
+    
     // Start/Stop buttons
     start_btn = lv_btn_create(auto_screen);
     lv_obj_set_size(start_btn, 120, 50);
@@ -128,4 +312,12 @@ void ui_auto_init(void) {
     lv_obj_center(label);
     
     lv_obj_add_event_cb(return_btn, return_btn_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    // A rebuilt screen picks up a cycle or program that is still running
+    gcode_status_t program;
+    gcode_get_status(&program);
+    program_running = program.state == GCODE_RUNNING;
+    update_cycle_status(cycle_is_running());
+    
+    return auto_screen;
 }
\ No newline at end of file
@@ -5,18 +5,30 @@
 
 static const char* TAG = "ui_calibration";
 
-static lv_obj_t* calib_screen = NULL;
+static lv_obj_t* calibration_screen = NULL;
 static lv_obj_t* home_btn = NULL;
 static lv_obj_t* zero_btn = NULL;
-static lv_obj_t* status_label = NULL;
+static lv_obj_t* calib_status_label = NULL;
+
+// Outlives the widgets when the screen is evicted
+static struct {
+    const char* status;     // string literal
+} saved = {
+    .status = "Ready for calibration",
+};
 
 static void update_status(const char* msg) {
-    lv_label_set_text(status_label, msg);
+    saved.status = msg;
+    lv_label_set_text(calib_status_label, msg);
 }
 
+// A program can start from the serial port while this screen is open
 static void home_btn_event_cb(lv_event_t* e) {
+    if (ui_axis_busy()) {
+        return;
+    }
     update_status("Homing...");
-    esp_err_t err = servo42c_home();
+    esp_err_t err = servo42c_home(ui_axis);
     
     if (err == ESP_OK) {
         update_status("Homing complete");
@@ -26,8 +38,11 @@ static void home_btn_event_cb(lv_event_t* e) {
 }
 
 static void zero_btn_event_cb(lv_event_t* e) {
+    if (ui_axis_busy()) {
+        return;
+    }
     servo42c_state_t state;
-    esp_err_t err = servo42c_get_state(&state);
+    esp_err_t err = servo42c_get_state(ui_axis, &state);
     
     if (err == ESP_OK && !state.is_moving) {
         // Reset position to 0
@@ -39,21 +54,21 @@ static void zero_btn_event_cb(lv_event_t* e) {
 
 static void return_btn_event_cb(lv_event_t* e) {
     servo42c_state_t state;
-    if (servo42c_get_state(&state) == ESP_OK && !state.is_moving) {
+    if (servo42c_get_state(ui_axis, &state) == ESP_OK && !state.is_moving) {
         ui_show_screen(SCREEN_MAIN);
     }
 }
 
-void ui_calibration_init(void) {
-    calib_screen = lv_obj_create(NULL);
+lv_obj_t* ui_calibration_create(void) {
+    calibration_screen = lv_obj_create(NULL);
     
     // Status label
-    status_label = lv_label_create(calib_screen);
-    lv_obj_align(status_label, LV_ALIGN_TOP_MID, 0, 20);
-    lv_label_set_text(status_label, "Ready for calibration");
+    calib_status_label = lv_label_create(calibration_screen);
+    lv_obj_align(calib_status_label, LV_ALIGN_TOP_MID, 0, 20);
+    lv_label_set_text(calib_status_label, saved.status);
     
     // Home button
-    home_btn = lv_btn_create(calib_screen);
+    home_btn = lv_btn_create(calibration_screen);
     lv_obj_set_size(home_btn, 150, 60);
     lv_obj_align(home_btn, LV_ALIGN_CENTER, 0, -40);
     lv_obj_add_event_cb(home_btn, home_btn_event_cb, LV_EVENT_CLICKED, NULL);
@@ -63,7 +78,7 @@ void ui_calibration_init(void) {
     lv_obj_center(label);
     
     // Zero position button
-    zero_btn = lv_btn_create(calib_screen);
+    zero_btn = lv_btn_create(calibration_screen);
     lv_obj_set_size(zero_btn, 150, 60);
     lv_obj_align(zero_btn, LV_ALIGN_CENTER, 0, 40);
     lv_obj_add_event_cb(zero_btn, zero_btn_event_cb, LV_EVENT_CLICKED, NULL);
@@ -73,7 +88,7 @@ void ui_calibration_init(void) {
     lv_obj_center(label);
     
     // Return to main button
-    lv_obj_t* return_btn = lv_btn_create(calib_screen);
+    lv_obj_t* return_btn = lv_btn_create(calibration_screen);
     lv_obj_set_size(return_btn, 100, 40);
     lv_obj_align(return_btn, LV_ALIGN_BOTTOM_MID, 0, -20);
     
@@ -82,4 +97,6 @@ void ui_calibration_init(void) {
     lv_obj_center(label);
     
     lv_obj_add_event_cb(return_btn, return_btn_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    return calibration_screen;
 }
\ No newline at end of file
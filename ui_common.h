@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lvgl.h"
+#include "servo42c.h"
 
 // Common UI elements
 extern lv_obj_t* status_bar;
@@ -14,22 +15,49 @@ typedef enum {
     SCREEN_MANUAL,
     SCREEN_AUTO,
     SCREEN_CALIBRATION,
+    SCREEN_DIAGNOSTICS,
+    SCREEN_COUNT,
 } screen_id_t;
 
-// Screen handles
-extern lv_obj_t* main_screen;
-extern lv_obj_t* manual_screen;
-extern lv_obj_t* auto_screen;
-extern lv_obj_t* calibration_screen;
+// Screens are built on their first ui_show_screen() and then cached,
+// least recently shown evicted first, while the LVGL heap they use stays
+// within UI_SCREEN_CACHE_BUDGET. The main screen is built by ui_init()
+// and never evicted. Each screen module keeps what the operator set up
+// in a plain struct that outlives its widgets, so a screen rebuilt
+// after eviction comes back as it was left.
+#ifndef UI_SCREEN_CACHE_BUDGET
+#define UI_SCREEN_CACHE_BUDGET (24U * 1024U)   // bytes of LVGL heap, main screen excluded
+#endif
 
-void ui_init(void);
+// Axis the screens jog, home and show
+extern servo42c_handle_t ui_axis;
+
+// True, with an error shown, while a cycle or G-code program owns the
+// axis; jogging and homing must wait until it is done
+bool ui_axis_busy(void);
+
+void ui_init(servo42c_handle_t axis);
 void ui_show_screen(screen_id_t screen);
+
+// Safe from any task: values are posted to the UI model and drawn by
+// the LVGL task on its next refresh
 void ui_update_position(float position);
 void ui_update_status(const char* status);
 void ui_show_error(const char* message);
 
-// Screen initialization functions
-void ui_main_init(void);
-void ui_manual_init(void);
-void ui_auto_init(void);
-void ui_calibration_init(void);
\ No newline at end of file
+// LVGL task only: apply pending model updates, call before lv_task_handler()
+void ui_process_updates(void);
+
+// LVGL task only: draw a value the model found changed
+void ui_apply_position(float position);
+void ui_apply_status(const char* status);
+void ui_apply_error(const char* message);
+
+// Screen builders, called by the cache: create the screen from the
+// module's saved state and return it. Anything a screen owns outside its
+// widget tree (timers) is released when the screen is deleted.
+lv_obj_t* ui_main_create(void);
+lv_obj_t* ui_manual_create(void);
+lv_obj_t* ui_auto_create(void);
+lv_obj_t* ui_calibration_create(void);
+lv_obj_t* ui_diagnostics_create(void);
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include "ui_common.h"
+#include "latency.h"
+#include "lv_alloc.h"
+#include "esp_log.h"
+
+static const char* TAG = "ui_diagnostics";
+
+#define REFRESH_PERIOD_MS 500
+
+static lv_obj_t* diagnostics_screen = NULL;
+static lv_obj_t* latency_table = NULL;
+static lv_obj_t* heap_label = NULL;
+static lv_timer_t* refresh_timer = NULL;
+
+static void refresh_table(void) {
+    latency_stats_t stats;
+
+    for (int p = 0; p < LATENCY_PROBE_COUNT; p++) {
+        uint16_t row = p + 1;
+        latency_get_stats(p, &stats);
+        lv_table_set_cell_value_fmt(latency_table, row, 1, "%u", (unsigned int)stats.count);
+        // LVGL's own formatter is built without float support
+        const float values[] = { stats.p50_us, stats.p90_us, stats.p99_us, stats.max_us };
+        for (int col = 0; col < 4; col++) {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%.1f", values[col]);
+            lv_table_set_cell_value(latency_table, row, col + 2, buf);
+        }
+    }
+}
+
+static void refresh_heap(void) {
+    lv_alloc_stats_t stats;
+
+    lv_alloc_get_stats(&stats);
+    lv_label_set_text_fmt(heap_label,
+                          "LVGL heap: %u KB used (peak %u), %u KB reserved (peak %u), "
+                          "%u%% of it unused, system heap %u%% fragmented, %u failed",
+                          (unsigned int)(stats.used / 1024), (unsigned int)(stats.peak_used / 1024),
+                          (unsigned int)(stats.reserved / 1024), (unsigned int)(stats.peak_reserved / 1024),
+                          stats.frag_pct, stats.heap_frag_pct, (unsigned int)stats.failed);
+}
+
+// Only redraws while the screen is shown
+static void refresh_timer_cb(lv_timer_t* timer) {
+    if (lv_scr_act() == diagnostics_screen) {
+        refresh_table();
+        refresh_heap();
+    }
+}
+
+static void reset_btn_event_cb(lv_event_t* e) {
+    latency_reset();
+    refresh_table();
+}
+
+static void dump_btn_event_cb(lv_event_t* e) {
+    ESP_LOGI(TAG, "Latency histograms:");
+    latency_dump_console();
+}
+
+static void return_btn_event_cb(lv_event_t* e) {
+    ui_show_screen(SCREEN_MAIN);
+}
+
+static lv_obj_t* create_button(const char* text, lv_align_t align, lv_coord_t x, lv_event_cb_t cb) {
+    lv_obj_t* btn = lv_btn_create(diagnostics_screen);
+    lv_obj_set_size(btn, 100, 40);
+    lv_obj_align(btn, align, x, -20);
+    lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t* label = lv_label_create(btn);
+    lv_label_set_text(label, text);
+    lv_obj_center(label);
+    return btn;
+}
+
+static void screen_delete_cb(lv_event_t* e) {
+    lv_timer_del(refresh_timer);
+    refresh_timer = NULL;
+    diagnostics_screen = NULL;
+}
+
+lv_obj_t* ui_diagnostics_create(void) {
+    static const char* const headers[] = { "Probe", "Count", "p50 us", "p90 us", "p99 us", "Max us" };
+
+    diagnostics_screen = lv_obj_create(NULL);
+    lv_obj_add_event_cb(diagnostics_screen, screen_delete_cb, LV_EVENT_DELETE, NULL);
+
+    lv_obj_t* title = lv_label_create(diagnostics_screen);
+    lv_label_set_text(title, "Latency (percentiles are log2 bucket bounds)");
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
+
+    latency_table = lv_table_create(diagnostics_screen);
+    lv_table_set_col_cnt(latency_table, 6);
+    lv_table_set_row_cnt(latency_table, LATENCY_PROBE_COUNT + 1);
+    for (int col = 0; col < 6; col++) {
+        lv_table_set_col_width(latency_table, col, col == 0 ? 200 : 100);
+        lv_table_set_cell_value(latency_table, 0, col, headers[col]);
+    }
+    for (int p = 0; p < LATENCY_PROBE_COUNT; p++) {
+        lv_table_set_cell_value(latency_table, p + 1, 0, latency_probe_name(p));
+    }
+    lv_obj_set_size(latency_table, 720, 340);
+    lv_obj_align(latency_table, LV_ALIGN_TOP_MID, 0, 40);
+    refresh_table();
+
+    heap_label = lv_label_create(diagnostics_screen);
+    lv_obj_align(heap_label, LV_ALIGN_TOP_MID, 0, 390);
+    refresh_heap();
+
+    create_button("Reset", LV_ALIGN_BOTTOM_LEFT, 20, reset_btn_event_cb);
+    create_button("Dump", LV_ALIGN_BOTTOM_MID, 0, dump_btn_event_cb);
+    create_button("Back", LV_ALIGN_BOTTOM_RIGHT, -20, return_btn_event_cb);
+
+    refresh_timer = lv_timer_create(refresh_timer_cb, REFRESH_PERIOD_MS, NULL);
+    return diagnostics_screen;
+}
@@ -1,6 +1,7 @@
 #include "ui_common.h"
 #include "lvgl.h"
 #include "esp_log.h"
+#include "planner.h"
 #include "safety.h"
 #include "servo42c.h"
 
@@ -10,22 +11,24 @@ lv_obj_t* status_bar = NULL;
 lv_obj_t* position_label = NULL;
 lv_obj_t* status_label = NULL;
 lv_obj_t* emergency_stop_btn = NULL;
-lv_obj_t* main_screen = NULL;
+static lv_obj_t* main_screen = NULL;
+servo42c_handle_t ui_axis = NULL;
 
 static lv_obj_t* manual_btn = NULL;
 static lv_obj_t* auto_btn = NULL;
 static lv_obj_t* calib_btn = NULL;
+static lv_obj_t* diag_btn = NULL;
 
 static void emergency_stop_handler(lv_event_t* e) {
     safety_emergency_stop();
-    servo42c_emergency_stop();
+    servo42c_emergency_stop_all();
     ui_show_error("EMERGENCY STOP ACTIVATED");
     ui_update_status("E-STOP");
     
     // Disable all mode buttons
-    lv_obj_set_enabled(manual_btn, false);
-    lv_obj_set_enabled(auto_btn, false);
-    lv_obj_set_enabled(calib_btn, false);
+    lv_obj_add_state(manual_btn, LV_STATE_DISABLED);
+    lv_obj_add_state(auto_btn, LV_STATE_DISABLED);
+    lv_obj_add_state(calib_btn, LV_STATE_DISABLED);
 }
 
 static void create_status_bar(void) {
@@ -55,13 +58,26 @@ static void create_emergency_stop(void) {
     lv_obj_center(label);
 }
 
+bool ui_axis_busy(void) {
+    planner_owner_t owner = planner_get_owner();
+    if (owner == PLANNER_OWNER_NONE) {
+        return false;
+    }
+    ui_show_error(owner == PLANNER_OWNER_GCODE ? "G-code program running" : "Cycle running");
+    return true;
+}
+
 static void mode_btn_event_cb(lv_event_t* e) {
     if (safety_get_status() != SAFETY_OK) {
         ui_show_error("Clear safety error first!");
         return;
     }
     
+    // Auto stays reachable: it shows the program and can stop it
     lv_obj_t* btn = lv_event_get_target(e);
+    if ((btn == manual_btn || btn == calib_btn) && ui_axis_busy()) {
+        return;
+    }
     if (btn == manual_btn) {
         ui_show_screen(SCREEN_MANUAL);
     } else if (btn == auto_btn) {
@@ -71,7 +87,12 @@ static void mode_btn_event_cb(lv_event_t* e) {
     }
 }
 
-void ui_init(void) {
+// Diagnostics only reads counters, so it stays reachable after a fault
+static void diag_btn_event_cb(lv_event_t* e) {
+    ui_show_screen(SCREEN_DIAGNOSTICS);
+}
+
+lv_obj_t* ui_main_create(void) {
     main_screen = lv_obj_create(NULL);
     
     create_status_bar();
@@ -106,62 +127,64 @@ void ui_init(void) {
     lv_label_set_text(label, "Calibration");
     lv_obj_center(label);
     
-    // Initialize other screens
-    ui_manual_init();
-    ui_auto_init();
-    ui_calibration_init();
+    diag_btn = lv_btn_create(main_screen);
+    lv_obj_set_size(diag_btn, 140, 50);
+    lv_obj_align(diag_btn, LV_ALIGN_BOTTOM_LEFT, 20, -20);
+    lv_obj_add_event_cb(diag_btn, diag_btn_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    label = lv_label_create(diag_btn);
+    lv_label_set_text(label, "Diagnostics");
+    lv_obj_center(label);
     
-    lv_scr_load(main_screen);
+    return main_screen;
 }
 
-void ui_show_screen(screen_id_t screen) {
-    switch (screen) {
-        case SCREEN_MAIN:
-            lv_scr_load(main_screen);
-            break;
-        case SCREEN_MANUAL:
-            lv_scr_load(manual_screen);
-            break;
-        case SCREEN_AUTO:
-            lv_scr_load(auto_screen);
-            break;
-        case SCREEN_CALIBRATION:
-            lv_scr_load(calibration_screen);
-            break;
-        default:
-            ESP_LOGW(TAG, "Unknown screen ID: %d", screen);
-            break;
-    }
+// Only the main screen is built now; the others on first use
+void ui_init(servo42c_handle_t axis) {
+    ui_axis = axis;
+    ui_show_screen(SCREEN_MAIN);
 }
 
-void ui_update_position(float position) {
+void ui_apply_position(float position) {
     char buf[32];
     snprintf(buf, sizeof(buf), "Pos: %.2f mm", position);
     lv_label_set_text(position_label, buf);
 }
 
-void ui_update_status(const char* status) {
+void ui_apply_status(const char* status) {
     char buf[64];
     snprintf(buf, sizeof(buf), "Status: %s", status);
     lv_label_set_text(status_label, buf);
 }
 
-void ui_show_error(const char* message) {
-    static lv_obj_t* error_popup = NULL;
-    
-    if (error_popup) {
-        lv_obj_del(error_popup);
+static lv_obj_t* error_popup = NULL;
+static lv_obj_t* error_label = NULL;
+static lv_timer_t* error_timer = NULL;
+
+static void error_timer_cb(lv_timer_t* timer) {
+    lv_obj_add_flag(error_popup, LV_OBJ_FLAG_HIDDEN);
+    lv_timer_pause(timer);
+}
+
+void ui_apply_error(const char* message) {
+    // One popup on the top layer (visible over every screen) and one
+    // timer, both reused for every error
+    if (!error_popup) {
+        error_popup = lv_obj_create(lv_layer_top());
+        lv_obj_set_size(error_popup, 400, 200);
+        lv_obj_center(error_popup);
+        lv_obj_set_style_bg_color(error_popup, lv_color_hex(0xFF5555), 0);
+        
+        error_label = lv_label_create(error_popup);
+        lv_obj_center(error_label);
+        
+        error_timer = lv_timer_create(error_timer_cb, 3000, NULL);
     }
     
-    error_popup = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(error_popup, 400, 200);
-    lv_obj_center(error_popup);
-    lv_obj_set_style_bg_color(error_popup, lv_color_hex(0xFF5555), 0);
-    
-    lv_obj_t* label = lv_label_create(error_popup);
-    lv_label_set_text(label, message);
-    lv_obj_center(label);
+    lv_label_set_text(error_label, message);
+    lv_obj_clear_flag(error_popup, LV_OBJ_FLAG_HIDDEN);
     
     // Auto-hide after 3 seconds
-    lv_timer_create((lv_timer_cb_t)lv_obj_del, 3000, error_popup);
-}
\ No newline at end of file
+    lv_timer_reset(error_timer);
+    lv_timer_resume(error_timer);
+}
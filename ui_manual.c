@@ -1,55 +1,72 @@
 #include "ui_common.h"
+#include <math.h>
 #include "servo42c.h"
 #include "safety.h"
+#include "settings.h"
 #include "esp_log.h"
 
 static const char* TAG = "ui_manual";
 
-lv_obj_t* manual_screen = NULL;
+static lv_obj_t* manual_screen = NULL;
 static lv_obj_t* step_size_dd = NULL;
 static lv_obj_t* speed_slider = NULL;
 static lv_obj_t* jog_forward_btn = NULL;
 static lv_obj_t* jog_backward_btn = NULL;
 
 static const float step_sizes[] = {0.01f, 0.05f, 0.1f, 0.5f, 1.0f, 5.0f};
-static float current_speed = 50.0f; // 50% default speed
+
+// Outlives the widgets when the screen is evicted
+static struct {
+    uint16_t step_index;
+} saved = {
+    .step_index = 0,
+};
 
 static void jog_btn_event_cb(lv_event_t* e) {
     lv_obj_t* btn = lv_event_get_target(e);
     lv_event_code_t code = lv_event_get_code(e);
     
-    if (code == LV_EVENT_PRESSED) {
-        uint16_t selected = lv_dropdown_get_selected(step_size_dd);
-        float step = step_sizes[selected];
+    if (code == LV_EVENT_PRESSED && !ui_axis_busy()) {
+        float step = step_sizes[saved.step_index];
         float direction = (btn == jog_forward_btn) ? 1.0f : -1.0f;
         
         servo42c_state_t state;
-        servo42c_get_state(&state);
+        servo42c_get_state(ui_axis, &state);
         
-        float target = state.current_position + (step * direction);
+        // Repeated jogs during a move add up from the commanded target
+        float base = state.is_moving ? state.target_position : state.current_position;
+        float target = base + (step * direction);
         if (safety_is_position_valid(target)) {
-            float speed = (current_speed / 100.0f) * 10.0f; // Max 10mm/s
-            servo42c_move_to(target, speed);
+            float speed = (settings_get()->jog_speed / 100.0f) * 10.0f; // Max 10mm/s
+            servo42c_move_to(ui_axis, target, speed);
         }
     }
 }
 
-static void speed_slider_event_cb(lv_event_t* e) {
-    current_speed = lv_slider_get_value(speed_slider);
+static void step_size_event_cb(lv_event_t* e) {
+    saved.step_index = lv_dropdown_get_selected(step_size_dd);
+}
+
+static void update_speed_label(void) {
     char buf[32];
-    snprintf(buf, sizeof(buf), "Speed: %.0f%%", current_speed);
+    snprintf(buf, sizeof(buf), "Speed: %.0f%%", settings_get()->jog_speed);
     lv_obj_t* label = lv_obj_get_child(speed_slider, 0);
     lv_label_set_text(label, buf);
 }
 
+static void speed_slider_event_cb(lv_event_t* e) {
+    settings_set_float(SETTING_JOG_SPEED, lv_slider_get_value(speed_slider));
+    update_speed_label();
+}
+
 static void return_btn_event_cb(lv_event_t* e) {
     servo42c_state_t state;
-    if (servo42c_get_state(&state) == ESP_OK && !state.is_moving) {
+    if (servo42c_get_state(ui_axis, &state) == ESP_OK && !state.is_moving) {
         ui_show_screen(SCREEN_MAIN);
     }
 }
 
-void ui_manual_init(void) {
+lv_obj_t* ui_manual_create(void) {
     manual_screen = lv_obj_create(NULL);
     
     // Step size dropdown
@@ -61,18 +78,20 @@ void ui_manual_init(void) {
         "0.50mm\n"
         "1.00mm\n"
         "5.00mm");
+    lv_dropdown_set_selected(step_size_dd, saved.step_index);
     lv_obj_align(step_size_dd, LV_ALIGN_TOP_MID, 0, 50);
+    lv_obj_add_event_cb(step_size_dd, step_size_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
     
     // Speed control
     speed_slider = lv_slider_create(manual_screen);
     lv_obj_set_size(speed_slider, 200, 20);
     lv_obj_align(speed_slider, LV_ALIGN_TOP_MID, 0, 100);
     lv_slider_set_range(speed_slider, 0, 100);
-    lv_slider_set_value(speed_slider, current_speed, LV_ANIM_OFF);
+    lv_slider_set_value(speed_slider, lroundf(settings_get()->jog_speed), LV_ANIM_OFF);
     lv_obj_add_event_cb(speed_slider, speed_slider_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
     
     lv_obj_t* label = lv_label_create(speed_slider);
-    lv_label_set_text(label, "Speed: 50%");
+    update_speed_label();
     lv_obj_align_to(label, speed_slider, LV_ALIGN_OUT_BOTTOM_MID, 0, 5);
     
     // Jog buttons
@@ -104,4 +123,6 @@ void ui_manual_init(void) {
     lv_obj_center(label);
     
     lv_obj_add_event_cb(return_btn, return_btn_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    return manual_screen;
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "ui_common.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+
+// UI model: any task publishes values into these mailboxes without
+// touching LVGL; the LVGL task picks them up once per refresh in
+// ui_process_updates() and only redraws what actually changed.
+
+#define UI_TEXT_LEN 64
+
+// Latest-value text slot. Writers serialize on the spinlock and bump
+// seq around the copy (odd while writing); the reader retries on a torn
+// copy instead of blocking a publisher.
+typedef struct {
+    atomic_uint seq;
+    portMUX_TYPE lock;
+    char text[UI_TEXT_LEN];
+} text_mailbox_t;
+
+static atomic_uint position_bits;      // float, stored as its bit pattern
+static text_mailbox_t status_box = { .lock = portMUX_INITIALIZER_UNLOCKED };
+static text_mailbox_t error_box = { .lock = portMUX_INITIALIZER_UNLOCKED };
+
+// What the screen shows now; LVGL task only
+static struct {
+    int32_t position_centi_mm;
+    bool position_valid;
+    unsigned int status_seq;
+    char status[UI_TEXT_LEN];
+    unsigned int error_seq;
+} shown;
+
+static void text_publish(text_mailbox_t* box, const char* text) {
+    portENTER_CRITICAL(&box->lock);
+    atomic_fetch_add_explicit(&box->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    strncpy(box->text, text ? text : "", UI_TEXT_LEN - 1);
+    box->text[UI_TEXT_LEN - 1] = '\0';
+    atomic_fetch_add_explicit(&box->seq, 1, memory_order_release);
+    portEXIT_CRITICAL(&box->lock);
+}
+
+// Copy the text if it was published since `last_seq`; returns the new seq
+static bool text_take(text_mailbox_t* box, unsigned int* last_seq, char* out) {
+    unsigned int begin, end;
+
+    do {
+        begin = atomic_load_explicit(&box->seq, memory_order_acquire);
+        if (begin == *last_seq) {
+            return false;
+        }
+        if (begin & 1) {
+            continue;
+        }
+        memcpy(out, box->text, UI_TEXT_LEN);
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&box->seq, memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
+
+    out[UI_TEXT_LEN - 1] = '\0';
+    *last_seq = begin;
+    return true;
+}
+
+void ui_update_position(float position) {
+    uint32_t bits;
+    memcpy(&bits, &position, sizeof(bits));
+    atomic_store_explicit(&position_bits, bits, memory_order_relaxed);
+}
+
+void ui_update_status(const char* status) {
+    text_publish(&status_box, status);
+}
+
+void ui_show_error(const char* message) {
+    text_publish(&error_box, message);
+}
+
+void ui_process_updates(void) {
+    char text[UI_TEXT_LEN];
+
+    // Position is shown with two decimals; anything finer is no change
+    uint32_t bits = atomic_load_explicit(&position_bits, memory_order_relaxed);
+    float position;
+    memcpy(&position, &bits, sizeof(position));
+    int32_t centi_mm = (int32_t)lroundf(position * 100.0f);
+    if (!shown.position_valid || centi_mm != shown.position_centi_mm) {
+        shown.position_centi_mm = centi_mm;
+        shown.position_valid = true;
+        ui_apply_position(position);
+    }
+
+    // Status is a state: republishing the same text changes nothing
+    if (text_take(&status_box, &shown.status_seq, text) && strcmp(text, shown.status) != 0) {
+        memcpy(shown.status, text, UI_TEXT_LEN);
+        ui_apply_status(text);
+    }
+
+    // Errors are events: every publish (re)shows the popup, but several
+    // publishes between two refreshes show only the latest
+    if (text_take(&error_box, &shown.error_seq, text)) {
+        ui_apply_error(text);
+    }
+}
@@ -0,0 +1,119 @@
+#include "ui_common.h"
+#include "lv_alloc.h"
+#include "esp_log.h"
+
+static const char* TAG = "ui_screens";
+
+#define SCREEN_COST_GUESS (8U * 1024U)  // bytes, until a screen has been built once
+
+typedef struct {
+    const char* name;
+    lv_obj_t* (*create)(void);
+    bool pinned;            // built once, never evicted
+    lv_obj_t* screen;       // NULL while not built
+    size_t cost;            // LVGL heap the last build took
+    lv_alloc_arena_t* arena;    // holds what the build allocates, NULL if pinned or none left
+    uint32_t last_shown;    // LRU stamp
+} screen_slot_t;
+
+static screen_slot_t slots[SCREEN_COUNT] = {
+    [SCREEN_MAIN]        = { "main", ui_main_create, true },
+    [SCREEN_MANUAL]      = { "manual", ui_manual_create },
+    [SCREEN_AUTO]        = { "auto", ui_auto_create },
+    [SCREEN_CALIBRATION] = { "calibration", ui_calibration_create },
+    [SCREEN_DIAGNOSTICS] = { "diagnostics", ui_diagnostics_create },
+};
+
+static uint32_t show_count;
+
+static size_t heap_used(void) {
+    lv_alloc_stats_t stats;
+    lv_alloc_get_stats(&stats);
+    return stats.used;
+}
+
+static size_t cached_bytes(void) {
+    size_t total = 0;
+    for (int id = 0; id < SCREEN_COUNT; id++) {
+        if (slots[id].screen && !slots[id].pinned) {
+            total += slots[id].cost;
+        }
+    }
+    return total;
+}
+
+// Least recently shown screen that may go, -1 if none
+static int lru_victim(screen_id_t keep) {
+    int victim = -1;
+    for (int id = 0; id < SCREEN_COUNT; id++) {
+        const screen_slot_t* slot = &slots[id];
+        if (id == (int)keep || !slot->screen || slot->pinned) {
+            continue;
+        }
+        if (victim < 0 || slot->last_shown < slots[victim].last_shown) {
+            victim = id;
+        }
+    }
+    return victim;
+}
+
+static void evict(int id) {
+    screen_slot_t* slot = &slots[id];
+    ESP_LOGD(TAG, "Evicting %s screen (%u bytes)", slot->name, (unsigned int)slot->cost);
+
+    // The screen being left is usually the one whose button asked for the
+    // new screen: delete it only after that event handler has returned
+    if (slot->screen == lv_scr_act()) {
+        lv_obj_del_async(slot->screen);
+    } else {
+        lv_obj_del(slot->screen);
+    }
+    slot->screen = NULL;
+}
+
+static void make_room(screen_id_t keep, size_t needed) {
+    while (cached_bytes() + needed > UI_SCREEN_CACHE_BUDGET) {
+        int victim = lru_victim(keep);
+        if (victim < 0) {
+            break;
+        }
+        evict(victim);
+    }
+}
+
+void ui_show_screen(screen_id_t id) {
+    if ((unsigned int)id >= SCREEN_COUNT) {
+        ESP_LOGW(TAG, "Unknown screen ID: %d", id);
+        return;
+    }
+
+    screen_slot_t* slot = &slots[id];
+    if (!slot->screen) {
+        if (!slot->pinned) {
+            make_room(id, slot->cost ? slot->cost : SCREEN_COST_GUESS);
+        }
+        // Evicting the screen then hands its whole arena back at once
+        // instead of leaving holes between longer-lived blocks
+        if (!slot->pinned && !slot->arena) {
+            slot->arena = lv_alloc_arena_create(slot->name);
+        }
+        size_t before = heap_used();
+        if (slot->arena) {
+            lv_alloc_arena_begin(slot->arena);
+        }
+        slot->screen = slot->create();
+        if (slot->arena) {
+            lv_alloc_arena_end();
+        }
+        size_t after = heap_used();
+        slot->cost = after > before ? after - before : 0;
+        ESP_LOGD(TAG, "Built %s screen (%u bytes)", slot->name, (unsigned int)slot->cost);
+        // The guess may have been low
+        if (!slot->pinned) {
+            make_room(id, 0);
+        }
+    }
+
+    slot->last_shown = ++show_count;
+    lv_scr_load(slot->screen);
+}